@@ -70,28 +70,45 @@ SOURCES += \
     backend/nvhttp.cpp \
     backend/nvpairingmanager.cpp \
     backend/computermanager.cpp \
+    backend/hoststore.cpp \
+    backend/mdnshostcache.cpp \
+    backend/pollingscheduler.cpp \
     backend/boxartmanager.cpp \
+    backend/boxartcache.cpp \
     backend/richpresencemanager.cpp \
     cli/commandlineparser.cpp \
     cli/listapps.cpp \
+    cli/benchmarkaudio.cpp \
+    cli/benchmarkserverinfo.cpp \
     cli/quitstream.cpp \
+    cli/replayinput.cpp \
     cli/startstream.cpp \
     settings/compatfetcher.cpp \
     settings/mappingfetcher.cpp \
     settings/streamingpreferences.cpp \
     streaming/input/abstouch.cpp \
+    streaming/input/dispatcher.cpp \
     streaming/input/gamepad.cpp \
     streaming/input/input.cpp \
     streaming/input/keyboard.cpp \
+    streaming/input/latencystats.cpp \
     streaming/input/mouse.cpp \
+    streaming/input/recorder.cpp \
     streaming/input/reltouch.cpp \
+    streaming/input/textpaster.cpp \
     streaming/session.cpp \
+    streaming/startupprofiler.cpp \
     streaming/audio/audio.cpp \
+    streaming/audio/opusbench.cpp \
     streaming/audio/renderers/sdlaud.cpp \
+    streaming/audio/renderers/nullaud.cpp \
+    streaming/audio/renderers/wavaud.cpp \
     gui/computermodel.cpp \
     gui/appmodel.cpp \
+    gui/boxartimageprovider.cpp \
     streaming/bandwidth.cpp \
     streaming/streamutils.cpp \
+    logger.cpp \
     path.cpp \
     settings/mappingmanager.cpp \
     gui/sdlgamepadkeynavigation.cpp \
@@ -113,22 +130,39 @@ HEADERS += \
     backend/nvhttp.h \
     backend/nvpairingmanager.h \
     backend/computermanager.h \
+    backend/hoststore.h \
+    backend/mdnshostcache.h \
+    backend/pollingscheduler.h \
     backend/boxartmanager.h \
+    backend/boxartcache.h \
     backend/richpresencemanager.h \
     cli/commandlineparser.h \
     cli/listapps.h \
+    cli/benchmarkaudio.h \
+    cli/benchmarkserverinfo.h \
     cli/quitstream.h \
+    cli/replayinput.h \
     cli/startstream.h \
     settings/streamingpreferences.h \
+    streaming/input/dispatcher.h \
     streaming/input/input.h \
+    streaming/input/latencystats.h \
+    streaming/input/recorder.h \
+    streaming/input/textpaster.h \
     streaming/session.h \
+    streaming/startupprofiler.h \
+    streaming/audio/opusbench.h \
     streaming/audio/renderers/renderer.h \
     streaming/audio/renderers/sdl.h \
+    streaming/audio/renderers/null.h \
+    streaming/audio/renderers/wav.h \
     gui/computermodel.h \
     gui/appmodel.h \
+    gui/boxartimageprovider.h \
     streaming/video/decoder.h \
     streaming/bandwidth.h \
     streaming/streamutils.h \
+    logger.h \
     path.h \
     settings/mappingmanager.h \
     gui/sdlgamepadkeynavigation.h \
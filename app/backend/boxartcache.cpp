@@ -0,0 +1,294 @@
+#include "boxartcache.h"
+#include "../path.h"
+#include "../utils.h"
+
+#include <QGuiApplication>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QSaveFile>
+#include <QtDebug>
+
+// Enough for a couple hundred thumbnails at 1x scaling
+#define DEFAULT_MEMORY_CACHE_MB 48
+
+#define PLACEHOLDER_TEXT_KEY "Placeholder"
+
+BoxArtCache* BoxArtCache::s_Cache = nullptr;
+
+static
+bool
+isPlaceholderSize(const QSize& size)
+{
+    // AppView.qml lays out the running app overlay differently for placeholders
+    return size == QSize(130, 180) || // GFE 2.0 placeholder image
+           size == QSize(628, 888) || // GFE 3.0 placeholder image
+           size == QSize(200, 266);   // Our no_app_image.png
+}
+
+void
+BoxArtCache::initialize()
+{
+    Q_ASSERT(s_Cache == nullptr);
+    s_Cache = new BoxArtCache();
+}
+
+BoxArtCache*
+BoxArtCache::get()
+{
+    Q_ASSERT(s_Cache != nullptr);
+    return s_Cache;
+}
+
+BoxArtCache::BoxArtCache()
+    : m_BoxArtDir(Path::getBoxArtCacheDir())
+{
+    int memoryCacheMb = DEFAULT_MEMORY_CACHE_MB;
+    qreal devicePixelRatio = qGuiApp != nullptr ? qGuiApp->devicePixelRatio() : 1.0;
+
+    Utils::getEnvironmentVariableOverride("BOXART_MEMORY_CACHE_MB", &memoryCacheMb);
+
+    // Cost is tracked in KB
+    m_MemoryCache.setMaxCost(memoryCacheMb * 1024);
+
+    // Scale thumbnails up for high DPI displays so they stay sharp
+    m_ThumbnailSize = QSize(qRound(BOXART_DISPLAY_WIDTH * qMax(devicePixelRatio, 1.0)),
+                            qRound(BOXART_DISPLAY_HEIGHT * qMax(devicePixelRatio, 1.0)));
+
+    if (!m_BoxArtDir.exists()) {
+        m_BoxArtDir.mkpath(".");
+    }
+}
+
+QString
+BoxArtCache::getCacheKey(const QString& uuid, int appId)
+{
+    return uuid + "/" + QString::number(appId);
+}
+
+QString
+BoxArtCache::getFilePath(const QString& uuid, int appId)
+{
+    QDir dir = m_BoxArtDir;
+
+    // Create the cache directory if it did not already exist
+    if (!dir.exists(uuid)) {
+        dir.mkdir(uuid);
+    }
+
+    // Change to this computer's box art cache folder
+    dir.cd(uuid);
+
+    // The thumbnail size is part of the name so we don't use thumbnails
+    // scaled for a display with a different DPI than this one.
+    return dir.filePath(QString("%1-%2x%3.png")
+                        .arg(appId)
+                        .arg(m_ThumbnailSize.width())
+                        .arg(m_ThumbnailSize.height()));
+}
+
+QString
+BoxArtCache::getLegacyFilePath(const QString& uuid, int appId)
+{
+    // Older versions cached the full-size box art as <appId>.png
+    return m_BoxArtDir.filePath(uuid + "/" + QString::number(appId) + ".png");
+}
+
+QImage
+BoxArtCache::createThumbnail(const QImage& image)
+{
+    // AppView.qml stretches box art to fill the tile, so we do the same here. Premultiplied
+    // alpha is what the scene graph uploads, so it won't have to convert it again.
+    return image.scaled(m_ThumbnailSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+}
+
+void
+BoxArtCache::cacheInMemory(const QString& key, const QImage& thumbnail, bool placeholder)
+{
+    QMutexLocker lock(&m_Lock);
+
+    m_MemoryCache.insert(key, new QImage(thumbnail),
+                         qMax(1, (int)(((qint64)thumbnail.bytesPerLine() * thumbnail.height()) / 1024)));
+    m_Placeholders.insert(key, placeholder);
+    m_MissingBoxArt.remove(key);
+}
+
+bool
+BoxArtCache::writeThumbnail(const QString& path, const QImage& thumbnail, bool placeholder)
+{
+    // Write to a temporary file and rename it into place, so a reader
+    // never sees a partially written thumbnail
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to open box art cache file:" << path << file.errorString();
+        return false;
+    }
+
+    QImageWriter writer(&file, "png");
+    writer.setText(PLACEHOLDER_TEXT_KEY, placeholder ? "1" : "0");
+    if (!writer.write(thumbnail)) {
+        qWarning() << "Failed to write box art cache file:" << path << writer.errorString();
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+
+bool
+BoxArtCache::contains(const QString& uuid, int appId)
+{
+    QString key = getCacheKey(uuid, appId);
+
+    {
+        QMutexLocker lock(&m_Lock);
+        if (m_MemoryCache.contains(key)) {
+            return true;
+        }
+        else if (m_MissingBoxArt.contains(key)) {
+            // Nothing has been inserted since we last looked
+            return false;
+        }
+    }
+
+    if (QFile::exists(getFilePath(uuid, appId))) {
+        return true;
+    }
+
+    QFile legacyFile(getLegacyFilePath(uuid, appId));
+    if (legacyFile.exists() && legacyFile.size() > 0) {
+        return true;
+    }
+
+    // It may have been inserted while we were looking
+    QMutexLocker lock(&m_Lock);
+    if (m_MemoryCache.contains(key)) {
+        return true;
+    }
+
+    m_MissingBoxArt.insert(key);
+    return false;
+}
+
+QImage
+BoxArtCache::load(const QString& uuid, int appId)
+{
+    QString key = getCacheKey(uuid, appId);
+
+    {
+        QMutexLocker lock(&m_Lock);
+        QImage* cachedImage = m_MemoryCache.object(key);
+        if (cachedImage != nullptr) {
+            return *cachedImage;
+        }
+    }
+
+    // Decode from disk without holding the lock
+    QImageReader reader(getFilePath(uuid, appId));
+    QImage thumbnail = reader.read();
+    bool placeholder;
+
+    if (!thumbnail.isNull()) {
+        placeholder = reader.text(PLACEHOLDER_TEXT_KEY) == "1";
+    }
+    else {
+        // Convert full-size box art cached by older versions once,
+        // then we can get rid of the original.
+        QString legacyPath = getLegacyFilePath(uuid, appId);
+        QImage image(legacyPath);
+        if (image.isNull()) {
+            return QImage();
+        }
+
+        placeholder = isPlaceholderSize(image.size());
+        thumbnail = createThumbnail(image);
+        if (writeThumbnail(getFilePath(uuid, appId), thumbnail, placeholder)) {
+            QFile::remove(legacyPath);
+        }
+    }
+
+    bool placeholderWasKnown;
+    {
+        QMutexLocker lock(&m_Lock);
+        placeholderWasKnown = m_Placeholders.contains(key);
+    }
+
+    cacheInMemory(key, thumbnail, placeholder);
+
+    // isPlaceholder() assumed this wasn't a placeholder until now
+    if (placeholder && !placeholderWasKnown) {
+        emit placeholderLoaded(uuid, appId);
+    }
+
+    return thumbnail;
+}
+
+bool
+BoxArtCache::insert(const QString& uuid, int appId, const QImage& image)
+{
+    if (image.isNull()) {
+        return false;
+    }
+
+    bool placeholder = isPlaceholderSize(image.size());
+    QImage thumbnail = createThumbnail(image);
+
+    // Even if we can't write it to disk, we can still show it this session
+    if (writeThumbnail(getFilePath(uuid, appId), thumbnail, placeholder)) {
+        QFile::remove(getLegacyFilePath(uuid, appId));
+    }
+
+    cacheInMemory(getCacheKey(uuid, appId), thumbnail, placeholder);
+    return true;
+}
+
+bool
+BoxArtCache::isPlaceholder(const QString& uuid, int appId)
+{
+    QString key = getCacheKey(uuid, appId);
+    QMutexLocker lock(&m_Lock);
+
+    if (m_MissingBoxArt.contains(key)) {
+        return true;
+    }
+
+    // Only known once load() or insert() has seen the image
+    return m_Placeholders.value(key, false);
+}
+
+void
+BoxArtCache::remove(const QString& uuid)
+{
+    QMutexLocker lock(&m_Lock);
+    QString prefix = uuid + "/";
+
+    for (const QString& key : m_MemoryCache.keys()) {
+        if (key.startsWith(prefix)) {
+            m_MemoryCache.remove(key);
+        }
+    }
+
+    for (auto it = m_Placeholders.begin(); it != m_Placeholders.end();) {
+        if (it.key().startsWith(prefix)) {
+            it = m_Placeholders.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    for (auto it = m_MissingBoxArt.begin(); it != m_MissingBoxArt.end();) {
+        if (it->startsWith(prefix)) {
+            it = m_MissingBoxArt.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    // Delete everything in this computer's box art directory
+    QDir dir = m_BoxArtDir;
+    if (dir.cd(uuid)) {
+        dir.removeRecursively();
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <QCache>
+#include <QDir>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+
+// Box art is displayed at this size in AppView.qml
+#define BOXART_DISPLAY_WIDTH 200
+#define BOXART_DISPLAY_HEIGHT 267
+
+// Caches box art as thumbnails scaled for display, both in memory and on disk.
+// Decoded thumbnails are kept in an LRU so that scrolling back over apps we've
+// already shown never touches the disk, and thumbnails are written to disk so
+// we never have to decode and scale full-size box art more than once.
+//
+// All methods are thread-safe.
+class BoxArtCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Must be called on the main thread after the QGuiApplication
+    // is created and before anything calls get()
+    static
+    void
+    initialize();
+
+    static
+    BoxArtCache*
+    get();
+
+    // Returns true if box art is cached for this app. This doesn't decode it.
+    bool
+    contains(const QString& uuid, int appId);
+
+    // Returns the cached thumbnail, or a null image if there isn't one
+    QImage
+    load(const QString& uuid, int appId);
+
+    // Scales the box art to a thumbnail and caches it in memory and on disk
+    bool
+    insert(const QString& uuid, int appId, const QImage& image);
+
+    // Returns true if the cached box art is a generic placeholder image
+    // or we have no box art cached for this app at all. This never touches
+    // the disk, so it returns false for box art that hasn't been loaded yet
+    // and emits placeholderLoaded() if load() later finds out otherwise.
+    bool
+    isPlaceholder(const QString& uuid, int appId);
+
+    // Evicts all box art for this host from both caches
+    void
+    remove(const QString& uuid);
+
+    QString
+    getFilePath(const QString& uuid, int appId);
+
+signals:
+    void
+    placeholderLoaded(const QString& uuid, int appId);
+
+private:
+    BoxArtCache();
+
+    static
+    QString
+    getCacheKey(const QString& uuid, int appId);
+
+    QString
+    getLegacyFilePath(const QString& uuid, int appId);
+
+    QImage
+    createThumbnail(const QImage& image);
+
+    void
+    cacheInMemory(const QString& key, const QImage& thumbnail, bool placeholder);
+
+    bool
+    writeThumbnail(const QString& path, const QImage& thumbnail, bool placeholder);
+
+    QMutex m_Lock;
+    QDir m_BoxArtDir;
+    QSize m_ThumbnailSize;
+    QCache<QString, QImage> m_MemoryCache;
+    QHash<QString, bool> m_Placeholders;
+    QSet<QString> m_MissingBoxArt;
+
+    static BoxArtCache* s_Cache;
+};
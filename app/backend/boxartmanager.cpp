@@ -1,39 +1,73 @@
 #include "boxartmanager.h"
-#include "../path.h"
+#include "boxartcache.h"
+#include "../utils.h"
 
-#include <QImageReader>
-#include <QImageWriter>
+#include <QTimer>
+
+// 4 is a good balance between fast loading for large
+// app grids and not crushing GFE with tons of requests
+// and causing UI jank from constantly stalling to decode
+// new images.
+#define MAX_FETCH_THREADS 4
+#define DEFAULT_MAX_FETCHES_PER_HOST 4
+
+QHash<QString, int> BoxArtManager::s_ActiveFetchesPerHost;
+QList<BoxArtManager*> BoxArtManager::s_Managers;
 
 BoxArtManager::BoxArtManager(QObject *parent) :
     QObject(parent),
-    m_BoxArtDir(Path::getBoxArtCacheDir()),
-    m_ThreadPool(this)
+    m_ThreadPool(this),
+    m_DispatchPending(false),
+    m_MaxFetchesPerHost(DEFAULT_MAX_FETCHES_PER_HOST),
+    m_CacheHits(0),
+    m_CacheMisses(0),
+    m_FetchesCompleted(0),
+    m_FetchesFailed(0),
+    m_FetchesCancelled(0),
+    m_TotalFetchTimeMs(0),
+    m_MaxFetchTimeMs(0)
 {
-    // 4 is a good balance between fast loading for large
-    // app grids and not crushing GFE with tons of requests
-    // and causing UI jank from constantly stalling to decode
-    // new images.
-    m_ThreadPool.setMaxThreadCount(4);
-    if (!m_BoxArtDir.exists()) {
-        m_BoxArtDir.mkpath(".");
-    }
+    m_ThreadPool.setMaxThreadCount(MAX_FETCH_THREADS);
+
+    Utils::getEnvironmentVariableOverride("BOXART_MAX_FETCHES_PER_HOST", &m_MaxFetchesPerHost);
+
+    connect(BoxArtCache::get(), &BoxArtCache::placeholderLoaded,
+            this, &BoxArtManager::boxArtPlaceholderLoaded);
+
+    s_Managers.append(this);
 }
 
-QString
-BoxArtManager::getFilePathForBoxArt(NvComputer* computer, int appId)
+BoxArtManager::~BoxArtManager()
 {
-    QDir dir = m_BoxArtDir;
+    s_Managers.removeOne(this);
 
-    // Create the cache directory if it did not already exist
-    if (!dir.exists(computer->uuid)) {
-        dir.mkdir(computer->uuid);
+    // Let fetches in progress finish so they don't count against their host anymore
+    m_FetchesCancelled += m_QueuedFetches.count();
+    m_QueuedFetches.clear();
+    m_ThreadPool.waitForDone();
+    for (const BoxArtFetch& fetch : m_ActiveFetches) {
+        s_ActiveFetchesPerHost[fetch.computer->uuid]--;
+    }
+    for (BoxArtManager* manager : s_Managers) {
+        manager->dispatchFetches();
     }
 
-    // Change to this computer's box art cache folder
-    dir.cd(computer->uuid);
+    if (m_CacheHits + m_CacheMisses > 0) {
+        qInfo().nospace() << "Box art: " << m_CacheHits << " cache hits, "
+                          << m_CacheMisses << " misses, "
+                          << m_FetchesCompleted << " fetched (avg "
+                          << (m_FetchesCompleted > 0 ? m_TotalFetchTimeMs / m_FetchesCompleted : 0)
+                          << " ms, max " << m_MaxFetchTimeMs << " ms), "
+                          << m_FetchesFailed << " failed, "
+                          << m_FetchesCancelled << " cancelled";
+    }
+}
 
-    // Try to open the cached file
-    return dir.filePath(QString::number(appId) + ".png");
+QUrl
+BoxArtManager::getBoxArtUrl(NvComputer* computer, int appId)
+{
+    // Served by BoxArtImageProvider
+    return QUrl("image://boxart/" + computer->uuid + "/" + QString::number(appId));
 }
 
 class NetworkBoxArtLoadTask : public QObject, public QRunnable
@@ -69,60 +103,178 @@ private:
     NvApp m_App;
 };
 
+int BoxArtManager::findFetch(const QList<BoxArtFetch>& fetches, NvComputer* computer, int appId)
+{
+    for (int i = 0; i < fetches.count(); i++) {
+        if (fetches[i].computer == computer && fetches[i].app.id == appId) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
 QUrl BoxArtManager::loadBoxArt(NvComputer* computer, NvApp& app)
 {
-    // Try to open the cached file if it exists and contains data
-    QFile cacheFile(getFilePathForBoxArt(computer, app.id));
-    if (cacheFile.exists() && cacheFile.size() > 0) {
-        return QUrl::fromLocalFile(cacheFile.fileName());
+    bool cached = BoxArtCache::get()->contains(computer->uuid, app.id);
+
+    // The view asks again whenever it re-evaluates its bindings, including
+    // after a fetch completes, so only count the first lookup for each app.
+    QString appKey = computer->uuid + "/" + QString::number(app.id);
+    if (!m_LookedUpApps.contains(appKey)) {
+        m_LookedUpApps.insert(appKey);
+        if (cached) {
+            m_CacheHits++;
+        }
+        else {
+            m_CacheMisses++;
+        }
     }
 
-    // If we get here, we need to fetch asynchronously.
-    // Kick off a worker on our thread pool to do just that.
-    NetworkBoxArtLoadTask* netLoadTask = new NetworkBoxArtLoadTask(this, computer, app);
-    m_ThreadPool.start(netLoadTask);
+    // If it's cached, the image provider will load it from the cache
+    if (cached) {
+        return getBoxArtUrl(computer, app.id);
+    }
+
+    // If we get here, we need to fetch asynchronously. Queue it and
+    // dispatch after the view is done requesting box art for this frame,
+    // so we know which of the requests are actually on screen.
+    if (findFetch(m_QueuedFetches, computer, app.id) < 0 &&
+            findFetch(m_ActiveFetches, computer, app.id) < 0) {
+        BoxArtFetch fetch;
+        fetch.computer = computer;
+        fetch.app = app;
+        fetch.onScreen = true;
+        m_QueuedFetches.append(fetch);
+
+        if (!m_DispatchPending) {
+            m_DispatchPending = true;
+            QTimer::singleShot(0, this, &BoxArtManager::dispatchFetches);
+        }
+    }
 
     // Return the placeholder then we can notify the caller
     // later when the real image is ready.
     return QUrl("qrc:/res/no_app_image.png");
 }
 
-void BoxArtManager::deleteBoxArt(NvComputer* computer)
+void BoxArtManager::setBoxArtOnScreen(NvComputer* computer, int appId, bool onScreen)
+{
+    int index = findFetch(m_QueuedFetches, computer, appId);
+    if (index >= 0) {
+        m_QueuedFetches[index].onScreen = onScreen;
+    }
+}
+
+void BoxArtManager::cancelBoxArt(NvComputer* computer, int appId)
+{
+    int index = findFetch(m_QueuedFetches, computer, appId);
+    if (index >= 0) {
+        m_QueuedFetches.removeAt(index);
+        m_FetchesCancelled++;
+    }
+}
+
+void BoxArtManager::dispatchFetches()
 {
-    QDir dir(Path::getBoxArtCacheDir());
+    m_DispatchPending = false;
+
+    while (m_ActiveFetches.count() < MAX_FETCH_THREADS) {
+        int next = -1;
+
+        // Take the oldest on screen request whose host isn't busy, falling
+        // back to the oldest off screen one if there aren't any.
+        for (int i = 0; i < m_QueuedFetches.count(); i++) {
+            const BoxArtFetch& fetch = m_QueuedFetches[i];
+            if (s_ActiveFetchesPerHost.value(fetch.computer->uuid) >= m_MaxFetchesPerHost) {
+                continue;
+            }
+            if (fetch.onScreen) {
+                next = i;
+                break;
+            }
+            else if (next < 0) {
+                next = i;
+            }
+        }
+
+        if (next < 0) {
+            break;
+        }
+
+        BoxArtFetch fetch = m_QueuedFetches.takeAt(next);
+        fetch.timer.start();
+        s_ActiveFetchesPerHost[fetch.computer->uuid]++;
+        m_ActiveFetches.append(fetch);
 
-    // Delete everything in this computer's box art directory
-    if (dir.cd(computer->uuid)) {
-        dir.removeRecursively();
+        m_ThreadPool.start(new NetworkBoxArtLoadTask(this, fetch.computer, fetch.app));
     }
 }
 
+QUrl BoxArtManager::loadBoxArtFile(NvComputer* computer, NvApp& app)
+{
+    QUrl image = loadBoxArt(computer, app);
+    if (image.scheme() != "image") {
+        return image;
+    }
+
+    // Loading it makes sure any box art cached by older versions
+    // has been converted to a thumbnail on disk.
+    BoxArtCache::get()->load(computer->uuid, app.id);
+    return QUrl::fromLocalFile(BoxArtCache::get()->getFilePath(computer->uuid, app.id));
+}
+
+bool BoxArtManager::isBoxArtPlaceholder(NvComputer* computer, const NvApp& app)
+{
+    return BoxArtCache::get()->isPlaceholder(computer->uuid, app.id);
+}
+
+void BoxArtManager::deleteBoxArt(NvComputer* computer)
+{
+    BoxArtCache::get()->remove(computer->uuid);
+}
+
 void BoxArtManager::handleBoxArtLoadComplete(NvComputer* computer, NvApp app, QUrl image)
 {
+    int index = findFetch(m_ActiveFetches, computer, app.id);
+    if (index >= 0) {
+        qint64 fetchTimeMs = m_ActiveFetches[index].timer.elapsed();
+
+        if (!image.isEmpty()) {
+            m_FetchesCompleted++;
+            m_TotalFetchTimeMs += fetchTimeMs;
+            m_MaxFetchTimeMs = qMax(m_MaxFetchTimeMs, fetchTimeMs);
+        }
+        else {
+            m_FetchesFailed++;
+        }
+
+        s_ActiveFetchesPerHost[computer->uuid]--;
+        m_ActiveFetches.removeAt(index);
+    }
+
     if (!image.isEmpty()) {
         emit boxArtLoadComplete(computer, app, image);
     }
+
+    // Any manager may have been waiting for a fetch to this host to finish
+    for (BoxArtManager* manager : s_Managers) {
+        manager->dispatchFetches();
+    }
 }
 
 QUrl BoxArtManager::loadBoxArtFromNetwork(NvComputer* computer, int appId)
 {
     NvHTTP http(computer);
 
-    QString cachePath = getFilePathForBoxArt(computer, appId);
     QImage image;
     try {
         image = http.getBoxArt(appId);
     } catch (...) {}
 
-    // Cache the box art on disk if it loaded
-    if (!image.isNull()) {
-        if (image.save(cachePath)) {
-            return QUrl::fromLocalFile(cachePath);
-        }
-        else {
-            // A failed save() may leave a zero byte file. Make sure that's removed.
-            QFile(cachePath).remove();
-        }
+    // Cache a thumbnail of the box art if it loaded
+    if (BoxArtCache::get()->insert(computer->uuid, appId, image)) {
+        return getBoxArtUrl(computer, appId);
     }
 
     return QUrl();
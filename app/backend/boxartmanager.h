@@ -1,8 +1,11 @@
 #pragma once
 
 #include "computermanager.h"
-#include <QDir>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QImage>
+#include <QList>
+#include <QSet>
 #include <QThreadPool>
 #include <QRunnable>
 
@@ -15,9 +18,29 @@ class BoxArtManager : public QObject
 public:
     explicit BoxArtManager(QObject *parent = nullptr);
 
+    ~BoxArtManager();
+
     QUrl
     loadBoxArt(NvComputer* computer, NvApp& app);
 
+    // Like loadBoxArt(), but returns the cached thumbnail as a file
+    // URL rather than a URL for the QML image provider
+    QUrl
+    loadBoxArtFile(NvComputer* computer, NvApp& app);
+
+    bool
+    isBoxArtPlaceholder(NvComputer* computer, const NvApp& app);
+
+    // Box art for apps on screen is fetched before apps that are only
+    // loaded in the grid's cache buffer. Apps are assumed to be on
+    // screen when their box art is first requested.
+    void
+    setBoxArtOnScreen(NvComputer* computer, int appId, bool onScreen);
+
+    // Drops a queued fetch, if there is one. Fetches in progress finish.
+    void
+    cancelBoxArt(NvComputer* computer, int appId);
+
     static
     void
     deleteBoxArt(NvComputer* computer);
@@ -26,19 +49,57 @@ signals:
     void
     boxArtLoadComplete(NvComputer* computer, NvApp app, QUrl image);
 
+    // Box art that was already cached turned out to be a placeholder
+    void
+    boxArtPlaceholderLoaded(QString uuid, int appId);
+
 public slots:
 
 private slots:
     void
     handleBoxArtLoadComplete(NvComputer* computer, NvApp app, QUrl image);
 
+    void
+    dispatchFetches();
+
 private:
+    struct BoxArtFetch {
+        NvComputer* computer;
+        NvApp app;
+        bool onScreen;
+        QElapsedTimer timer;
+    };
+
     QUrl
     loadBoxArtFromNetwork(NvComputer* computer, int appId);
 
-    QString
-    getFilePathForBoxArt(NvComputer* computer, int appId);
+    static
+    QUrl
+    getBoxArtUrl(NvComputer* computer, int appId);
+
+    static
+    int
+    findFetch(const QList<BoxArtFetch>& fetches, NvComputer* computer, int appId);
 
-    QDir m_BoxArtDir;
     QThreadPool m_ThreadPool;
+    QList<BoxArtFetch> m_QueuedFetches;
+    QList<BoxArtFetch> m_ActiveFetches;
+    bool m_DispatchPending;
+    int m_MaxFetchesPerHost;
+
+    // Keyed by computer UUID and app ID. An app's first lookup decides
+    // whether it counts as a hit or a miss, so box art that we fetched
+    // and then served from the cache isn't counted as a hit too.
+    QSet<QString> m_LookedUpApps;
+    int m_CacheHits;
+    int m_CacheMisses;
+    int m_FetchesCompleted;
+    int m_FetchesFailed;
+    int m_FetchesCancelled;
+    qint64 m_TotalFetchTimeMs;
+    qint64 m_MaxFetchTimeMs;
+
+    // Shared by all instances on the main thread, since there's one per app grid
+    static QHash<QString, int> s_ActiveFetchesPerHost;
+    static QList<BoxArtManager*> s_Managers;
 };
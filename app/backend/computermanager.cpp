@@ -11,153 +11,6 @@
 #include <QCoreApplication>
 #include <QRandomGenerator>
 
-#define SER_HOSTS "hosts"
-#define SER_HOSTS_BACKUP "hostsbackup"
-
-class PcMonitorThread : public QThread
-{
-    Q_OBJECT
-
-#define TRIES_BEFORE_OFFLINING 2
-#define POLLS_PER_APPLIST_FETCH 10
-
-public:
-    PcMonitorThread(NvComputer* computer)
-        : m_Computer(computer)
-    {
-        setObjectName("Polling thread for " + computer->name);
-    }
-
-private:
-    bool tryPollComputer(QNetworkAccessManager* nam, NvAddress address, bool& changed)
-    {
-        NvHTTP http(address, 0, m_Computer->serverCert, nam);
-
-        QString serverInfo;
-        try {
-            serverInfo = http.getServerInfo(NvHTTP::NvLogLevel::NVLL_NONE, true);
-        } catch (...) {
-            return false;
-        }
-
-        NvComputer newState(http, serverInfo);
-
-        // Ensure the machine that responded is the one we intended to contact
-        if (m_Computer->uuid != newState.uuid) {
-            qInfo() << "Found unexpected PC" << newState.name << "looking for" << m_Computer->name;
-            return false;
-        }
-
-        changed = m_Computer->update(newState);
-        return true;
-    }
-
-    bool updateAppList(QNetworkAccessManager* nam, bool& changed)
-    {
-        NvHTTP http(m_Computer, nam);
-
-        QVector<NvApp> appList;
-
-        try {
-            appList = http.getAppList();
-            if (appList.isEmpty()) {
-                return false;
-            }
-        } catch (...) {
-            return false;
-        }
-
-        QWriteLocker lock(&m_Computer->lock);
-        changed = m_Computer->updateAppList(appList);
-        return true;
-    }
-
-    void run() override
-    {
-        // Reduce the power and performance impact of our
-        // computer status polling while it's running.
-        setPriority(QThread::LowPriority);
-#if QT_VERSION >= QT_VERSION_CHECK(6, 9, 0)
-        setServiceLevel(QThread::QualityOfService::Eco);
-#endif
-
-        // Share the QNetworkAccessManager to conserve resources when polling.
-        // Each instance creates a worker thread, so sharing them ensures that
-        // we are not spamming a new thread for every single polling attempt.
-        //
-        // Since QThread inherit the priority of the current thread, this also
-        // ensures that the NAM's worker thread will inherit our lower priority.
-        QNetworkAccessManager nam;
-
-        // Always fetch the applist the first time
-        int pollsSinceLastAppListFetch = POLLS_PER_APPLIST_FETCH;
-        while (!isInterruptionRequested()) {
-            bool stateChanged = false;
-            bool online = false;
-            bool wasOnline = m_Computer->state == NvComputer::CS_ONLINE;
-            for (int i = 0; i < (wasOnline ? TRIES_BEFORE_OFFLINING : 1) && !online; i++) {
-                for (auto& address : m_Computer->uniqueAddresses()) {
-                    if (isInterruptionRequested()) {
-                        return;
-                    }
-
-                    if (tryPollComputer(&nam, address, stateChanged)) {
-                        if (!wasOnline) {
-                            qInfo() << m_Computer->name << "is now online at" << m_Computer->activeAddress.toString();
-                        }
-                        online = true;
-                        break;
-                    }
-                }
-            }
-
-            // Check if we failed after all retry attempts
-            // Note: we don't need to acquire the read lock here,
-            // because we're on the writing thread.
-            if (!online && m_Computer->state != NvComputer::CS_OFFLINE) {
-                qInfo() << m_Computer->name << "is now offline";
-                m_Computer->state = NvComputer::CS_OFFLINE;
-                stateChanged = true;
-            }
-
-            // Grab the applist if it's empty or it's been long enough that we need to refresh
-            pollsSinceLastAppListFetch++;
-            if (m_Computer->state == NvComputer::CS_ONLINE &&
-                    m_Computer->pairState == NvComputer::PS_PAIRED &&
-                    (m_Computer->appList.isEmpty() || pollsSinceLastAppListFetch >= POLLS_PER_APPLIST_FETCH)) {
-                // Notify prior to the app list poll since it may take a while, and we don't
-                // want to delay onlining of a machine, especially if we already have a cached list.
-                if (stateChanged) {
-                    emit computerStateChanged(m_Computer);
-                    stateChanged = false;
-                }
-
-                if (updateAppList(&nam, stateChanged)) {
-                    pollsSinceLastAppListFetch = 0;
-                }
-            }
-
-            if (stateChanged) {
-                // Tell anyone listening that we've changed state
-                emit computerStateChanged(m_Computer);
-            }
-
-            // Wait a bit to poll again, but do it in 100 ms chunks
-            // so we can be interrupted reasonably quickly.
-            // FIXME: QWaitCondition would be better.
-            for (int i = 0; i < 30 && !isInterruptionRequested(); i++) {
-                QThread::msleep(100);
-            }
-        }
-    }
-
-signals:
-   void computerStateChanged(NvComputer* computer);
-
-private:
-    NvComputer* m_Computer;
-};
-
 ComputerManager::ComputerManager(StreamingPreferences* prefs)
     : m_Prefs(prefs),
       m_PollingRef(0),
@@ -165,25 +18,11 @@ ComputerManager::ComputerManager(StreamingPreferences* prefs)
       m_CompatFetcher(nullptr),
       m_NeedsDelayedFlush(false)
 {
-    QSettings settings;
-
-    // If there's a hosts backup copy, we must have failed to commit
-    // a previous update before exiting. Restore the backup now.
-    int hosts = settings.beginReadArray(SER_HOSTS_BACKUP);
-    if (hosts == 0) {
-        // If there's no host backup, read from the primary location.
-        settings.endArray();
-        hosts = settings.beginReadArray(SER_HOSTS);
-    }
-
-    // Inflate our hosts from QSettings
-    for (int i = 0; i < hosts; i++) {
-        settings.setArrayIndex(i);
-        NvComputer* computer = new NvComputer(settings);
+    // Inflate our hosts from the host store
+    for (NvComputer* computer : m_HostStore.load()) {
         m_KnownHosts[computer->uuid] = computer;
         m_LastSerializedHosts[computer->uuid] = *computer;
     }
-    settings.endArray();
 
     // Fetch latest compatibility data asynchronously
     m_CompatFetcher.start();
@@ -192,6 +31,12 @@ ComputerManager::ComputerManager(StreamingPreferences* prefs)
     m_DelayedFlushThread = new DelayedFlushThread(this);
     m_DelayedFlushThread->start();
 
+    // Start the scheduler that polls hosts while polling is active
+    m_PollingScheduler = new PollingScheduler();
+    connect(m_PollingScheduler, &PollingScheduler::computerStateChanged,
+            this, &ComputerManager::handleComputerStateChanged);
+    m_PollingScheduler->start();
+
     // To quit in a timely manner, we must block additional requests
     // after we receive the aboutToQuit() signal. This is necessary
     // because NvHTTP uses aboutToQuit() to abort requests in progress
@@ -229,16 +74,10 @@ ComputerManager::~ComputerManager()
     // Delete the browser to stop discovery
     delete m_MdnsBrowser;
     m_MdnsBrowser = nullptr;
+    m_MdnsHostCache.setServer(nullptr);
 
-    // Interrupt polling
-    for (ComputerPollingEntry* entry : std::as_const(m_PollEntries)) {
-        entry->interrupt();
-    }
-
-    // Delete all polling entries (and associated threads)
-    for (ComputerPollingEntry* entry : std::as_const(m_PollEntries)) {
-        delete entry;
-    }
+    // Stop polling and wait for any polls in progress
+    delete m_PollingScheduler;
 
     // Destroy all NvComputer objects now that polling is halted
     for (NvComputer* computer : std::as_const(m_KnownHosts)) {
@@ -247,6 +86,9 @@ ComputerManager::~ComputerManager()
 }
 
 void DelayedFlushThread::run() {
+    QVector<NvComputer> changedHosts;
+    QStringList deletedHosts;
+
     for (;;) {
         // Wait for a delayed flush request or an interruption
         {
@@ -266,48 +108,46 @@ void DelayedFlushThread::run() {
             // Reset the delayed flush flag to ensure any racing saveHosts() call will set it again
             m_ComputerManager->m_NeedsDelayedFlush = false;
 
-            // Update the last serialized hosts map under the delayed flush mutex
-            m_ComputerManager->m_LastSerializedHosts.clear();
+            // Find the hosts that changed since we last wrote them and update the last
+            // serialized hosts map under the delayed flush mutex. We copy the current state
+            // of each changed NvComputer so we can write it without holding any locks, and
+            // so we can check later if we need to serialize it again when attributes change.
+            QReadLocker lock(&m_ComputerManager->m_Lock);
             for (const NvComputer* computer : std::as_const(m_ComputerManager->m_KnownHosts)) {
-                // Copy the current state of the NvComputer to allow us to check later if we need
-                // to serialize it again when attribute updates occur.
                 QReadLocker computerLock(&computer->lock);
-                m_ComputerManager->m_LastSerializedHosts[computer->uuid] = *computer;
-            }
-        }
-
-        // Perform the flush
-        {
-            QSettings settings;
-
-            // First, write to the backup location
-            settings.beginWriteArray(SER_HOSTS_BACKUP);
-            {
-                QReadLocker lock(&m_ComputerManager->m_Lock);
-                int i = 0;
-                for (const NvComputer* computer : std::as_const(m_ComputerManager->m_KnownHosts)) {
-                    settings.setArrayIndex(i++);
-                    computer->serialize(settings, false);
+                auto it = m_ComputerManager->m_LastSerializedHosts.find(computer->uuid);
+                if (it == m_ComputerManager->m_LastSerializedHosts.end() || !it->isEqualSerialized(*computer)) {
+                    m_ComputerManager->m_LastSerializedHosts[computer->uuid] = *computer;
+                    changedHosts.append(*computer);
                 }
             }
-            settings.endArray();
 
-            // Next, write to the primary location
-            settings.remove(SER_HOSTS);
-            settings.beginWriteArray(SER_HOSTS);
-            {
-                QReadLocker lock(&m_ComputerManager->m_Lock);
-                int i = 0;
-                for (const NvComputer* computer : std::as_const(m_ComputerManager->m_KnownHosts)) {
-                    settings.setArrayIndex(i++);
-                    computer->serialize(settings, true);
+            // Anything we wrote before that isn't known anymore has been deleted
+            for (auto it = m_ComputerManager->m_LastSerializedHosts.begin(); it != m_ComputerManager->m_LastSerializedHosts.end();) {
+                if (!m_ComputerManager->m_KnownHosts.contains(it.key())) {
+                    deletedHosts.append(it.key());
+                    it = m_ComputerManager->m_LastSerializedHosts.erase(it);
+                }
+                else {
+                    ++it;
                 }
             }
-            settings.endArray();
+        }
 
-            // Finally, delete the backup copy
-            settings.remove(SER_HOSTS_BACKUP);
+        // Perform the flush
+        for (const NvComputer& computer : std::as_const(changedHosts)) {
+            if (!m_ComputerManager->m_HostStore.save(computer)) {
+                // Forget that we wrote it so the next change tries again
+                QMutexLocker locker(&m_ComputerManager->m_DelayedFlushMutex);
+                m_ComputerManager->m_LastSerializedHosts.remove(computer.uuid);
+            }
+        }
+        for (const QString& uuid : std::as_const(deletedHosts)) {
+            m_ComputerManager->m_HostStore.remove(uuid);
         }
+
+        changedHosts.clear();
+        deletedHosts.clear();
     }
 }
 
@@ -315,8 +155,8 @@ void ComputerManager::saveHosts()
 {
     Q_ASSERT(m_DelayedFlushThread != nullptr && m_DelayedFlushThread->isRunning());
 
-    // Punt to a worker thread because QSettings on macOS can take ages (> 500 ms)
-    // to persist our host list to disk (especially when a host has a bunch of apps).
+    // Punt to a worker thread to keep disk I/O off the calling thread. Only
+    // hosts that have changed since they were last written will be saved.
     QMutexLocker locker(&m_DelayedFlushMutex);
     m_NeedsDelayedFlush = true;
     m_DelayedFlushCondition.wakeOne();
@@ -369,12 +209,13 @@ void ComputerManager::startPolling()
     if (m_Prefs->enableMdns) {
         // Start an MDNS query for GameStream hosts
         m_MdnsServer.reset(new QMdnsEngine::Server());
+        m_MdnsHostCache.setServer(m_MdnsServer.data());
         m_MdnsBrowser = new QMdnsEngine::Browser(m_MdnsServer.data(), "_nvstream._tcp.local.");
         connect(m_MdnsBrowser, &QMdnsEngine::Browser::serviceAdded,
                 this, [this](const QMdnsEngine::Service& service) {
             qInfo() << "Discovered mDNS host:" << service.hostname();
 
-            MdnsPendingComputer* pendingComputer = new MdnsPendingComputer(m_MdnsServer, service);
+            MdnsPendingComputer* pendingComputer = new MdnsPendingComputer(&m_MdnsHostCache, service);
             connect(pendingComputer, &MdnsPendingComputer::resolvedHost,
                     this, &ComputerManager::handleMdnsServiceResolved);
             m_PendingResolution.append(pendingComputer);
@@ -384,7 +225,7 @@ void ComputerManager::startPolling()
         qWarning() << "mDNS is disabled by user preference";
     }
 
-    // Start polling threads for each known host
+    // Start polling each known host
     QMapIterator<QString, NvComputer*> i(m_KnownHosts);
     while (i.hasNext()) {
         i.next();
@@ -399,22 +240,7 @@ void ComputerManager::startPollingComputer(NvComputer* computer)
         return;
     }
 
-    ComputerPollingEntry* pollingEntry;
-
-    if (!m_PollEntries.contains(computer->uuid)) {
-        pollingEntry = m_PollEntries[computer->uuid] = new ComputerPollingEntry();
-    }
-    else {
-        pollingEntry = m_PollEntries[computer->uuid];
-    }
-
-    if (!pollingEntry->isActive()) {
-        PcMonitorThread* thread = new PcMonitorThread(computer);
-        connect(thread, &PcMonitorThread::computerStateChanged,
-                this, &ComputerManager::handleComputerStateChanged);
-        pollingEntry->setActiveThread(thread);
-        thread->start();
-    }
+    m_PollingScheduler->addComputer(computer);
 }
 
 void ComputerManager::handleMdnsServiceResolved(MdnsPendingComputer* computer,
@@ -465,7 +291,7 @@ void ComputerManager::saveHost(NvComputer *computer)
     QMutexLocker lock(&m_DelayedFlushMutex);
     QReadLocker computerLock(&computer->lock);
     if (!m_LastSerializedHosts.value(computer->uuid).isEqualSerialized(*computer)) {
-        // Queue a request for a delayed flush to QSettings outside of the lock
+        // Queue a request for a delayed flush to the host store outside of the lock
         computerLock.unlock();
         lock.unlock();
         saveHosts();
@@ -506,29 +332,25 @@ public:
 
     void run()
     {
-        ComputerPollingEntry* pollingEntry;
-
         // Only do the minimum amount of work while holding the writer lock.
         // We must release it before calling saveHosts().
         {
             QWriteLocker lock(&m_ComputerManager->m_Lock);
 
-            pollingEntry = m_ComputerManager->m_PollEntries.take(m_Computer->uuid);
-
             m_ComputerManager->m_KnownHosts.remove(m_Computer->uuid);
         }
 
         // Persist the new host list with this computer deleted
         m_ComputerManager->saveHosts();
 
-        // Delete the polling entry first. This will stop all polling threads too.
-        delete pollingEntry;
+        // Stop polling first and wait for any poll in progress to finish
+        m_ComputerManager->m_PollingScheduler->removeComputer(m_Computer);
 
         // Delete cached box art
         BoxArtManager::deleteBoxArt(m_Computer);
 
         // Finally, delete the computer itself. This must be done
-        // last because the polling thread might be using it.
+        // last because a poll might be using it.
         delete m_Computer;
     }
 
@@ -567,11 +389,9 @@ void ComputerManager::handleAboutToQuit()
 {
     QReadLocker lock(&m_Lock);
 
-    // Interrupt polling threads immediately, so they
-    // avoid making additional requests while quitting
-    for (ComputerPollingEntry* entry : std::as_const(m_PollEntries)) {
-        entry->interrupt();
-    }
+    // Stop polling immediately, so we avoid making
+    // additional requests while quitting
+    m_PollingScheduler->removeAllComputers();
 }
 
 class PendingPairingTask : public QObject, public QRunnable
@@ -718,12 +538,11 @@ void ComputerManager::stopPollingAsync()
     // Delete the browser and server to stop discovery and refresh polling
     delete m_MdnsBrowser;
     m_MdnsBrowser = nullptr;
+    m_MdnsHostCache.setServer(nullptr);
     m_MdnsServer.reset();
 
-    // Interrupt all threads, but don't wait for them to terminate
-    for (ComputerPollingEntry* entry : std::as_const(m_PollEntries)) {
-        entry->interrupt();
-    }
+    // Stop polling, but don't wait for polls in progress to finish
+    m_PollingScheduler->removeAllComputers();
 }
 
 void ComputerManager::addNewHostManually(QString address)
@@ -774,13 +593,14 @@ private:
         m_AboutToQuit = true;
     }
 
-    QString fetchServerInfo(NvHTTP& http)
+    // Returns a serverinfo without a root element on failure
+    NvServerInfo fetchServerInfo(NvHTTP& http)
     {
-        QString serverInfo;
+        NvServerInfo serverInfo;
 
         // Do nothing if we're quitting
         if (m_AboutToQuit) {
-            return QString();
+            return NvServerInfo();
         }
 
         try {
@@ -819,7 +639,7 @@ private:
 
                 emit computerAddCompleted(false, portTestResult != 0 && portTestResult != ML_TEST_RESULT_INCONCLUSIVE);
             }
-            return QString();
+            return NvServerInfo();
         }
     }
 
@@ -841,13 +661,13 @@ private:
         }
 
         // Perform initial serverinfo fetch over HTTP since we don't know which cert to use
-        QString serverInfo = fetchServerInfo(http);
-        if (serverInfo.isEmpty() && !m_MdnsIpv6Address.isNull()) {
+        NvServerInfo serverInfo = fetchServerInfo(http);
+        if (!serverInfo.hasRoot && !m_MdnsIpv6Address.isNull()) {
             // Retry using the global IPv6 address if the IPv4 or link-local IPv6 address fails
             http.setAddress(m_MdnsIpv6Address);
             serverInfo = fetchServerInfo(http);
         }
-        if (serverInfo.isEmpty()) {
+        if (!serverInfo.hasRoot) {
             return;
         }
 
@@ -868,7 +688,7 @@ private:
         if (existingComputer != nullptr) {
             Q_ASSERT(http.httpsPort() != 0);
             serverInfo = fetchServerInfo(http);
-            if (serverInfo.isEmpty()) {
+            if (!serverInfo.hasRoot) {
                 return;
             }
 
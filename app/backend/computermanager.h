@@ -1,6 +1,9 @@
 #pragma once
 
 #include "nvcomputer.h"
+#include "hoststore.h"
+#include "mdnshostcache.h"
+#include "pollingscheduler.h"
 #include "settings/streamingpreferences.h"
 #include "settings/compatfetcher.h"
 
@@ -42,22 +45,27 @@ class MdnsPendingComputer : public QObject
     Q_OBJECT
 
 public:
-    explicit MdnsPendingComputer(const QSharedPointer<QMdnsEngine::Server> server,
+    explicit MdnsPendingComputer(MdnsHostCache* hostCache,
                                  const QMdnsEngine::Service& service)
         : m_Hostname(service.hostname()),
           m_Port(service.port()),
-          m_ServerWeak(server),
-          m_Resolver(nullptr)
+          m_HostCache(hostCache)
     {
+        connect(m_HostCache, &MdnsHostCache::hostResolved,
+                this, &MdnsPendingComputer::handleHostResolved);
+
+        m_RetryTimer.setSingleShot(true);
+        connect(&m_RetryTimer, &QTimer::timeout,
+                this, &MdnsPendingComputer::handleResolvedTimeout);
+
+        m_SettleTimer.setSingleShot(true);
+        connect(&m_SettleTimer, &QTimer::timeout,
+                this, &MdnsPendingComputer::handleResolvedTimeout);
+
         // Start resolving
         resolve();
     }
 
-    virtual ~MdnsPendingComputer()
-    {
-        delete m_Resolver;
-    }
-
     QString hostname()
     {
         return m_Hostname;
@@ -71,6 +79,8 @@ public:
 private slots:
     void handleResolvedTimeout()
     {
+        m_HostCache->lookup(m_Hostname, m_Addresses);
+
         if (m_Addresses.isEmpty()) {
             if (m_Retries-- > 0) {
                 // Try again
@@ -79,134 +89,57 @@ private slots:
             }
             else {
                 qWarning() << "Giving up on resolving" << hostname() << "after repeated failures";
-                cleanup();
+                disconnect(m_HostCache, nullptr, this, nullptr);
             }
         }
         else {
-            Q_ASSERT(!m_Addresses.isEmpty());
+            // Only report the host once
+            disconnect(m_HostCache, nullptr, this, nullptr);
+            m_RetryTimer.stop();
+            m_SettleTimer.stop();
+
             emit resolvedHost(this, m_Addresses);
         }
     }
 
-    void handleResolvedAddress(const QHostAddress& address)
+    void handleHostResolved(const QByteArray& hostname)
     {
-        m_Addresses.push_back(address);
+        // Give the host a moment to answer for its other addresses
+        // too, since we want both IPv4 and IPv6 if it has them.
+        if (hostname == m_Hostname.toLower() && !m_SettleTimer.isActive()) {
+            m_RetryTimer.stop();
+            m_SettleTimer.start(100);
+        }
     }
 
 signals:
     void resolvedHost(MdnsPendingComputer*,QVector<QHostAddress>&);
 
 private:
-    void cleanup()
-    {
-        // Delete our resolver, so we're guaranteed that nothing is referencing m_Server.
-        delete m_Resolver;
-        m_Resolver = nullptr;
-
-        // Now delete our strong reference that we held on behalf of m_Resolver.
-        // The server may be destroyed after we make this call.
-        m_Server.reset();
-    }
-
     void resolve()
     {
-        // Clean up any existing resolver object and server references
-        cleanup();
+        QVector<QHostAddress> addresses;
 
-        // Re-acquire a strong reference if the server still exists.
-        m_Server = m_ServerWeak.toStrongRef();
-        if (!m_Server) {
+        if (m_HostCache->lookup(m_Hostname, addresses)) {
+            // We already know where this host is. Report it once we get back to
+            // the event loop, after our owner has connected to our signals.
+            m_SettleTimer.start(0);
             return;
         }
 
-        m_Resolver = new QMdnsEngine::Resolver(m_Server.data(), m_Hostname);
-        connect(m_Resolver, &QMdnsEngine::Resolver::resolved,
-                this, &MdnsPendingComputer::handleResolvedAddress);
-        QTimer::singleShot(2000, this, &MdnsPendingComputer::handleResolvedTimeout);
+        m_HostCache->query(m_Hostname);
+        m_RetryTimer.start(2000);
     }
 
     QByteArray m_Hostname;
     uint16_t m_Port;
-    QWeakPointer<QMdnsEngine::Server> m_ServerWeak;
-    QSharedPointer<QMdnsEngine::Server> m_Server;
-    QMdnsEngine::Resolver* m_Resolver;
+    MdnsHostCache* m_HostCache;
+    QTimer m_RetryTimer;
+    QTimer m_SettleTimer;
     QVector<QHostAddress> m_Addresses;
     int m_Retries = 10;
 };
 
-class ComputerPollingEntry
-{
-public:
-    ComputerPollingEntry()
-        : m_ActiveThread(nullptr)
-    {
-
-    }
-
-    virtual ~ComputerPollingEntry()
-    {
-        interrupt();
-
-        // interrupt() should have taken care of this
-        Q_ASSERT(m_ActiveThread == nullptr);
-
-        for (QThread* thread : std::as_const(m_InactiveList)) {
-            thread->wait();
-            delete thread;
-        }
-    }
-
-    bool isActive()
-    {
-        cleanInactiveList();
-
-        return m_ActiveThread != nullptr;
-    }
-
-    void setActiveThread(QThread* thread)
-    {
-        cleanInactiveList();
-
-        Q_ASSERT(!isActive());
-        m_ActiveThread = thread;
-    }
-
-    void interrupt()
-    {
-        cleanInactiveList();
-
-        if (m_ActiveThread != nullptr) {
-            // Interrupt the active thread
-            m_ActiveThread->requestInterruption();
-
-            // Place it on the inactive list awaiting death
-            m_InactiveList.append(m_ActiveThread);
-
-            m_ActiveThread = nullptr;
-        }
-    }
-
-private:
-    void cleanInactiveList()
-    {
-        QMutableListIterator<QThread*> i(m_InactiveList);
-
-        // Reap any threads that have finished
-        while (i.hasNext()) {
-            i.next();
-
-            QThread* thread = i.value();
-            if (thread->isFinished()) {
-                delete thread;
-                i.remove();
-            }
-        }
-    }
-
-    QThread* m_ActiveThread;
-    QList<QThread*> m_InactiveList;
-};
-
 class ComputerManager : public QObject
 {
     Q_OBJECT
@@ -273,9 +206,11 @@ private:
     int m_PollingRef;
     QReadWriteLock m_Lock;
     QMap<QString, NvComputer*> m_KnownHosts;
-    QMap<QString, ComputerPollingEntry*> m_PollEntries;
+    PollingScheduler* m_PollingScheduler;
+    HostStore m_HostStore;
     QHash<QString, NvComputer> m_LastSerializedHosts; // Protected by m_DelayedFlushMutex
     QSharedPointer<QMdnsEngine::Server> m_MdnsServer;
+    MdnsHostCache m_MdnsHostCache;
     QMdnsEngine::Browser* m_MdnsBrowser;
     QVector<MdnsPendingComputer*> m_PendingResolution;
     CompatFetcher m_CompatFetcher;
@@ -0,0 +1,153 @@
+#include "hoststore.h"
+#include "../path.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include <QSettings>
+#include <QtDebug>
+
+#define SER_HOSTS "hosts"
+#define SER_HOSTS_BACKUP "hostsbackup"
+#define SER_HOSTSTOREMIGRATED "hoststoremigrated"
+
+// "MLHS" in little endian
+#define HOST_FILE_MAGIC 0x53484C4D
+#define HOST_FILE_VERSION 1
+#define HOST_FILE_SUFFIX ".host"
+
+HostStore::HostStore()
+    : m_Dir(Path::getHostStoreDir())
+{
+    if (!m_Dir.exists()) {
+        m_Dir.mkpath(".");
+    }
+}
+
+QString HostStore::getFilePath(const QString& uuid)
+{
+    return m_Dir.filePath(uuid + HOST_FILE_SUFFIX);
+}
+
+QVector<NvComputer*> HostStore::load()
+{
+    QSettings settings;
+    QVector<NvComputer*> hosts;
+
+    if (!settings.value(SER_HOSTSTOREMIGRATED).toBool()) {
+        hosts = loadFromSettings();
+
+        // Only mark the migration complete once every host made it to disk
+        bool migrated = true;
+        for (const NvComputer* computer : std::as_const(hosts)) {
+            migrated &= save(*computer);
+        }
+        if (migrated) {
+            settings.setValue(SER_HOSTSTOREMIGRATED, true);
+        }
+
+        qInfo() << "Migrated" << hosts.count() << "hosts from settings to" << m_Dir.absolutePath();
+        return hosts;
+    }
+
+    const QStringList fileNames = m_Dir.entryList(QStringList() << ("*" HOST_FILE_SUFFIX), QDir::Files);
+    for (const QString& fileName : fileNames) {
+        NvComputer* computer = loadHost(m_Dir.filePath(fileName));
+        if (computer != nullptr) {
+            hosts.append(computer);
+        }
+    }
+
+    return hosts;
+}
+
+NvComputer* HostStore::loadHost(const QString& fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Failed to open host file:" << fileName << file.errorString();
+        return nullptr;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, version;
+    stream >> magic >> version;
+    if (stream.status() != QDataStream::Ok || magic != HOST_FILE_MAGIC || version != HOST_FILE_VERSION) {
+        qWarning() << "Ignoring unrecognized host file:" << fileName;
+        return nullptr;
+    }
+
+    NvComputer* computer = new NvComputer(stream);
+    if (stream.status() != QDataStream::Ok || computer->uuid.isEmpty()) {
+        qWarning() << "Ignoring corrupt host file:" << fileName;
+        delete computer;
+        return nullptr;
+    }
+
+    return computer;
+}
+
+QVector<NvComputer*> HostStore::loadFromSettings()
+{
+    QSettings settings;
+    QVector<NvComputer*> hosts;
+
+    // If there's a hosts backup copy, we must have failed to commit
+    // a previous update before exiting. Restore the backup now.
+    int hostCount = settings.beginReadArray(SER_HOSTS_BACKUP);
+    if (hostCount == 0) {
+        // If there's no host backup, read from the primary location.
+        settings.endArray();
+        hostCount = settings.beginReadArray(SER_HOSTS);
+    }
+
+    for (int i = 0; i < hostCount; i++) {
+        settings.setArrayIndex(i);
+        hosts.append(new NvComputer(settings));
+    }
+    settings.endArray();
+
+    return hosts;
+}
+
+bool HostStore::save(const NvComputer& computer)
+{
+    // Avoid deleting an existing applist if we couldn't get one
+    if (computer.appList.isEmpty() && QFile::exists(getFilePath(computer.uuid))) {
+        NvComputer* savedComputer = loadHost(getFilePath(computer.uuid));
+        if (savedComputer != nullptr && !savedComputer->appList.isEmpty()) {
+            NvComputer mergedComputer = computer;
+            mergedComputer.appList = savedComputer->appList;
+            delete savedComputer;
+            return save(mergedComputer);
+        }
+
+        delete savedComputer;
+    }
+
+    QSaveFile file(getFilePath(computer.uuid));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to open host file:" << file.fileName() << file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << (quint32)HOST_FILE_MAGIC << (quint32)HOST_FILE_VERSION;
+    computer.serialize(stream);
+
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "Failed to write host file:" << file.fileName() << file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+void HostStore::remove(const QString& uuid)
+{
+    QFile::remove(getFilePath(uuid));
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "nvcomputer.h"
+
+#include <QDir>
+
+// Persists hosts as one small binary file per host, so a flush only has to
+// rewrite the hosts that actually changed. Each file is written to a temporary
+// file and renamed into place, so a crash mid-write leaves the old copy intact.
+//
+// Hosts used to be stored in QSettings. They're migrated once on first load,
+// and the QSettings copy is left alone in case of a downgrade.
+class HostStore
+{
+public:
+    HostStore();
+
+    // Caller takes ownership of the returned hosts
+    QVector<NvComputer*>
+    load();
+
+    bool
+    save(const NvComputer& computer);
+
+    void
+    remove(const QString& uuid);
+
+private:
+    QVector<NvComputer*>
+    loadFromSettings();
+
+    NvComputer*
+    loadHost(const QString& fileName);
+
+    QString
+    getFilePath(const QString& uuid);
+
+    QDir m_Dir;
+};
@@ -12,6 +12,9 @@
 #define SER_CERT "certificate"
 #define SER_KEY "key"
 
+// Used when the host doesn't tell us how long its session tickets are valid
+#define DEFAULT_SSL_SESSION_LIFETIME_SECS 300
+
 IdentityManager* IdentityManager::s_Im = nullptr;
 
 IdentityManager*
@@ -190,6 +193,59 @@ IdentityManager::getSslConfig()
     return sslConfig;
 }
 
+QSslConfiguration
+IdentityManager::getSslConfig(const QString& sessionKey)
+{
+    QSslConfiguration sslConfig = getSslConfig();
+
+    // Resuming a session skips the expensive asymmetric part of the handshake.
+    // We still close each connection after the request, so this lets us poll
+    // hosts cheaply without holding idle connections open.
+    sslConfig.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+
+    QMutexLocker lock(&m_SslSessionMutex);
+
+    auto it = m_SslSessions.find(sessionKey);
+    if (it != m_SslSessions.end()) {
+        if (it->expiry.hasExpired()) {
+            m_SslSessions.erase(it);
+        }
+        else {
+            sslConfig.setSessionTicket(it->ticket);
+        }
+    }
+
+    return sslConfig;
+}
+
+void
+IdentityManager::saveSslSession(const QString& sessionKey, const QSslConfiguration& sslConfig)
+{
+    QByteArray ticket = sslConfig.sessionTicket();
+    if (ticket.isEmpty()) {
+        return;
+    }
+
+    int lifetimeSecs = sslConfig.sessionTicketLifeTimeHint();
+    if (lifetimeSecs <= 0) {
+        lifetimeSecs = DEFAULT_SSL_SESSION_LIFETIME_SECS;
+    }
+
+    QMutexLocker lock(&m_SslSessionMutex);
+
+    SslSession& session = m_SslSessions[sessionKey];
+    session.ticket = ticket;
+    session.expiry.setRemainingTime((qint64)lifetimeSecs * 1000);
+}
+
+void
+IdentityManager::clearSslSession(const QString& sessionKey)
+{
+    QMutexLocker lock(&m_SslSessionMutex);
+
+    m_SslSessions.remove(sessionKey);
+}
+
 QString
 IdentityManager::getUniqueId()
 {
@@ -4,6 +4,9 @@
 #include <QSslCertificate>
 #include <QSslKey>
 #include <QSettings>
+#include <QMutex>
+#include <QMap>
+#include <QDeadlineTimer>
 
 class IdentityManager
 {
@@ -20,6 +23,18 @@ public:
     QSslConfiguration
     getSslConfig();
 
+    // Returns a configuration that resumes the last TLS session for this
+    // key if we have one, and keeps the new session for next time.
+    QSslConfiguration
+    getSslConfig(const QString& sessionKey);
+
+    // Saves the session negotiated by a completed connection
+    void
+    saveSslSession(const QString& sessionKey, const QSslConfiguration& sslConfig);
+
+    void
+    clearSslSession(const QString& sessionKey);
+
     static
     IdentityManager*
     get();
@@ -45,5 +60,14 @@ private:
     QSslCertificate m_CachedSslCert;
     QSslKey m_CachedSslKey;
 
+    struct SslSession {
+        QByteArray ticket;
+        QDeadlineTimer expiry;
+    };
+
+    // Requests for different hosts run on several threads at once
+    QMutex m_SslSessionMutex;
+    QMap<QString, SslSession> m_SslSessions;
+
     static IdentityManager* s_Im;
 };
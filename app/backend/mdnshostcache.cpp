@@ -0,0 +1,183 @@
+#include "mdnshostcache.h"
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
+
+#include <QTimer>
+
+MdnsHostCache::MdnsHostCache(QObject* parent)
+    : QObject(parent),
+      m_Server(nullptr)
+{
+}
+
+QByteArray MdnsHostCache::normalizeHostname(const QByteArray& hostname)
+{
+    // mDNS names are case-insensitive
+    return hostname.toLower();
+}
+
+void MdnsHostCache::setServer(QMdnsEngine::AbstractServer* server)
+{
+    if (m_Server != nullptr) {
+        disconnect(m_Server, nullptr, this, nullptr);
+    }
+
+    m_Server = server;
+    m_PendingQueries.clear();
+
+    if (m_Server != nullptr) {
+        connect(m_Server, &QMdnsEngine::AbstractServer::messageReceived,
+                this, &MdnsHostCache::handleMessageReceived);
+    }
+}
+
+bool MdnsHostCache::lookup(const QByteArray& hostname, QVector<QHostAddress>& addresses)
+{
+    auto it = m_Hosts.find(normalizeHostname(hostname));
+    if (it == m_Hosts.end()) {
+        return false;
+    }
+
+    QVector<CachedAddress>& cachedAddresses = it.value();
+    for (int i = 0; i < cachedAddresses.count();) {
+        if (cachedAddresses[i].expiry.hasExpired()) {
+            cachedAddresses.removeAt(i);
+        }
+        else {
+            if (!addresses.contains(cachedAddresses[i].address)) {
+                addresses.append(cachedAddresses[i].address);
+            }
+            i++;
+        }
+    }
+
+    if (cachedAddresses.isEmpty()) {
+        m_Hosts.erase(it);
+        return false;
+    }
+
+    return true;
+}
+
+void MdnsHostCache::pruneExpiredHosts()
+{
+    for (auto it = m_Hosts.begin(); it != m_Hosts.end();) {
+        QVector<CachedAddress>& cachedAddresses = it.value();
+        for (int i = 0; i < cachedAddresses.count();) {
+            if (cachedAddresses[i].expiry.hasExpired()) {
+                cachedAddresses.removeAt(i);
+            }
+            else {
+                i++;
+            }
+        }
+
+        if (cachedAddresses.isEmpty()) {
+            it = m_Hosts.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+void MdnsHostCache::query(const QByteArray& hostname)
+{
+    if (m_Server == nullptr) {
+        return;
+    }
+
+    if (m_PendingQueries.isEmpty()) {
+        QTimer::singleShot(0, this, &MdnsHostCache::sendQueries);
+    }
+
+    m_PendingQueries.insert(hostname);
+}
+
+void MdnsHostCache::sendQueries()
+{
+    if (m_Server == nullptr || m_PendingQueries.isEmpty()) {
+        return;
+    }
+
+    QMdnsEngine::Message message;
+    for (const QByteArray& hostname : std::as_const(m_PendingQueries)) {
+        QMdnsEngine::Query query;
+        query.setName(hostname);
+
+        query.setType(QMdnsEngine::A);
+        message.addQuery(query);
+
+        query.setType(QMdnsEngine::AAAA);
+        message.addQuery(query);
+    }
+
+    m_Server->sendMessageToAll(message);
+    m_PendingQueries.clear();
+}
+
+void MdnsHostCache::handleMessageReceived(const QMdnsEngine::Message& message)
+{
+    if (!message.isResponse()) {
+        return;
+    }
+
+    QSet<QByteArray> resolvedHosts;
+
+    const QList<QMdnsEngine::Record> records = message.records();
+    for (const QMdnsEngine::Record& record : records) {
+        if (record.type() != QMdnsEngine::A && record.type() != QMdnsEngine::AAAA) {
+            continue;
+        }
+
+        QByteArray hostname = normalizeHostname(record.name());
+        auto it = m_Hosts.find(hostname);
+        if (it == m_Hosts.end()) {
+            if (record.ttl() == 0) {
+                // Nothing to withdraw
+                continue;
+            }
+
+            // We cache every hostname we hear about, not just our hosts, so
+            // forget the ones that have gone away before adding another.
+            pruneExpiredHosts();
+            it = m_Hosts.insert(hostname, QVector<CachedAddress>());
+        }
+
+        QVector<CachedAddress>& cachedAddresses = it.value();
+
+        int i;
+        for (i = 0; i < cachedAddresses.count(); i++) {
+            if (cachedAddresses[i].address == record.address()) {
+                break;
+            }
+        }
+
+        if (record.ttl() == 0) {
+            // A TTL of 0 means the host is withdrawing this address
+            if (i < cachedAddresses.count()) {
+                cachedAddresses.removeAt(i);
+            }
+            if (cachedAddresses.isEmpty()) {
+                m_Hosts.erase(it);
+            }
+            continue;
+        }
+
+        if (i == cachedAddresses.count()) {
+            CachedAddress cachedAddress;
+            cachedAddress.address = record.address();
+            cachedAddresses.append(cachedAddress);
+            resolvedHosts.insert(hostname);
+        }
+
+        // Refresh the expiry for addresses we already knew too
+        cachedAddresses[i].expiry.setRemainingTime((qint64)record.ttl() * 1000);
+    }
+
+    for (const QByteArray& hostname : std::as_const(resolvedHosts)) {
+        emit hostResolved(hostname);
+    }
+}
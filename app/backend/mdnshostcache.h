@@ -0,0 +1,59 @@
+#pragma once
+
+#include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/message.h>
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QHostAddress>
+#include <QDeadlineTimer>
+
+// Remembers the addresses of mDNS hostnames for as long as their records' TTLs
+// allow. It learns from every response the server receives, not just answers
+// to our own queries, since hosts usually include their address records with
+// their service records. The cache outlives the mDNS server, so hosts that
+// were resolved before polling stopped are resolved instantly when it starts
+// again.
+class MdnsHostCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MdnsHostCache(QObject* parent = nullptr);
+
+    // Pass nullptr to detach from the server before it is destroyed
+    void setServer(QMdnsEngine::AbstractServer* server);
+
+    // Returns false if there are no unexpired addresses for this hostname
+    bool lookup(const QByteArray& hostname, QVector<QHostAddress>& addresses);
+
+    // Queries for this hostname's addresses. Queries made in the same event
+    // loop iteration are batched into a single message.
+    void query(const QByteArray& hostname);
+
+signals:
+    // New addresses were cached for this hostname, which is in lowercase
+    void hostResolved(const QByteArray& hostname);
+
+private slots:
+    void handleMessageReceived(const QMdnsEngine::Message& message);
+
+    void sendQueries();
+
+private:
+    struct CachedAddress {
+        QHostAddress address;
+        QDeadlineTimer expiry;
+    };
+
+    static QByteArray normalizeHostname(const QByteArray& hostname);
+
+    // Removes expired addresses and the hostnames left without any
+    void pruneExpiredHosts();
+
+    QMdnsEngine::AbstractServer* m_Server;
+    QHash<QByteArray, QVector<CachedAddress>> m_Hosts;
+    QSet<QByteArray> m_PendingQueries;
+};
@@ -51,6 +51,51 @@ NvComputer::NvComputer(QSettings& settings)
     settings.endArray();
     sortAppList();
 
+    initializeEphemeralTraits();
+}
+
+static
+NvAddress
+readAddress(QDataStream& stream)
+{
+    QString address;
+    quint16 port;
+
+    stream >> address >> port;
+    return NvAddress(address, port);
+}
+
+static
+void
+writeAddress(QDataStream& stream, const NvAddress& address)
+{
+    stream << address.address() << (quint16)address.port();
+}
+
+NvComputer::NvComputer(QDataStream& stream)
+{
+    QByteArray serverCertPem;
+    quint32 appCount;
+
+    stream >> this->name >> this->hasCustomName >> this->uuid >> this->macAddress;
+    this->localAddress = readAddress(stream);
+    this->remoteAddress = readAddress(stream);
+    this->ipv6Address = readAddress(stream);
+    this->manualAddress = readAddress(stream);
+    stream >> serverCertPem >> this->isNvidiaServerSoftware;
+    this->serverCert = QSslCertificate(serverCertPem);
+
+    stream >> appCount;
+    for (quint32 i = 0; i < appCount && stream.status() == QDataStream::Ok; i++) {
+        this->appList.append(NvApp(stream));
+    }
+    sortAppList();
+
+    initializeEphemeralTraits();
+}
+
+void NvComputer::initializeEphemeralTraits()
+{
     this->currentGameId = 0;
     this->pairState = PS_UNKNOWN;
     this->state = CS_UNKNOWN;
@@ -74,34 +119,20 @@ void NvComputer::setRemoteAddress(QHostAddress address)
     this->remoteAddress = NvAddress(address, this->externalPort);
 }
 
-void NvComputer::serialize(QSettings& settings, bool serializeApps) const
+void NvComputer::serialize(QDataStream& stream) const
 {
     QReadLocker lock(&this->lock);
 
-    settings.setValue(SER_NAME, name);
-    settings.setValue(SER_CUSTOMNAME, hasCustomName);
-    settings.setValue(SER_UUID, uuid);
-    settings.setValue(SER_MAC, macAddress);
-    settings.setValue(SER_LOCALADDR, localAddress.address());
-    settings.setValue(SER_LOCALPORT, localAddress.port());
-    settings.setValue(SER_REMOTEADDR, remoteAddress.address());
-    settings.setValue(SER_REMOTEPORT, remoteAddress.port());
-    settings.setValue(SER_IPV6ADDR, ipv6Address.address());
-    settings.setValue(SER_IPV6PORT, ipv6Address.port());
-    settings.setValue(SER_MANUALADDR, manualAddress.address());
-    settings.setValue(SER_MANUALPORT, manualAddress.port());
-    settings.setValue(SER_SRVCERT, serverCert.toPem());
-    settings.setValue(SER_NVIDIASOFTWARE, isNvidiaServerSoftware);
-
-    // Avoid deleting an existing applist if we couldn't get one
-    if (!appList.isEmpty() && serializeApps) {
-        settings.remove(SER_APPLIST);
-        settings.beginWriteArray(SER_APPLIST);
-        for (int i = 0; i < appList.count(); i++) {
-            settings.setArrayIndex(i);
-            appList.at(i).serialize(settings);
-        }
-        settings.endArray();
+    stream << name << hasCustomName << uuid << macAddress;
+    writeAddress(stream, localAddress);
+    writeAddress(stream, remoteAddress);
+    writeAddress(stream, ipv6Address);
+    writeAddress(stream, manualAddress);
+    stream << serverCert.toPem() << isNvidiaServerSoftware;
+
+    stream << (quint32)appList.count();
+    for (const NvApp& app : appList) {
+        app.serialize(stream);
     }
 }
 
@@ -127,18 +158,18 @@ void NvComputer::sortAppList()
     });
 }
 
-NvComputer::NvComputer(NvHTTP& http, QString serverInfo)
+NvComputer::NvComputer(NvHTTP& http, const NvServerInfo& serverInfo)
 {
     this->serverCert = http.serverCert();
 
     this->hasCustomName = false;
-    this->name = NvHTTP::getXmlString(serverInfo, "hostname");
+    this->name = serverInfo.hostname;
     if (this->name.isEmpty()) {
         this->name = "UNKNOWN";
     }
 
-    this->uuid = NvHTTP::getXmlString(serverInfo, "uniqueid");
-    QString newMacString = NvHTTP::getXmlString(serverInfo, "mac");
+    this->uuid = serverInfo.uniqueId;
+    QString newMacString = serverInfo.mac;
     if (newMacString != "00:00:00:00:00:00") {
         QStringList macOctets = newMacString.split(':');
         for (const QString& macOctet : std::as_const(macOctets)) {
@@ -146,7 +177,7 @@ NvComputer::NvComputer(NvHTTP& http, QString serverInfo)
         }
     }
 
-    QString codecSupport = NvHTTP::getXmlString(serverInfo, "ServerCodecModeSupport");
+    QString codecSupport = serverInfo.serverCodecModeSupport;
     if (!codecSupport.isEmpty()) {
         this->serverCodecModeSupport = codecSupport.toInt();
     }
@@ -155,7 +186,7 @@ NvComputer::NvComputer(NvHTTP& http, QString serverInfo)
         this->serverCodecModeSupport = SCM_H264;
     }
 
-    QString maxLumaPixelsHEVC = NvHTTP::getXmlString(serverInfo, "MaxLumaPixelsHEVC");
+    QString maxLumaPixelsHEVC = serverInfo.maxLumaPixelsHEVC;
     if (!maxLumaPixelsHEVC.isEmpty()) {
         this->maxLumaPixelsHEVC = maxLumaPixelsHEVC.toInt();
     }
@@ -163,7 +194,7 @@ NvComputer::NvComputer(NvHTTP& http, QString serverInfo)
         this->maxLumaPixelsHEVC = 0;
     }
 
-    this->displayModes = NvHTTP::getDisplayModeList(serverInfo);
+    this->displayModes = serverInfo.displayModes;
     std::stable_sort(this->displayModes.begin(), this->displayModes.end(),
                      [](const NvDisplayMode& mode1, const NvDisplayMode& mode2) {
         return (uint64_t)mode1.width * mode1.height * mode1.refreshRate <
@@ -171,24 +202,24 @@ NvComputer::NvComputer(NvHTTP& http, QString serverInfo)
     });
 
     // We can get an IPv4 loopback address if we're using the GS IPv6 Forwarder
-    this->localAddress = NvAddress(NvHTTP::getXmlString(serverInfo, "LocalIP"), http.httpPort());
+    this->localAddress = NvAddress(serverInfo.localIp, http.httpPort());
     if (this->localAddress.address().startsWith("127.")) {
         this->localAddress = NvAddress();
     }
 
-    QString httpsPort = NvHTTP::getXmlString(serverInfo, "HttpsPort");
+    QString httpsPort = serverInfo.httpsPort;
     if (httpsPort.isEmpty() || (this->activeHttpsPort = httpsPort.toUShort()) == 0) {
         this->activeHttpsPort = DEFAULT_HTTPS_PORT;
     }
 
     // This is an extension which is not present in GFE. It is present for Sunshine to be able
     // to support dynamic HTTP WAN ports without requiring the user to manually enter the port.
-    QString remotePortStr = NvHTTP::getXmlString(serverInfo, "ExternalPort");
+    QString remotePortStr = serverInfo.externalPort;
     if (remotePortStr.isEmpty() || (this->externalPort = remotePortStr.toUShort()) == 0) {
         this->externalPort = http.httpPort();
     }
 
-    QString remoteAddress = NvHTTP::getXmlString(serverInfo, "ExternalIP");
+    QString remoteAddress = serverInfo.externalIp;
     if (!remoteAddress.isEmpty()) {
         this->remoteAddress = NvAddress(remoteAddress, this->externalPort);
     }
@@ -199,14 +230,14 @@ NvComputer::NvComputer(NvHTTP& http, QString serverInfo)
     // Real Nvidia host software (GeForce Experience and RTX Experience) both use the 'Mjolnir'
     // codename in the state field and no version of Sunshine does. We can use this to bypass
     // some assumptions about Nvidia hardware that don't apply to Sunshine hosts.
-    this->isNvidiaServerSoftware = NvHTTP::getXmlString(serverInfo, "state").contains("MJOLNIR");
+    this->isNvidiaServerSoftware = serverInfo.state.contains("MJOLNIR");
 
-    this->pairState = NvHTTP::getXmlString(serverInfo, "PairStatus") == "1" ?
+    this->pairState = serverInfo.pairStatus == "1" ?
                 PS_PAIRED : PS_NOT_PAIRED;
-    this->currentGameId = NvHTTP::getCurrentGame(serverInfo);
-    this->appVersion = NvHTTP::getXmlString(serverInfo, "appversion");
-    this->gfeVersion = NvHTTP::getXmlString(serverInfo, "GfeVersion");
-    this->gpuModel = NvHTTP::getXmlString(serverInfo, "gputype");
+    this->currentGameId = serverInfo.currentGameId();
+    this->appVersion = serverInfo.appVersion;
+    this->gfeVersion = serverInfo.gfeVersion;
+    this->gpuModel = serverInfo.gpuType;
     this->activeAddress = http.address();
     this->state = NvComputer::CS_ONLINE;
     this->pendingQuit = false;
@@ -20,13 +20,15 @@ public:
 
 class NvComputer
 {
-    friend class PcMonitorThread;
+    friend class PollingScheduler;
     friend class ComputerManager;
     friend class PendingQuitTask;
 
 private:
     void sortAppList();
 
+    void initializeEphemeralTraits();
+
     bool updateAppList(QVector<NvApp> newAppList);
 
     bool pendingQuit;
@@ -40,10 +42,12 @@ public:
     // Caller is responsible for synchronizing read access to the other host
     NvComputer& operator=(const NvComputer &) = default;
 
-    explicit NvComputer(NvHTTP& http, QString serverInfo);
+    explicit NvComputer(NvHTTP& http, const NvServerInfo& serverInfo);
 
     explicit NvComputer(QSettings& settings);
 
+    explicit NvComputer(QDataStream& stream);
+
     void
     setRemoteAddress(QHostAddress);
 
@@ -67,7 +71,7 @@ public:
     uniqueAddresses() const;
 
     void
-    serialize(QSettings& settings, bool serializeApps) const;
+    serialize(QDataStream& stream) const;
 
     // Caller is responsible for synchronizing read access to both hosts
     bool
@@ -12,6 +12,7 @@
 #include <QImageReader>
 #include <QtEndian>
 #include <QNetworkProxy>
+#include <QCryptographicHash>
 
 #define FAST_FAIL_TIMEOUT_MS 2000
 #define REQUEST_TIMEOUT_MS 5000
@@ -21,7 +22,8 @@
 
 NvHTTP::NvHTTP(NvAddress address, uint16_t httpsPort, QSslCertificate serverCert, QNetworkAccessManager* nam) :
     m_Nam(nam ? nam : new QNetworkAccessManager(this)),
-    m_ServerCert(serverCert)
+    m_ServerCert(serverCert),
+    m_AsyncRequestsInFlight(0)
 {
     m_BaseUrlHttp.setScheme("http");
     m_BaseUrlHttps.setScheme("https");
@@ -103,27 +105,10 @@ NvHTTP::parseQuad(QString quad)
     return ret;
 }
 
-int
-NvHTTP::getCurrentGame(QString serverInfo)
-{
-    // GFE 2.8 started keeping currentgame set to the last game played. As a result, it no longer
-    // has the semantics that its name would indicate. To contain the effects of this change as much
-    // as possible, we'll force the current game to zero if the server isn't in a streaming session.
-    QString serverState = getXmlString(serverInfo, "state");
-    if (serverState != nullptr && serverState.endsWith("_SERVER_BUSY"))
-    {
-        return getXmlString(serverInfo, "currentgame").toInt();
-    }
-    else
-    {
-        return 0;
-    }
-}
-
-QString
+NvServerInfo
 NvHTTP::getServerInfo(NvLogLevel logLevel, bool fastFail)
 {
-    QString serverInfo;
+    NvServerInfo serverInfo;
 
     // Check if we have a pinned cert and HTTPS port for this host yet
     if (!m_ServerCert.isNull() && httpsPort() != 0)
@@ -132,11 +117,11 @@ NvHTTP::getServerInfo(NvLogLevel logLevel, bool fastFail)
         {
             // Always try HTTPS first, since it properly reports
             // pairing status (and a few other attributes).
-            serverInfo = openConnectionToString(m_BaseUrlHttps,
-                                                "serverinfo",
-                                                nullptr,
-                                                fastFail ? FAST_FAIL_TIMEOUT_MS : REQUEST_TIMEOUT_MS,
-                                                logLevel);
+            serverInfo = parseServerInfo(openConnectionToString(m_BaseUrlHttps,
+                                                                "serverinfo",
+                                                                nullptr,
+                                                                fastFail ? FAST_FAIL_TIMEOUT_MS : REQUEST_TIMEOUT_MS,
+                                                                logLevel));
             // Throws if the request failed
             verifyResponseStatus(serverInfo);
         }
@@ -145,11 +130,11 @@ NvHTTP::getServerInfo(NvLogLevel logLevel, bool fastFail)
             if (e.getStatusCode() == 401)
             {
                 // Certificate validation error, fallback to HTTP
-                serverInfo = openConnectionToString(m_BaseUrlHttp,
-                                                    "serverinfo",
-                                                    nullptr,
-                                                    fastFail ? FAST_FAIL_TIMEOUT_MS : REQUEST_TIMEOUT_MS,
-                                                    logLevel);
+                serverInfo = parseServerInfo(openConnectionToString(m_BaseUrlHttp,
+                                                                    "serverinfo",
+                                                                    nullptr,
+                                                                    fastFail ? FAST_FAIL_TIMEOUT_MS : REQUEST_TIMEOUT_MS,
+                                                                    logLevel));
                 verifyResponseStatus(serverInfo);
             }
             else
@@ -162,15 +147,15 @@ NvHTTP::getServerInfo(NvLogLevel logLevel, bool fastFail)
     else
     {
         // Only use HTTP prior to pairing or fetching HTTPS port
-        serverInfo = openConnectionToString(m_BaseUrlHttp,
-                                            "serverinfo",
-                                            nullptr,
-                                            fastFail ? FAST_FAIL_TIMEOUT_MS : REQUEST_TIMEOUT_MS,
-                                            logLevel);
+        serverInfo = parseServerInfo(openConnectionToString(m_BaseUrlHttp,
+                                                            "serverinfo",
+                                                            nullptr,
+                                                            fastFail ? FAST_FAIL_TIMEOUT_MS : REQUEST_TIMEOUT_MS,
+                                                            logLevel));
         verifyResponseStatus(serverInfo);
 
         // Populate the HTTPS port
-        uint16_t httpsPort = getXmlString(serverInfo, "HttpsPort").toUShort();
+        uint16_t httpsPort = serverInfo.httpsPort.toUShort();
         if (httpsPort == 0) {
             httpsPort = DEFAULT_HTTPS_PORT;
         }
@@ -186,6 +171,87 @@ NvHTTP::getServerInfo(NvLogLevel logLevel, bool fastFail)
     return serverInfo;
 }
 
+NvServerInfo
+NvHTTP::parseServerInfoResponse(NvHttpResponse& response)
+{
+    if (!response.isSuccess()) {
+        return NvServerInfo();
+    }
+
+    NvServerInfo serverInfo = parseServerInfo(response.toString());
+
+    // Report a failure status the same way verifyResponseStatus() does
+    if (!serverInfo.hasRoot) {
+        response.httpStatusCode = -1;
+        response.errorText = "Malformed XML (missing root element)";
+    }
+    else if (serverInfo.statusCode != 200) {
+        response.httpStatusCode = serverInfo.statusCode;
+        response.errorText = serverInfo.statusMessage;
+    }
+
+    return serverInfo;
+}
+
+void
+NvHTTP::getServerInfoAsync(NvLogLevel logLevel, bool fastFail, ServerInfoCallback callback)
+{
+    int timeoutMs = fastFail ? FAST_FAIL_TIMEOUT_MS : REQUEST_TIMEOUT_MS;
+
+    // This follows the same sequence of requests as getServerInfo()
+    if (!m_ServerCert.isNull() && httpsPort() != 0)
+    {
+        openConnectionAsync(m_BaseUrlHttps, "serverinfo", nullptr, timeoutMs, logLevel,
+                            [this, timeoutMs, logLevel, callback](const NvHttpResponse& httpsResponse) {
+            NvHttpResponse response = httpsResponse;
+            NvServerInfo serverInfo = parseServerInfoResponse(response);
+
+            if (response.httpStatusCode == 401) {
+                // Certificate validation error, fallback to HTTP
+                openConnectionAsync(m_BaseUrlHttp, "serverinfo", nullptr, timeoutMs, logLevel,
+                                    [callback](const NvHttpResponse& httpResponse) {
+                    NvHttpResponse response = httpResponse;
+                    NvServerInfo serverInfo = parseServerInfoResponse(response);
+                    callback(response, serverInfo);
+                });
+                return;
+            }
+
+            callback(response, serverInfo);
+        });
+    }
+    else
+    {
+        // Only use HTTP prior to pairing or fetching HTTPS port
+        openConnectionAsync(m_BaseUrlHttp, "serverinfo", nullptr, timeoutMs, logLevel,
+                            [this, fastFail, logLevel, callback](const NvHttpResponse& httpResponse) {
+            NvHttpResponse response = httpResponse;
+            NvServerInfo serverInfo = parseServerInfoResponse(response);
+
+            if (!response.isSuccess()) {
+                callback(response, serverInfo);
+                return;
+            }
+
+            // Populate the HTTPS port
+            uint16_t httpsPort = serverInfo.httpsPort.toUShort();
+            if (httpsPort == 0) {
+                httpsPort = DEFAULT_HTTPS_PORT;
+            }
+            setHttpsPort(httpsPort);
+
+            // If we just needed to determine the HTTPS port, we'll try again over
+            // HTTPS now that we have the port number
+            if (!m_ServerCert.isNull()) {
+                getServerInfoAsync(logLevel, fastFail, callback);
+                return;
+            }
+
+            callback(response, serverInfo);
+        });
+    }
+}
+
 void
 NvHTTP::startApp(QString verb,
                  bool isGfe,
@@ -251,56 +317,135 @@ NvHTTP::quitApp()
 
     // Newer GFE versions will just return success even if quitting fails
     // if we're not the original requester.
-    if (getCurrentGame(getServerInfo(NvHTTP::NVLL_ERROR)) != 0) {
+    if (getServerInfo(NvHTTP::NVLL_ERROR).currentGameId() != 0) {
         // Generate a synthetic GfeResponseException letting the caller know
         // that they can't kill someone else's stream.
         throw GfeHttpResponseException(599, "");
     }
 }
 
-QVector<NvDisplayMode>
-NvHTTP::getDisplayModeList(QString serverInfo)
+NvServerInfo
+NvHTTP::parseServerInfo(const QString& xml)
 {
-    QXmlStreamReader xmlReader(serverInfo);
-    QVector<NvDisplayMode> modes;
+    static const struct {
+        const char* tagName;
+        QString NvServerInfo::* field;
+    } k_ServerInfoFields[] = {
+        { "hostname", &NvServerInfo::hostname },
+        { "uniqueid", &NvServerInfo::uniqueId },
+        { "mac", &NvServerInfo::mac },
+        { "LocalIP", &NvServerInfo::localIp },
+        { "ExternalIP", &NvServerInfo::externalIp },
+        { "HttpsPort", &NvServerInfo::httpsPort },
+        { "ExternalPort", &NvServerInfo::externalPort },
+        { "state", &NvServerInfo::state },
+        { "PairStatus", &NvServerInfo::pairStatus },
+        { "currentgame", &NvServerInfo::currentGame },
+        { "appversion", &NvServerInfo::appVersion },
+        { "GfeVersion", &NvServerInfo::gfeVersion },
+        { "gputype", &NvServerInfo::gpuType },
+        { "ServerCodecModeSupport", &NvServerInfo::serverCodecModeSupport },
+        { "MaxLumaPixelsHEVC", &NvServerInfo::maxLumaPixelsHEVC },
+    };
+
+    QXmlStreamReader xmlReader(xml);
+    NvServerInfo serverInfo;
+    uint32_t fieldsFound = 0;
 
     while (!xmlReader.atEnd()) {
-        while (xmlReader.readNextStartElement()) {
-            auto name = xmlReader.name();
-            if (name == QString("DisplayMode")) {
-                modes.append(NvDisplayMode());
+        if (xmlReader.readNext() != QXmlStreamReader::StartElement) {
+            continue;
+        }
+
+        auto name = xmlReader.name();
+        if (name == QLatin1String("root")) {
+            if (!serverInfo.hasRoot) {
+                // Status code can be 0xFFFFFFFF in some rare cases on GFE 3.20.3, and
+                // QString::toInt() will fail in that case, so use QString::toUInt()
+                // and cast the result to an int instead.
+                serverInfo.hasRoot = true;
+                serverInfo.statusCode = (int)xmlReader.attributes().value("status_code").toUInt();
+                serverInfo.statusMessage = xmlReader.attributes().value("status_message").toString();
             }
-            else if (name == QString("Width")) {
-                modes.last().width = xmlReader.readElementText().toInt();
+        }
+        else if (name == QLatin1String("DisplayMode")) {
+            serverInfo.displayModes.append(NvDisplayMode());
+        }
+        else if (name == QLatin1String("Width")) {
+            if (!serverInfo.displayModes.isEmpty()) {
+                serverInfo.displayModes.last().width = xmlReader.readElementText().toInt();
             }
-            else if (name == QString("Height")) {
-                modes.last().height = xmlReader.readElementText().toInt();
+        }
+        else if (name == QLatin1String("Height")) {
+            if (!serverInfo.displayModes.isEmpty()) {
+                serverInfo.displayModes.last().height = xmlReader.readElementText().toInt();
             }
-            else if (name == QString("RefreshRate")) {
-                modes.last().refreshRate = xmlReader.readElementText().toInt();
+        }
+        else if (name == QLatin1String("RefreshRate")) {
+            if (!serverInfo.displayModes.isEmpty()) {
+                serverInfo.displayModes.last().refreshRate = xmlReader.readElementText().toInt();
+            }
+        }
+        else {
+            for (int i = 0; i < (int)(sizeof(k_ServerInfoFields) / sizeof(k_ServerInfoFields[0])); i++) {
+                if (name == QLatin1String(k_ServerInfoFields[i].tagName)) {
+                    // Like getXmlString(), the first occurrence of a tag wins
+                    if (!(fieldsFound & (1 << i))) {
+                        serverInfo.*k_ServerInfoFields[i].field = xmlReader.readElementText();
+                        fieldsFound |= 1 << i;
+                    }
+                    break;
+                }
             }
         }
     }
 
-    return modes;
+    return serverInfo;
 }
 
 QVector<NvApp>
 NvHTTP::getAppList()
 {
-    QString appxml = openConnectionToString(m_BaseUrlHttps,
-                                            "applist",
-                                            nullptr,
-                                            REQUEST_TIMEOUT_MS,
-                                            NvLogLevel::NVLL_ERROR);
-    verifyResponseStatus(appxml);
+    return parseAppList(getAppListResponse());
+}
+
+QByteArray
+NvHTTP::getAppListResponse()
+{
+    QNetworkReply* reply = openConnection(m_BaseUrlHttps,
+                                          "applist",
+                                          nullptr,
+                                          REQUEST_TIMEOUT_MS,
+                                          NvLogLevel::NVLL_ERROR);
+    QByteArray appListXml = reply->readAll();
+    delete reply;
 
-    QXmlStreamReader xmlReader(appxml);
+    return appListXml;
+}
+
+QVector<NvApp>
+NvHTTP::parseAppList(const QByteArray& appListXml)
+{
+    // Hosts with large libraries can return hundreds of apps, so we read the
+    // UTF-8 bytes directly in a single pass rather than decoding the whole
+    // response into a QString and walking it again to check the status.
+    QXmlStreamReader xmlReader(appListXml);
     QVector<NvApp> apps;
+    bool hasRoot = false;
+
     while (!xmlReader.atEnd()) {
         while (xmlReader.readNextStartElement()) {
             auto name = xmlReader.name();
-            if (name == QString("App")) {
+            if (name == QLatin1String("root")) {
+                // See verifyResponseStatus() for why this is parsed unsigned
+                checkResponseStatus((int)xmlReader.attributes().value(QLatin1String("status_code")).toUInt(),
+                                    xmlReader.attributes().value(QLatin1String("status_message")).toString());
+                hasRoot = true;
+            }
+            else if (!hasRoot) {
+                throw GfeHttpResponseException(-1, "Malformed XML (missing root element)");
+            }
+            else if (name == QLatin1String("App")) {
                 // We must have a valid app before advancing to the next one
                 if (!apps.isEmpty() && !apps.last().isInitialized()) {
                     qWarning() << "Invalid applist XML";
@@ -308,21 +453,32 @@ NvHTTP::getAppList()
                 }
                 apps.append(NvApp());
             }
-            else if (name == QString("AppTitle")) {
+            else if (apps.isEmpty()) {
+                xmlReader.skipCurrentElement();
+            }
+            else if (name == QLatin1String("AppTitle")) {
                 apps.last().name = xmlReader.readElementText();
             }
-            else if (name == QString("ID")) {
+            else if (name == QLatin1String("ID")) {
                 apps.last().id = xmlReader.readElementText().toInt();
             }
-            else if (name == QString("IsHdrSupported")) {
-                apps.last().hdrSupported = xmlReader.readElementText() == "1";
+            else if (name == QLatin1String("IsHdrSupported")) {
+                apps.last().hdrSupported = xmlReader.readElementText() == QLatin1String("1");
+            }
+            else if (name == QLatin1String("IsAppCollectorGame")) {
+                apps.last().isAppCollectorGame = xmlReader.readElementText() == QLatin1String("1");
             }
-            else if (name == QString("IsAppCollectorGame")) {
-                apps.last().isAppCollectorGame = xmlReader.readElementText() == "1";
+            else {
+                // Skip anything we don't use without descending into it
+                xmlReader.skipCurrentElement();
             }
         }
     }
 
+    if (!hasRoot) {
+        throw GfeHttpResponseException(-1, "Malformed XML (missing root element)");
+    }
+
     return apps;
 }
 
@@ -338,33 +494,48 @@ NvHTTP::verifyResponseStatus(QString xml)
             // Status code can be 0xFFFFFFFF in some rare cases on GFE 3.20.3, and
             // QString::toInt() will fail in that case, so use QString::toUInt()
             // and cast the result to an int instead.
-            int statusCode = (int)xmlReader.attributes().value("status_code").toUInt();
-            if (statusCode == 200)
-            {
-                // Successful
-                return;
-            }
-            else
-            {
-                QString statusMessage = xmlReader.attributes().value("status_message").toString();
-                if (statusCode != 401) {
-                    // 401 is expected for unpaired PCs when we fetch serverinfo over HTTPS
-                    qWarning() << "Request failed:" << statusCode << statusMessage;
-                }
-                if (statusCode == -1 && statusMessage == "Invalid") {
-                    // Special case handling an audio capture error which GFE doesn't
-                    // provide any useful status message for.
-                    statusCode = 418;
-                    statusMessage = tr("Missing audio capture device. Reinstalling GeForce Experience should resolve this error.");
-                }
-                throw GfeHttpResponseException(statusCode, statusMessage);
-            }
+            checkResponseStatus((int)xmlReader.attributes().value("status_code").toUInt(),
+                                xmlReader.attributes().value("status_message").toString());
+            return;
         }
     }
 
     throw GfeHttpResponseException(-1, "Malformed XML (missing root element)");
 }
 
+void
+NvHTTP::verifyResponseStatus(const NvServerInfo& serverInfo)
+{
+    if (!serverInfo.hasRoot)
+    {
+        throw GfeHttpResponseException(-1, "Malformed XML (missing root element)");
+    }
+
+    checkResponseStatus(serverInfo.statusCode, serverInfo.statusMessage);
+}
+
+void
+NvHTTP::checkResponseStatus(int statusCode, QString statusMessage)
+{
+    if (statusCode == 200)
+    {
+        // Successful
+        return;
+    }
+
+    if (statusCode != 401) {
+        // 401 is expected for unpaired PCs when we fetch serverinfo over HTTPS
+        qWarning() << "Request failed:" << statusCode << statusMessage;
+    }
+    if (statusCode == -1 && statusMessage == "Invalid") {
+        // Special case handling an audio capture error which GFE doesn't
+        // provide any useful status message for.
+        statusCode = 418;
+        statusMessage = tr("Missing audio capture device. Reinstalling GeForce Experience should resolve this error.");
+    }
+    throw GfeHttpResponseException(statusCode, statusMessage);
+}
+
 QImage
 NvHTTP::getBoxArt(int appId)
 {
@@ -437,6 +608,249 @@ void NvHTTP::handleSslErrors(QNetworkReply* reply, const QList<QSslError>& error
     }
 }
 
+QNetworkRequest
+NvHTTP::createRequest(QUrl baseUrl,
+                      QString command,
+                      QString arguments)
+{
+    // Port must be set
+    Q_ASSERT(baseUrl.port(0) != 0);
+
+    // Build a URL for the request
+    QUrl url(baseUrl);
+    url.setPath("/" + command);
+
+    // Use a common UID for Moonlight clients to allow them to quit
+    // games for each other (otherwise GFE gets screwed up and it requires
+    // manual intervention to solve).
+    url.setQuery("uniqueid=0123456789ABCDEF&uuid=" +
+                 QUuid::createUuid().toRfc4122().toHex() +
+                 ((arguments != nullptr) ? ("&" + arguments) : ""));
+
+    QNetworkRequest request(url);
+
+    // Add our client certificate, resuming our last TLS session with this host
+    if (url.scheme() == "https") {
+        request.setSslConfiguration(IdentityManager::get()->getSslConfig(getSslSessionKey(url)));
+    }
+    else {
+        request.setSslConfiguration(IdentityManager::get()->getSslConfig());
+    }
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    // Disable HTTP/2 (GFE 3.22 doesn't like it) and Qt 6 enables it by default
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, false);
+#endif
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+    // Use fine-grained idle timeouts to avoid calling QNetworkAccessManager::clearAccessCache(),
+    // which tears down the NAM's global thread each time. We must not keep persistent connections
+    // or GFE will puke.
+    request.setAttribute(QNetworkRequest::ConnectionCacheExpiryTimeoutSecondsAttribute, 0);
+#endif
+
+    return request;
+}
+
+QString
+NvHTTP::getSslSessionKey(const QUrl& url)
+{
+    // Sessions are tied to the pinned certificate too, so a session
+    // can't outlive re-pairing with a host that has a new certificate.
+    return url.host() + ":" + QString::number(url.port()) + "/" +
+            m_ServerCert.digest(QCryptographicHash::Sha256).toHex();
+}
+
+void
+NvHTTP::updateSslSession(QNetworkReply* reply)
+{
+    if (reply->url().scheme() != "https") {
+        return;
+    }
+
+    if (reply->error() == QNetworkReply::NoError) {
+        IdentityManager::get()->saveSslSession(getSslSessionKey(reply->url()), reply->sslConfiguration());
+    }
+    else if (reply->error() == QNetworkReply::SslHandshakeFailedError) {
+        // Do a full handshake next time
+        IdentityManager::get()->clearSslSession(getSslSessionKey(reply->url()));
+    }
+}
+
+NvHttpRequest*
+NvHTTP::openConnectionAsync(QUrl baseUrl,
+                            QString command,
+                            QString arguments,
+                            int timeoutMs,
+                            NvLogLevel logLevel,
+                            NvHttpRequest::Callback callback)
+{
+    QNetworkRequest request = createRequest(baseUrl, command, arguments);
+
+    if (logLevel >= NvLogLevel::NVLL_VERBOSE) {
+        qInfo() << "Executing request:" << request.url().toString();
+    }
+
+    return startAsyncRequest(m_Nam->get(request), command, timeoutMs, logLevel, callback);
+}
+
+NvHttpRequest*
+NvHTTP::openConnectionAsync(QUrl baseUrl,
+                            QString command,
+                            QString arguments,
+                            const QByteArray& requestBody,
+                            int timeoutMs,
+                            NvLogLevel logLevel,
+                            NvHttpRequest::Callback callback)
+{
+    QNetworkRequest request = createRequest(baseUrl, command, arguments);
+
+    // Set content type for POST request
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "text/plain;charset=UTF-8");
+
+    if (logLevel >= NvLogLevel::NVLL_VERBOSE) {
+        qInfo() << "Executing POST request:" << request.url().toString();
+    }
+
+    return startAsyncRequest(m_Nam->post(request, requestBody), command, timeoutMs, logLevel, callback);
+}
+
+NvHttpRequest*
+NvHTTP::startAsyncRequest(QNetworkReply* reply,
+                          QString command,
+                          int timeoutMs,
+                          NvLogLevel logLevel,
+                          NvHttpRequest::Callback callback)
+{
+    // Connect to the reply rather than the NAM, since other requests
+    // may be in flight on the same NAM at the same time.
+    connect(reply, &QNetworkReply::sslErrors, this, [this, reply](const QList<QSslError>& errors) {
+        handleSslErrors(reply, errors);
+    });
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+        updateSslSession(reply);
+    });
+
+    NvHttpRequest* request = new NvHttpRequest(this, reply, command, timeoutMs, logLevel, callback);
+    connect(request, &QObject::destroyed, this, &NvHTTP::handleAsyncRequestDestroyed);
+    m_AsyncRequestsInFlight++;
+
+    return request;
+}
+
+void NvHTTP::handleAsyncRequestDestroyed()
+{
+    m_AsyncRequestsInFlight--;
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 3, 0)
+    // If we couldn't use fine-grained connection idle timeouts, kill them
+    // all once there are no other requests that may be using them.
+    if (m_AsyncRequestsInFlight == 0) {
+        m_Nam->clearAccessCache();
+    }
+#endif
+}
+
+NvHttpRequest::NvHttpRequest(QObject* parent, QNetworkReply* reply, QString command,
+                             int timeoutMs, int logLevel, Callback callback) :
+    QObject(parent),
+    m_Reply(reply),
+    m_Command(command),
+    m_LogLevel(logLevel),
+    m_Callback(callback),
+    m_TimedOut(false),
+    m_Cancelled(false)
+{
+    connect(m_Reply, &QNetworkReply::finished, this, &NvHttpRequest::handleFinished);
+    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &NvHttpRequest::cancel);
+
+    if (timeoutMs) {
+        m_TimeoutTimer.setSingleShot(true);
+        connect(&m_TimeoutTimer, &QTimer::timeout, this, &NvHttpRequest::handleTimeout);
+        m_TimeoutTimer.start(timeoutMs);
+    }
+}
+
+NvHttpRequest::~NvHttpRequest()
+{
+    if (m_Reply != nullptr) {
+        // Don't run the callback for a request that nobody is waiting for
+        disconnect(m_Reply, nullptr, this, nullptr);
+        m_Reply->abort();
+        delete m_Reply;
+    }
+}
+
+void NvHttpRequest::cancel()
+{
+    if (m_Reply != nullptr && !m_Reply->isFinished()) {
+        m_Cancelled = true;
+
+        // This finishes the reply synchronously
+        m_Reply->abort();
+    }
+}
+
+void NvHttpRequest::handleTimeout()
+{
+    if (m_Reply != nullptr && !m_Reply->isFinished()) {
+        if (m_LogLevel >= NvHTTP::NVLL_ERROR) {
+            qWarning() << "Aborting timed out request for" << m_Reply->url().toString();
+        }
+
+        m_TimedOut = true;
+        m_Reply->abort();
+    }
+}
+
+void NvHttpRequest::handleFinished()
+{
+    NvHttpResponse response;
+
+    m_TimeoutTimer.stop();
+
+    if (m_Reply->error() == QNetworkReply::NoError) {
+        response.body = m_Reply->readAll();
+    }
+    else {
+        if (m_LogLevel >= NvHTTP::NVLL_ERROR && !m_Cancelled) {
+            qWarning() << m_Command << "request failed with error:" << m_Reply->error();
+        }
+
+        // Report errors the same way the blocking API does
+        if (m_Cancelled) {
+            response.networkError = QNetworkReply::OperationCanceledError;
+            response.errorText = "Request cancelled";
+        }
+        else if (m_TimedOut || m_Reply->error() == QNetworkReply::OperationCanceledError) {
+            response.networkError = QNetworkReply::TimeoutError;
+            response.errorText = "Request timed out";
+        }
+        else if (m_Reply->error() == QNetworkReply::SslHandshakeFailedError) {
+            // This will trigger falling back to HTTP for the serverinfo query
+            // then pairing again to get the updated certificate.
+            response.httpStatusCode = 401;
+            response.errorText = "Server certificate mismatch";
+        }
+        else {
+            response.networkError = m_Reply->error();
+            response.errorText = m_Reply->errorString();
+        }
+    }
+
+    m_Reply->deleteLater();
+    m_Reply = nullptr;
+
+    // The callback may start another request or delete the NvHTTP
+    // that owns us, so we're done with our own state before running it.
+    Callback callback = std::move(m_Callback);
+    deleteLater();
+
+    if (callback) {
+        callback(response);
+    }
+}
+
 QString
 NvHTTP::openConnectionToString(QUrl baseUrl,
                                QString command,
@@ -493,36 +907,8 @@ NvHTTP::openConnection(QUrl baseUrl,
                        int timeoutMs,
                        NvLogLevel logLevel)
 {
-    // Port must be set
-    Q_ASSERT(baseUrl.port(0) != 0);
-
-    // Build a URL for the request
-    QUrl url(baseUrl);
-    url.setPath("/" + command);
-
-    // Use a common UID for Moonlight clients to allow them to quit
-    // games for each other (otherwise GFE gets screwed up and it requires
-    // manual intervention to solve).
-    url.setQuery("uniqueid=0123456789ABCDEF&uuid=" +
-                 QUuid::createUuid().toRfc4122().toHex() +
-                 ((arguments != nullptr) ? ("&" + arguments) : ""));
-
-    QNetworkRequest request(url);
-
-    // Add our client certificate
-    request.setSslConfiguration(IdentityManager::get()->getSslConfig());
-
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-    // Disable HTTP/2 (GFE 3.22 doesn't like it) and Qt 6 enables it by default
-    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, false);
-#endif
-
-#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
-    // Use fine-grained idle timeouts to avoid calling QNetworkAccessManager::clearAccessCache(),
-    // which tears down the NAM's global thread each time. We must not keep persistent connections
-    // or GFE will puke.
-    request.setAttribute(QNetworkRequest::ConnectionCacheExpiryTimeoutSecondsAttribute, 0);
-#endif
+    QNetworkRequest request = createRequest(baseUrl, command, arguments);
+    QUrl url = request.url();
 
     auto sslErrorsConnection = connect(m_Nam, &QNetworkAccessManager::sslErrors, this, &NvHTTP::handleSslErrors);
     QNetworkReply* reply = m_Nam->get(request);
@@ -548,6 +934,8 @@ NvHTTP::openConnection(QUrl baseUrl,
         reply->abort();
     }
 
+    updateSslSession(reply);
+
 #if QT_VERSION < QT_VERSION_CHECK(6, 3, 0)
     // If we couldn't use fine-grained connection idle timeouts, kill them all now
     m_Nam->clearAccessCache();
@@ -591,29 +979,8 @@ NvHTTP::openConnection(QUrl baseUrl,
                        int timeoutMs,
                        NvLogLevel logLevel)
 {
-    // Port must be set
-    Q_ASSERT(baseUrl.port(0) != 0);
-
-    // Build a URL for the request
-    QUrl url(baseUrl);
-    url.setPath("/" + command);
-
-    // Use a common UID for Moonlight clients to allow them to quit
-    // games for each other (otherwise GFE gets screwed up and it requires
-    // manual intervention to solve).
-    url.setQuery("uniqueid=0123456789ABCDEF&uuid=" +
-                 QUuid::createUuid().toRfc4122().toHex() +
-                 ((arguments != nullptr) ? ("&" + arguments) : ""));
-
-    QNetworkRequest request(url);
-
-    // Add our client certificate
-    request.setSslConfiguration(IdentityManager::get()->getSslConfig());
-
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-    // Disable HTTP/2 (GFE 3.22 doesn't like it) and Qt 6 enables it by default
-    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, false);
-#endif
+    QNetworkRequest request = createRequest(baseUrl, command, arguments);
+    QUrl url = request.url();
 
 #if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0) && QT_VERSION < QT_VERSION_CHECK(5, 15, 1) && !defined(QT_NO_BEARERMANAGEMENT)
     // HACK: Set network accessibility to work around QTBUG-80947 (introduced in Qt 5.14.0 and fixed in Qt 5.15.1)
@@ -649,6 +1016,8 @@ NvHTTP::openConnection(QUrl baseUrl,
         reply->abort();
     }
 
+    updateSslSession(reply);
+
     // We must clear out cached authentication and connections or
     // GFE will puke next time
     m_Nam->clearAccessCache();
@@ -9,6 +9,10 @@
 #include <QUrl>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
+#include <QPointer>
+#include <QTimer>
+
+#include <functional>
 
 class NvComputer;
 
@@ -28,6 +32,53 @@ public:
 };
 Q_DECLARE_TYPEINFO(NvDisplayMode, Q_PRIMITIVE_TYPE);
 
+// A serverinfo response decoded in a single pass over the XML. String
+// fields are null if the host didn't send that element.
+class NvServerInfo
+{
+public:
+    NvServerInfo() :
+        hasRoot(false),
+        statusCode(-1)
+    {
+
+    }
+
+    // GFE 2.8 started keeping currentgame set to the last game played. As a result, it no longer
+    // has the semantics that its name would indicate. To contain the effects of this change as much
+    // as possible, we'll force the current game to zero if the server isn't in a streaming session.
+    int currentGameId() const
+    {
+        if (state.endsWith("_SERVER_BUSY")) {
+            return currentGame.toInt();
+        }
+        else {
+            return 0;
+        }
+    }
+
+    bool hasRoot;
+    int statusCode;
+    QString statusMessage;
+
+    QString hostname;
+    QString uniqueId;
+    QString mac;
+    QString localIp;
+    QString externalIp;
+    QString httpsPort;
+    QString externalPort;
+    QString state;
+    QString pairStatus;
+    QString currentGame;
+    QString appVersion;
+    QString gfeVersion;
+    QString gpuType;
+    QString serverCodecModeSupport;
+    QString maxLumaPixelsHEVC;
+    QVector<NvDisplayMode> displayModes;
+};
+
 class GfeHttpResponseException : public std::exception
 {
 public:
@@ -98,6 +149,81 @@ private:
     QByteArray m_ErrorText;
 };
 
+// The result of an asynchronous request
+class NvHttpResponse
+{
+public:
+    NvHttpResponse() :
+        networkError(QNetworkReply::NoError),
+        httpStatusCode(200)
+    {
+
+    }
+
+    bool isSuccess() const
+    {
+        return networkError == QNetworkReply::NoError && httpStatusCode == 200;
+    }
+
+    // Throws the same exception the blocking API would have for this failure
+    void throwIfFailed() const
+    {
+        if (httpStatusCode != 200) {
+            throw GfeHttpResponseException(httpStatusCode, errorText);
+        }
+        else if (networkError != QNetworkReply::NoError) {
+            throw QtNetworkReplyException(networkError, errorText);
+        }
+    }
+
+    QString toString() const
+    {
+        return QString::fromUtf8(body);
+    }
+
+    QNetworkReply::NetworkError networkError;
+    int httpStatusCode;
+    QString errorText;
+    QByteArray body;
+};
+
+// A request in flight on the NvHTTP's QNetworkAccessManager. It is deleted
+// after its callback runs, so hold it in a QPointer to cancel it later.
+class NvHttpRequest : public QObject
+{
+    Q_OBJECT
+
+    friend class NvHTTP;
+
+public:
+    typedef std::function<void(const NvHttpResponse&)> Callback;
+
+    // Destroying an unfinished request aborts it without running the callback
+    ~NvHttpRequest();
+
+public slots:
+    // Completes the request with OperationCanceledError
+    void cancel();
+
+private:
+    NvHttpRequest(QObject* parent, QNetworkReply* reply, QString command,
+                  int timeoutMs, int logLevel, Callback callback);
+
+    void handleTimeout();
+
+    void handleFinished();
+
+    // The reply belongs to the QNetworkAccessManager, which may be destroyed
+    // first if it was created by the NvHTTP that owns this request.
+    QPointer<QNetworkReply> m_Reply;
+    QString m_Command;
+    int m_LogLevel;
+    Callback m_Callback;
+    QTimer m_TimeoutTimer;
+    bool m_TimedOut;
+    bool m_Cancelled;
+};
+
 class NvHTTP : public QObject
 {
     Q_OBJECT
@@ -113,17 +239,29 @@ public:
 
     explicit NvHTTP(NvComputer* computer, QNetworkAccessManager* nam = nullptr);
 
-    static
-    int
-    getCurrentGame(QString serverInfo);
-
-    QString
+    NvServerInfo
     getServerInfo(NvLogLevel logLevel, bool fastFail = false);
 
+    typedef std::function<void(const NvHttpResponse&, const NvServerInfo&)> ServerInfoCallback;
+
+    // Asynchronous version of getServerInfo(). This may take more than one
+    // request, so it's cancelled by destroying this NvHTTP object rather than
+    // through a request handle.
+    void
+    getServerInfoAsync(NvLogLevel logLevel, bool fastFail, ServerInfoCallback callback);
+
+    static
+    NvServerInfo
+    parseServerInfo(const QString& xml);
+
     static
     void
     verifyResponseStatus(QString xml);
 
+    static
+    void
+    verifyResponseStatus(const NvServerInfo& serverInfo);
+
     static
     QString
     getXmlString(QString xml,
@@ -149,6 +287,26 @@ public:
                            int timeoutMs,
                            NvLogLevel logLevel = NvLogLevel::NVLL_VERBOSE);
 
+    // These don't block. The callback runs on this object's thread once the
+    // request completes, times out, or is cancelled. Any number of requests
+    // can be in flight on the same QNetworkAccessManager.
+    NvHttpRequest*
+    openConnectionAsync(QUrl baseUrl,
+                        QString command,
+                        QString arguments,
+                        int timeoutMs,
+                        NvLogLevel logLevel,
+                        NvHttpRequest::Callback callback);
+
+    NvHttpRequest*
+    openConnectionAsync(QUrl baseUrl,
+                        QString command,
+                        QString arguments,
+                        const QByteArray& requestBody,
+                        int timeoutMs,
+                        NvLogLevel logLevel,
+                        NvHttpRequest::Callback callback);
+
     void setServerCert(QSslCertificate serverCert);
 
     void setAddress(NvAddress address);
@@ -183,6 +341,15 @@ public:
     QVector<NvApp>
     getAppList();
 
+    // Returns the raw applist XML, so callers can tell whether it
+    // changed since the last fetch before paying to parse it
+    QByteArray
+    getAppListResponse();
+
+    static
+    QVector<NvApp>
+    parseAppList(const QByteArray& appListXml);
+
     QImage
     getBoxArt(int appId);
 
@@ -192,16 +359,41 @@ public:
     void
     setClipboard(const QString& text);
 
-    static
-    QVector<NvDisplayMode>
-    getDisplayModeList(QString serverInfo);
-
     QUrl m_BaseUrlHttp;
     QUrl m_BaseUrlHttps;
 private:
+    static
+    void
+    checkResponseStatus(int statusCode, QString statusMessage);
+
+    static
+    NvServerInfo
+    parseServerInfoResponse(NvHttpResponse& response);
+
     void
     handleSslErrors(QNetworkReply* reply, const QList<QSslError>& errors);
 
+    QNetworkRequest
+    createRequest(QUrl baseUrl,
+                  QString command,
+                  QString arguments);
+
+    QString
+    getSslSessionKey(const QUrl& url);
+
+    void
+    updateSslSession(QNetworkReply* reply);
+
+    NvHttpRequest*
+    startAsyncRequest(QNetworkReply* reply,
+                      QString command,
+                      int timeoutMs,
+                      NvLogLevel logLevel,
+                      NvHttpRequest::Callback callback);
+
+    void
+    handleAsyncRequestDestroyed();
+
     QNetworkReply*
     openConnection(QUrl baseUrl,
                    QString command,
@@ -220,4 +412,5 @@ private:
     NvAddress m_Address;
     QNetworkAccessManager* m_Nam;
     QSslCertificate m_ServerCert;
+    int m_AsyncRequestsInFlight;
 };
@@ -0,0 +1,358 @@
+#include "pollingscheduler.h"
+
+#include <QCryptographicHash>
+#include <QEventLoop>
+#include <QRandomGenerator>
+#include <QThreadStorage>
+#include <QTimer>
+
+#define TRIES_BEFORE_OFFLINING 2
+#define POLLS_PER_APPLIST_FETCH 10
+
+// Polls run in parallel on this many worker threads at most
+#define POLL_WORKER_THREADS 4
+
+// Online hosts are polled every 3 seconds, give or take the jitter
+#define POLL_INTERVAL_MS 3000
+#define POLL_JITTER_PCT 10
+
+// Offline hosts back off exponentially up to this interval
+#define MAX_OFFLINE_POLL_INTERVAL_MS 15000
+
+// Delay before probing each additional address of a host, unless the
+// probes already started have all failed
+#define PROBE_STAGGER_MS 250
+
+// Each worker thread keeps its own QNetworkAccessManager, which must only be
+// used on the thread that created it. Each one also spawns a thread of its
+// own, so sharing it across polls keeps us from creating one per request.
+static QThreadStorage<QNetworkAccessManager*> s_WorkerNam;
+
+class PollTask : public QRunnable
+{
+public:
+    PollTask(PollingScheduler* scheduler, QSharedPointer<PollingScheduler::PollEntry> entry)
+        : m_Scheduler(scheduler),
+          m_Entry(entry) {}
+
+    void run() override
+    {
+        m_Scheduler->pollComputer(m_Entry);
+    }
+
+private:
+    PollingScheduler* m_Scheduler;
+    QSharedPointer<PollingScheduler::PollEntry> m_Entry;
+};
+
+PollingScheduler::PollingScheduler()
+    : m_Stopping(false)
+{
+    setObjectName("Polling Scheduler");
+
+    m_WorkerPool.setMaxThreadCount(POLL_WORKER_THREADS);
+    m_Clock.start();
+}
+
+PollingScheduler::~PollingScheduler()
+{
+    {
+        QMutexLocker lock(&m_Mutex);
+
+        m_Stopping = true;
+        m_Condition.wakeAll();
+    }
+
+    wait();
+
+    removeAllComputers();
+    m_WorkerPool.waitForDone();
+}
+
+void PollingScheduler::addComputer(NvComputer* computer)
+{
+    QMutexLocker lock(&m_Mutex);
+
+    QSharedPointer<PollEntry> entry = m_Entries.value(computer);
+    if (entry.isNull()) {
+        entry.reset(new PollEntry());
+        entry->computer = computer;
+
+        // Always fetch the applist the first time
+        entry->pollsSinceLastAppListFetch = POLLS_PER_APPLIST_FETCH;
+        m_Entries.insert(computer, entry);
+    }
+
+    // Poll now, even if the host has been offline for a while. If a poll
+    // is already in progress, it will schedule another when it's done.
+    entry->consecutiveFailures = 0;
+    entry->nextPollMs = m_Clock.elapsed();
+    entry->pollAgain = m_PollsInProgress.contains(computer);
+
+    m_Condition.wakeAll();
+}
+
+void PollingScheduler::removeComputer(NvComputer* computer)
+{
+    QMutexLocker lock(&m_Mutex);
+
+    QSharedPointer<PollEntry> entry = m_Entries.take(computer);
+    if (!entry.isNull()) {
+        entry->cancelled.storeRelease(1);
+    }
+
+    // This can also be a poll for an entry that was removed earlier
+    while (m_PollsInProgress.contains(computer)) {
+        m_Condition.wait(&m_Mutex);
+    }
+}
+
+void PollingScheduler::removeAllComputers()
+{
+    QMutexLocker lock(&m_Mutex);
+
+    for (const QSharedPointer<PollEntry>& entry : std::as_const(m_Entries)) {
+        entry->cancelled.storeRelease(1);
+    }
+
+    m_Entries.clear();
+}
+
+int PollingScheduler::getPollIntervalMs(int consecutiveFailures)
+{
+    int intervalMs = POLL_INTERVAL_MS;
+
+    // Double the interval for each poll that found the host offline
+    for (int i = 1; i < consecutiveFailures && intervalMs < MAX_OFFLINE_POLL_INTERVAL_MS; i++) {
+        intervalMs *= 2;
+    }
+    intervalMs = qMin(intervalMs, MAX_OFFLINE_POLL_INTERVAL_MS);
+
+    // Spread out polls of hosts that were added at the same time
+    int jitterMs = intervalMs * POLL_JITTER_PCT / 100;
+    return intervalMs - jitterMs + QRandomGenerator::global()->bounded(2 * jitterMs + 1);
+}
+
+void PollingScheduler::run()
+{
+    QMutexLocker lock(&m_Mutex);
+
+    while (!m_Stopping) {
+        qint64 nowMs = m_Clock.elapsed();
+        qint64 nextDeadlineMs = -1;
+
+        for (const QSharedPointer<PollEntry>& entry : std::as_const(m_Entries)) {
+            // Only one poll at a time for each host
+            if (m_PollsInProgress.contains(entry->computer)) {
+                continue;
+            }
+
+            if (entry->nextPollMs <= nowMs) {
+                m_PollsInProgress.insert(entry->computer);
+                m_WorkerPool.start(new PollTask(this, entry));
+            }
+            else if (nextDeadlineMs < 0 || entry->nextPollMs < nextDeadlineMs) {
+                nextDeadlineMs = entry->nextPollMs;
+            }
+        }
+
+        // Sleep until the next host is due or we're woken up by a poll
+        // completing or a host being added.
+        if (nextDeadlineMs < 0) {
+            m_Condition.wait(&m_Mutex);
+        }
+        else {
+            m_Condition.wait(&m_Mutex, (unsigned long)(nextDeadlineMs - nowMs));
+        }
+    }
+}
+
+bool PollingScheduler::probeComputer(QNetworkAccessManager* nam, QSharedPointer<PollEntry> entry, bool& changed)
+{
+    NvComputer* computer = entry->computer;
+    QVector<NvAddress> addresses = computer->uniqueAddresses();
+    QVector<NvHTTP*> probes;
+    QEventLoop loop;
+    QTimer staggerTimer;
+    QTimer cancelTimer;
+    int nextAddress = 0;
+    int probesInFlight = 0;
+    bool online = false;
+
+    // Probe the addresses in order of preference, starting another one each
+    // time the stagger delay passes without a response. The first host to
+    // respond wins, so an unreachable address doesn't cost a full timeout
+    // before the next one is tried.
+    std::function<void()> startNextProbe = [&]() {
+        if (nextAddress >= addresses.count()) {
+            staggerTimer.stop();
+            return;
+        }
+
+        NvHTTP* http = new NvHTTP(addresses[nextAddress++], 0, computer->serverCert, nam);
+        probes.append(http);
+        probesInFlight++;
+
+        http->getServerInfoAsync(NvHTTP::NvLogLevel::NVLL_NONE, true,
+                                 [&, http](const NvHttpResponse& response, const NvServerInfo& serverInfo) {
+            probesInFlight--;
+
+            if (!online && response.isSuccess()) {
+                NvComputer newState(*http, serverInfo);
+
+                // Ensure the machine that responded is the one we intended to contact
+                if (computer->uuid == newState.uuid) {
+                    changed = computer->update(newState);
+                    online = true;
+                    loop.quit();
+                    return;
+                }
+
+                qInfo() << "Found unexpected PC" << newState.name << "looking for" << computer->name;
+            }
+
+            // Don't wait out the stagger delay if nothing else is in flight
+            if (probesInFlight == 0) {
+                startNextProbe();
+                if (probesInFlight == 0) {
+                    loop.quit();
+                }
+            }
+        });
+    };
+
+    connect(&staggerTimer, &QTimer::timeout, &loop, [&]() { startNextProbe(); });
+    staggerTimer.start(PROBE_STAGGER_MS);
+
+    connect(&cancelTimer, &QTimer::timeout, &loop, [&]() {
+        if (entry->cancelled.loadAcquire()) {
+            loop.quit();
+        }
+    });
+    cancelTimer.start(100);
+
+    startNextProbe();
+    if (probesInFlight != 0) {
+        loop.exec(QEventLoop::ExcludeUserInputEvents);
+    }
+
+    // Destroying the other probes aborts their requests without running callbacks
+    qDeleteAll(probes);
+    return online;
+}
+
+bool PollingScheduler::updateAppList(QNetworkAccessManager* nam, QSharedPointer<PollEntry> entry, bool& changed)
+{
+    NvComputer* computer = entry->computer;
+    NvHTTP http(computer, nam);
+
+    QByteArray appListXml;
+    QByteArray appListHash;
+    QVector<NvApp> appList;
+
+    try {
+        appListXml = http.getAppListResponse();
+        appListHash = QCryptographicHash::hash(appListXml, QCryptographicHash::Sha256);
+
+        // Most refreshes return exactly what we got last time, so don't bother
+        // parsing and merging the list (or waking up the UI) unless it changed.
+        // We still parse if our list was emptied since the last fetch.
+        if (appListHash == entry->lastAppListHash) {
+            QReadLocker lock(&computer->lock);
+            if (!computer->appList.isEmpty()) {
+                return true;
+            }
+        }
+
+        appList = NvHTTP::parseAppList(appListXml);
+        if (appList.isEmpty()) {
+            return false;
+        }
+    } catch (...) {
+        return false;
+    }
+
+    entry->lastAppListHash = appListHash;
+
+    QWriteLocker lock(&computer->lock);
+    changed = computer->updateAppList(appList);
+    return true;
+}
+
+void PollingScheduler::pollComputer(QSharedPointer<PollEntry> entry)
+{
+    NvComputer* computer = entry->computer;
+
+    // Reduce the power and performance impact of our
+    // computer status polling while it's running.
+    QThread::currentThread()->setPriority(QThread::LowPriority);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 9, 0)
+    QThread::currentThread()->setServiceLevel(QThread::QualityOfService::Eco);
+#endif
+
+    if (!s_WorkerNam.hasLocalData()) {
+        s_WorkerNam.setLocalData(new QNetworkAccessManager());
+    }
+    QNetworkAccessManager* nam = s_WorkerNam.localData();
+
+    bool stateChanged = false;
+    bool online = false;
+    bool wasOnline = computer->state == NvComputer::CS_ONLINE;
+    for (int i = 0; i < (wasOnline ? TRIES_BEFORE_OFFLINING : 1) && !online && !entry->cancelled.loadAcquire(); i++) {
+        if (probeComputer(nam, entry, stateChanged)) {
+            if (!wasOnline) {
+                qInfo() << computer->name << "is now online at" << computer->activeAddress.toString();
+            }
+            online = true;
+        }
+    }
+
+    // Check if we failed after all retry attempts. We don't need to acquire
+    // the read lock here, because only one poll runs for each host at a time.
+    if (!online && !entry->cancelled.loadAcquire() && computer->state != NvComputer::CS_OFFLINE) {
+        qInfo() << computer->name << "is now offline";
+        computer->state = NvComputer::CS_OFFLINE;
+        stateChanged = true;
+    }
+
+    // Grab the applist if it's empty or it's been long enough that we need to refresh
+    entry->pollsSinceLastAppListFetch++;
+    if (!entry->cancelled.loadAcquire() &&
+            computer->state == NvComputer::CS_ONLINE &&
+            computer->pairState == NvComputer::PS_PAIRED &&
+            (computer->appList.isEmpty() || entry->pollsSinceLastAppListFetch >= POLLS_PER_APPLIST_FETCH)) {
+        // Notify prior to the app list poll since it may take a while, and we don't
+        // want to delay onlining of a machine, especially if we already have a cached list.
+        if (stateChanged) {
+            emit computerStateChanged(computer);
+            stateChanged = false;
+        }
+
+        if (updateAppList(nam, entry, stateChanged)) {
+            entry->pollsSinceLastAppListFetch = 0;
+        }
+    }
+
+    if (stateChanged) {
+        // Tell anyone listening that we've changed state
+        emit computerStateChanged(computer);
+    }
+
+    QMutexLocker lock(&m_Mutex);
+
+    if (entry->pollAgain) {
+        // addComputer() was called during this poll
+        entry->pollAgain = false;
+        entry->consecutiveFailures = 0;
+        entry->nextPollMs = m_Clock.elapsed();
+    }
+    else {
+        entry->consecutiveFailures = online ? 0 : entry->consecutiveFailures + 1;
+        entry->nextPollMs = m_Clock.elapsed() + getPollIntervalMs(entry->consecutiveFailures);
+    }
+    m_PollsInProgress.remove(computer);
+
+    // Wake the scheduler to pick up the new deadline and anybody
+    // waiting in removeComputer() for this poll to finish.
+    m_Condition.wakeAll();
+}
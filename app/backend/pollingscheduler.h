@@ -0,0 +1,76 @@
+#pragma once
+
+#include "nvcomputer.h"
+
+#include <QThread>
+#include <QThreadPool>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QSharedPointer>
+#include <QAtomicInt>
+#include <QMap>
+#include <QSet>
+#include <QByteArray>
+
+// Polls every known host from one scheduler thread and a small pool of
+// worker threads, so the number of threads and network access managers
+// doesn't grow with the number of hosts. Each host has its own deadline
+// for the next poll. Intervals are jittered to keep hosts from being polled
+// in lockstep, and hosts that stay offline are polled less often.
+class PollingScheduler : public QThread
+{
+    Q_OBJECT
+
+    friend class PollTask;
+
+public:
+    PollingScheduler();
+
+    // Stops polling and waits for polls in progress to finish
+    virtual ~PollingScheduler();
+
+    // Starts polling the computer, or polls it again right away if
+    // it's already being polled.
+    void addComputer(NvComputer* computer);
+
+    // Stops polling the computer and waits for a poll in progress to finish,
+    // after which the computer can be safely deleted.
+    void removeComputer(NvComputer* computer);
+
+    // Stops polling all computers without waiting for polls in progress
+    void removeAllComputers();
+
+signals:
+    void computerStateChanged(NvComputer* computer);
+
+private:
+    struct PollEntry {
+        NvComputer* computer;
+        qint64 nextPollMs;
+        int consecutiveFailures;
+        bool pollAgain;
+        int pollsSinceLastAppListFetch;
+        QByteArray lastAppListHash;
+        QAtomicInt cancelled;
+    };
+
+    void run() override;
+
+    void pollComputer(QSharedPointer<PollEntry> entry);
+
+    bool probeComputer(QNetworkAccessManager* nam, QSharedPointer<PollEntry> entry, bool& changed);
+
+    bool updateAppList(QNetworkAccessManager* nam, QSharedPointer<PollEntry> entry, bool& changed);
+
+    static
+    int getPollIntervalMs(int consecutiveFailures);
+
+    QThreadPool m_WorkerPool;
+    QMutex m_Mutex;
+    QWaitCondition m_Condition;
+    QElapsedTimer m_Clock;
+    QMap<NvComputer*, QSharedPointer<PollEntry>> m_Entries;
+    QSet<NvComputer*> m_PollsInProgress;
+    bool m_Stopping;
+};
@@ -0,0 +1,69 @@
+#include "benchmarkaudio.h"
+
+#include "streaming/audio/opusbench.h"
+
+#include <Limelight.h>
+
+namespace CliBenchmarkAudio
+{
+
+int run(const BenchmarkAudioCommandLineParser& arguments)
+{
+    static const int k_AudioConfigurations[] = {
+        AUDIO_CONFIGURATION_STEREO,
+        AUDIO_CONFIGURATION_51_SURROUND,
+        AUDIO_CONFIGURATION_71_SURROUND,
+    };
+
+    // 5 ms and 10 ms packets at 48 kHz
+    static const int k_SamplesPerFrame[] = { 240, 480 };
+
+    if (arguments.isPrintCSV()) {
+        fprintf(stdout, "Channels,FrameMs,Output,Packets,MeanUs,P50Us,P90Us,P99Us,MaxUs,LoadPct\n");
+    }
+    else {
+        fprintf(stdout, "%-8s %-6s %-6s %9s %9s %9s %9s %9s %7s\n",
+                "Channels", "Frame", "Output", "Mean us", "P50 us", "P90 us", "P99 us", "Max us", "Load %");
+    }
+
+    for (int audioConfiguration : k_AudioConfigurations) {
+        for (int samplesPerFrame : k_SamplesPerFrame) {
+            for (bool floatOutput : { false, true }) {
+                OpusDecodeBenchmark::RESULT result;
+                if (!OpusDecodeBenchmark::run(CHANNEL_COUNT_FROM_AUDIO_CONFIGURATION(audioConfiguration),
+                                              samplesPerFrame, floatOutput,
+                                              arguments.getPacketCount(), &result)) {
+                    fprintf(stderr, "Benchmark failed for %d channels\n",
+                            CHANNEL_COUNT_FROM_AUDIO_CONFIGURATION(audioConfiguration));
+                    return 1;
+                }
+
+                // Percentage of real time spent decoding on average
+                double frameDurationUs = (double)samplesPerFrame * 1000000.0 / 48000;
+                double loadPct = result.meanUs / frameDurationUs * 100.0;
+
+                if (arguments.isPrintCSV()) {
+                    fprintf(stdout, "%d,%g,%s,%d,%.1f,%.1f,%.1f,%.1f,%.1f,%.2f\n",
+                            result.channelCount,
+                            frameDurationUs / 1000.0,
+                            floatOutput ? "float" : "s16",
+                            result.packetCount,
+                            result.meanUs, result.p50Us, result.p90Us, result.p99Us, result.maxUs,
+                            loadPct);
+                }
+                else {
+                    fprintf(stdout, "%-8d %-6s %-6s %9.1f %9.1f %9.1f %9.1f %9.1f %7.2f\n",
+                            result.channelCount,
+                            samplesPerFrame == 240 ? "5 ms" : "10 ms",
+                            floatOutput ? "float" : "s16",
+                            result.meanUs, result.p50Us, result.p90Us, result.p99Us, result.maxUs,
+                            loadPct);
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+}
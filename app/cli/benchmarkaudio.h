@@ -0,0 +1,11 @@
+#pragma once
+
+#include "commandlineparser.h"
+
+namespace CliBenchmarkAudio
+{
+
+// Runs the Opus decode benchmark and returns the process exit code
+int run(const BenchmarkAudioCommandLineParser& arguments);
+
+}
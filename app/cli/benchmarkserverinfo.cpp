@@ -0,0 +1,193 @@
+#include "benchmarkserverinfo.h"
+
+#include "backend/nvhttp.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QXmlStreamReader>
+
+namespace CliBenchmarkServerInfo
+{
+
+// A serverinfo response from a Sunshine host with a typical set of display modes
+static const char k_SampleServerInfo[] =
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+    "<root status_code=\"200\">"
+    "<hostname>DESKTOP-BENCH</hostname>"
+    "<appversion>7.1.431.-1</appversion>"
+    "<GfeVersion>3.23.0.74</GfeVersion>"
+    "<uniqueid>0123456789ABCDEF</uniqueid>"
+    "<HttpsPort>47984</HttpsPort>"
+    "<ExternalPort>47989</ExternalPort>"
+    "<MaxLumaPixelsHEVC>1869449984</MaxLumaPixelsHEVC>"
+    "<mac>01:23:45:67:89:ab</mac>"
+    "<Permission>4294967295</Permission>"
+    "<LocalIP>192.168.1.20</LocalIP>"
+    "<ServerCodecModeSupport>3843</ServerCodecModeSupport>"
+    "<SupportedDisplayMode>"
+    "<DisplayMode><Width>3840</Width><Height>2160</Height><RefreshRate>120</RefreshRate></DisplayMode>"
+    "<DisplayMode><Width>3840</Width><Height>2160</Height><RefreshRate>60</RefreshRate></DisplayMode>"
+    "<DisplayMode><Width>2560</Width><Height>1440</Height><RefreshRate>144</RefreshRate></DisplayMode>"
+    "<DisplayMode><Width>2560</Width><Height>1440</Height><RefreshRate>60</RefreshRate></DisplayMode>"
+    "<DisplayMode><Width>1920</Width><Height>1080</Height><RefreshRate>144</RefreshRate></DisplayMode>"
+    "<DisplayMode><Width>1920</Width><Height>1080</Height><RefreshRate>60</RefreshRate></DisplayMode>"
+    "</SupportedDisplayMode>"
+    "<PairStatus>1</PairStatus>"
+    "<currentgame>0</currentgame>"
+    "<state>SUNSHINE_SERVER_FREE</state>"
+    "<gputype>NVIDIA GeForce RTX 4080</gputype>"
+    "</root>";
+
+// Decodes the response the way it was done before the single-pass parser:
+// one scan of the document for the status and for each field we use.
+static NvServerInfo parsePerField(const QString& xml)
+{
+    NvServerInfo serverInfo;
+
+    QXmlStreamReader statusReader(xml);
+    while (statusReader.readNextStartElement()) {
+        if (statusReader.name() == QString("root")) {
+            serverInfo.hasRoot = true;
+            serverInfo.statusCode = (int)statusReader.attributes().value("status_code").toUInt();
+            serverInfo.statusMessage = statusReader.attributes().value("status_message").toString();
+            break;
+        }
+    }
+
+    serverInfo.hostname = NvHTTP::getXmlString(xml, "hostname");
+    serverInfo.uniqueId = NvHTTP::getXmlString(xml, "uniqueid");
+    serverInfo.mac = NvHTTP::getXmlString(xml, "mac");
+    serverInfo.serverCodecModeSupport = NvHTTP::getXmlString(xml, "ServerCodecModeSupport");
+    serverInfo.maxLumaPixelsHEVC = NvHTTP::getXmlString(xml, "MaxLumaPixelsHEVC");
+    serverInfo.localIp = NvHTTP::getXmlString(xml, "LocalIP");
+    serverInfo.httpsPort = NvHTTP::getXmlString(xml, "HttpsPort");
+    serverInfo.externalPort = NvHTTP::getXmlString(xml, "ExternalPort");
+    serverInfo.externalIp = NvHTTP::getXmlString(xml, "ExternalIP");
+    serverInfo.state = NvHTTP::getXmlString(xml, "state");
+    serverInfo.pairStatus = NvHTTP::getXmlString(xml, "PairStatus");
+    serverInfo.appVersion = NvHTTP::getXmlString(xml, "appversion");
+    serverInfo.gfeVersion = NvHTTP::getXmlString(xml, "GfeVersion");
+    serverInfo.gpuType = NvHTTP::getXmlString(xml, "gputype");
+
+    // The current game lookup scanned for the state a second time
+    if (NvHTTP::getXmlString(xml, "state").endsWith("_SERVER_BUSY")) {
+        serverInfo.currentGame = NvHTTP::getXmlString(xml, "currentgame");
+    }
+
+    QXmlStreamReader modeReader(xml);
+    while (!modeReader.atEnd()) {
+        while (modeReader.readNextStartElement()) {
+            auto name = modeReader.name();
+            if (name == QString("DisplayMode")) {
+                serverInfo.displayModes.append(NvDisplayMode());
+            }
+            else if (name == QString("Width") && !serverInfo.displayModes.isEmpty()) {
+                serverInfo.displayModes.last().width = modeReader.readElementText().toInt();
+            }
+            else if (name == QString("Height") && !serverInfo.displayModes.isEmpty()) {
+                serverInfo.displayModes.last().height = modeReader.readElementText().toInt();
+            }
+            else if (name == QString("RefreshRate") && !serverInfo.displayModes.isEmpty()) {
+                serverInfo.displayModes.last().refreshRate = modeReader.readElementText().toInt();
+            }
+        }
+    }
+
+    return serverInfo;
+}
+
+static bool isSameServerInfo(const NvServerInfo& a, const NvServerInfo& b)
+{
+    return a.hasRoot == b.hasRoot &&
+           a.statusCode == b.statusCode &&
+           a.hostname == b.hostname &&
+           a.uniqueId == b.uniqueId &&
+           a.mac == b.mac &&
+           a.localIp == b.localIp &&
+           a.externalIp == b.externalIp &&
+           a.httpsPort == b.httpsPort &&
+           a.externalPort == b.externalPort &&
+           a.state == b.state &&
+           a.pairStatus == b.pairStatus &&
+           a.currentGameId() == b.currentGameId() &&
+           a.appVersion == b.appVersion &&
+           a.gfeVersion == b.gfeVersion &&
+           a.gpuType == b.gpuType &&
+           a.serverCodecModeSupport == b.serverCodecModeSupport &&
+           a.maxLumaPixelsHEVC == b.maxLumaPixelsHEVC &&
+           a.displayModes == b.displayModes;
+}
+
+// Returns the mean time per parse in microseconds
+template <typename Parser>
+static double timeParser(Parser parser, const QString& xml, int iterations)
+{
+    QElapsedTimer timer;
+    int checksum = 0;
+
+    timer.start();
+    for (int i = 0; i < iterations; i++) {
+        // Use the result so the work can't be optimized away
+        checksum += parser(xml).displayModes.count();
+    }
+    qint64 elapsedNs = timer.nsecsElapsed();
+
+    if (checksum < 0) {
+        fprintf(stderr, "Unexpected checksum\n");
+    }
+
+    return (double)elapsedNs / iterations / 1000.0;
+}
+
+int run(const BenchmarkServerInfoCommandLineParser& arguments)
+{
+    QString xml;
+
+    if (!arguments.getFileName().isEmpty()) {
+        QFile file(arguments.getFileName());
+        if (!file.open(QIODevice::ReadOnly)) {
+            fprintf(stderr, "Failed to open %s: %s\n",
+                    qPrintable(arguments.getFileName()),
+                    qPrintable(file.errorString()));
+            return 1;
+        }
+        xml = QString::fromUtf8(file.readAll());
+    }
+    else {
+        xml = QString::fromUtf8(k_SampleServerInfo);
+    }
+
+    // Make sure we're comparing parsers that produce the same result
+    NvServerInfo singlePassResult = NvHTTP::parseServerInfo(xml);
+    if (!singlePassResult.hasRoot) {
+        fprintf(stderr, "Response has no root element\n");
+        return 1;
+    }
+    if (!isSameServerInfo(singlePassResult, parsePerField(xml))) {
+        fprintf(stderr, "Parsers returned different results\n");
+        return 1;
+    }
+
+    // Warm up allocations and caches before timing anything
+    timeParser(NvHTTP::parseServerInfo, xml, 100);
+    timeParser(parsePerField, xml, 100);
+
+    double perFieldUs = timeParser(parsePerField, xml, arguments.getIterations());
+    double singlePassUs = timeParser(NvHTTP::parseServerInfo, xml, arguments.getIterations());
+
+    if (arguments.isPrintCSV()) {
+        fprintf(stdout, "Parser,Bytes,Iterations,MeanUs\n");
+        fprintf(stdout, "per-field,%d,%d,%.2f\n", (int)xml.toUtf8().size(), arguments.getIterations(), perFieldUs);
+        fprintf(stdout, "single-pass,%d,%d,%.2f\n", (int)xml.toUtf8().size(), arguments.getIterations(), singlePassUs);
+    }
+    else {
+        fprintf(stdout, "%-12s %9s\n", "Parser", "Mean us");
+        fprintf(stdout, "%-12s %9.2f\n", "per-field", perFieldUs);
+        fprintf(stdout, "%-12s %9.2f\n", "single-pass", singlePassUs);
+        fprintf(stdout, "Speedup: %.1fx\n", perFieldUs / singlePassUs);
+    }
+
+    return 0;
+}
+
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "commandlineparser.h"
+
+namespace CliBenchmarkServerInfo
+{
+
+// Runs the serverinfo parsing benchmark and returns the process exit code
+int run(const BenchmarkServerInfoCommandLineParser& arguments);
+
+}
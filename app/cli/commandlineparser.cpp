@@ -157,10 +157,13 @@ GlobalCommandLineParser::ParseResult GlobalCommandLineParser::parse(const QStrin
         "Starts Moonlight normally if no arguments are given.\n"
         "\n"
         "Available actions:\n"
-        "  list            List the available apps on a host\n"
-        "  quit            Quit the currently running app\n"
-        "  stream          Start streaming an app\n"
-        "  pair            Pair a new host\n"
+        "  list                 List the available apps on a host\n"
+        "  quit                 Quit the currently running app\n"
+        "  stream               Start streaming an app\n"
+        "  pair                 Pair a new host\n"
+        "  benchmark-audio      Measure Opus decoding performance\n"
+        "  replay-input         Replay recorded input to measure input handling cost\n"
+        "  benchmark-serverinfo Measure serverinfo parsing performance\n"
         "\n"
         "See 'moonlight <action> --help' for help of specific action."
     );
@@ -192,6 +195,12 @@ GlobalCommandLineParser::ParseResult GlobalCommandLineParser::parse(const QStrin
                 return PairRequested;
             } else if (action == "list") {
                 return ListRequested;
+            } else if (action == "benchmark-audio") {
+                return BenchmarkAudioRequested;
+            } else if (action == "replay-input") {
+                return ReplayInputRequested;
+            } else if (action == "benchmark-serverinfo") {
+                return BenchmarkServerInfoRequested;
             }
         }
 
@@ -591,3 +600,213 @@ bool ListCommandLineParser::isVerbose() const
 {
     return m_Verbose;
 }
+
+BenchmarkAudioCommandLineParser::BenchmarkAudioCommandLineParser()
+    : m_PacketCount(1000),
+      m_PrintCSV(false)
+{
+}
+
+BenchmarkAudioCommandLineParser::~BenchmarkAudioCommandLineParser()
+{
+}
+
+void BenchmarkAudioCommandLineParser::parse(const QStringList &args)
+{
+    CommandLineParser parser;
+    parser.setupCommonOptions();
+    parser.setApplicationDescription(
+        "\n"
+        "Measure Opus decoding performance for each supported channel\n"
+        "configuration and packet duration using synthetic audio."
+    );
+    parser.addPositionalArgument("benchmark-audio", "measure Opus decoding performance");
+
+    parser.addValueOption("packets", "number of packets to decode per configuration");
+    parser.addFlagOption("csv", "Print as CSV");
+
+    if (!parser.parse(args)) {
+        parser.showError(parser.errorText());
+    }
+
+    parser.handleUnknownOptions();
+
+    // This method will not return and terminates the process if --version or
+    // --help is specified
+    parser.handleHelpAndVersionOptions();
+
+    if (parser.isSet("packets")) {
+        m_PacketCount = parser.getIntOption("packets");
+        if (!inRange(m_PacketCount, 100, 1000000)) {
+            parser.showError("Packet count must be in range: 100 - 1000000");
+        }
+    }
+
+    m_PrintCSV = parser.isSet("csv");
+}
+
+int BenchmarkAudioCommandLineParser::getPacketCount() const
+{
+    return m_PacketCount;
+}
+
+bool BenchmarkAudioCommandLineParser::isPrintCSV() const
+{
+    return m_PrintCSV;
+}
+
+ReplayInputCommandLineParser::ReplayInputCommandLineParser()
+    : m_Iterations(1),
+      m_Realtime(false),
+      m_PrintCSV(false),
+      m_SelfTest(false)
+{
+}
+
+ReplayInputCommandLineParser::~ReplayInputCommandLineParser()
+{
+}
+
+void ReplayInputCommandLineParser::parse(const QStringList &args)
+{
+    CommandLineParser parser;
+    parser.setupCommonOptions();
+    parser.setApplicationDescription(
+        "\n"
+        "Replay input recorded with ML_INPUT_RECORD_FILE through the input\n"
+        "handler without a connection, then report the time spent handling\n"
+        "each type of input and the number of events that would be sent.\n"
+        "With --self-test, a built-in recording is replayed instead and the\n"
+        "events that would be sent are checked against the expected ones."
+    );
+    parser.addPositionalArgument("replay-input", "replay recorded input");
+    parser.addPositionalArgument("file", "Input recording file", "<file>");
+
+    parser.addValueOption("iterations", "number of times to replay the recording");
+    parser.addFlagOption("realtime", "Replay with the original timing between events");
+    parser.addFlagOption("csv", "Print as CSV");
+    parser.addFlagOption("self-test", "Replay the built-in recording and check the result");
+
+    if (!parser.parse(args)) {
+        parser.showError(parser.errorText());
+    }
+
+    parser.handleUnknownOptions();
+
+    // This method will not return and terminates the process if --version or
+    // --help is specified
+    parser.handleHelpAndVersionOptions();
+
+    m_SelfTest = parser.isSet("self-test");
+
+    // Verify that the file has been provided
+    auto posArgs = parser.positionalArguments();
+    if (posArgs.length() >= 2) {
+        m_FileName = posArgs.at(1);
+    }
+    else if (!m_SelfTest) {
+        parser.showError("Recording file not provided");
+    }
+
+    if (parser.isSet("iterations")) {
+        m_Iterations = parser.getIntOption("iterations");
+        if (!inRange(m_Iterations, 1, 10000)) {
+            parser.showError("Iterations must be in range: 1 - 10000");
+        }
+    }
+
+    m_Realtime = parser.isSet("realtime");
+    m_PrintCSV = parser.isSet("csv");
+}
+
+QString ReplayInputCommandLineParser::getFileName() const
+{
+    return m_FileName;
+}
+
+int ReplayInputCommandLineParser::getIterations() const
+{
+    return m_Iterations;
+}
+
+bool ReplayInputCommandLineParser::isRealtime() const
+{
+    return m_Realtime;
+}
+
+bool ReplayInputCommandLineParser::isPrintCSV() const
+{
+    return m_PrintCSV;
+}
+
+bool ReplayInputCommandLineParser::isSelfTest() const
+{
+    return m_SelfTest;
+}
+
+BenchmarkServerInfoCommandLineParser::BenchmarkServerInfoCommandLineParser()
+    : m_Iterations(10000),
+      m_PrintCSV(false)
+{
+}
+
+BenchmarkServerInfoCommandLineParser::~BenchmarkServerInfoCommandLineParser()
+{
+}
+
+void BenchmarkServerInfoCommandLineParser::parse(const QStringList &args)
+{
+    CommandLineParser parser;
+    parser.setupCommonOptions();
+    parser.setApplicationDescription(
+        "\n"
+        "Measure the CPU time spent decoding a serverinfo response on each\n"
+        "host poll, comparing the single-pass parser with scanning the\n"
+        "document once per field. A built-in Sunshine response is used\n"
+        "unless a captured one is provided."
+    );
+    parser.addPositionalArgument("benchmark-serverinfo", "measure serverinfo parsing performance");
+    parser.addPositionalArgument("file", "Captured serverinfo response (optional)", "[<file>]");
+
+    parser.addValueOption("iterations", "number of times to parse the response");
+    parser.addFlagOption("csv", "Print as CSV");
+
+    if (!parser.parse(args)) {
+        parser.showError(parser.errorText());
+    }
+
+    parser.handleUnknownOptions();
+
+    // This method will not return and terminates the process if --version or
+    // --help is specified
+    parser.handleHelpAndVersionOptions();
+
+    auto posArgs = parser.positionalArguments();
+    if (posArgs.length() >= 2) {
+        m_FileName = posArgs.at(1);
+    }
+
+    if (parser.isSet("iterations")) {
+        m_Iterations = parser.getIntOption("iterations");
+        if (!inRange(m_Iterations, 100, 1000000)) {
+            parser.showError("Iterations must be in range: 100 - 1000000");
+        }
+    }
+
+    m_PrintCSV = parser.isSet("csv");
+}
+
+QString BenchmarkServerInfoCommandLineParser::getFileName() const
+{
+    return m_FileName;
+}
+
+int BenchmarkServerInfoCommandLineParser::getIterations() const
+{
+    return m_Iterations;
+}
+
+bool BenchmarkServerInfoCommandLineParser::isPrintCSV() const
+{
+    return m_PrintCSV;
+}
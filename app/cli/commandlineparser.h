@@ -14,6 +14,9 @@ public:
         QuitRequested,
         PairRequested,
         ListRequested,
+        BenchmarkAudioRequested,
+        ReplayInputRequested,
+        BenchmarkServerInfoRequested,
     };
 
     GlobalCommandLineParser();
@@ -91,3 +94,59 @@ private:
     bool m_PrintCSV;
     bool m_Verbose;
 };
+
+class BenchmarkAudioCommandLineParser
+{
+public:
+    BenchmarkAudioCommandLineParser();
+    virtual ~BenchmarkAudioCommandLineParser();
+
+    void parse(const QStringList &args);
+
+    int getPacketCount() const;
+    bool isPrintCSV() const;
+
+private:
+    int m_PacketCount;
+    bool m_PrintCSV;
+};
+
+class ReplayInputCommandLineParser
+{
+public:
+    ReplayInputCommandLineParser();
+    virtual ~ReplayInputCommandLineParser();
+
+    void parse(const QStringList &args);
+
+    QString getFileName() const;
+    int getIterations() const;
+    bool isRealtime() const;
+    bool isPrintCSV() const;
+    bool isSelfTest() const;
+
+private:
+    QString m_FileName;
+    int m_Iterations;
+    bool m_Realtime;
+    bool m_PrintCSV;
+    bool m_SelfTest;
+};
+
+class BenchmarkServerInfoCommandLineParser
+{
+public:
+    BenchmarkServerInfoCommandLineParser();
+    virtual ~BenchmarkServerInfoCommandLineParser();
+
+    void parse(const QStringList &args);
+
+    QString getFileName() const;
+    int getIterations() const;
+    bool isPrintCSV() const;
+
+private:
+    QString m_FileName;
+    int m_Iterations;
+    bool m_PrintCSV;
+};
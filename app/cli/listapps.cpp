@@ -137,7 +137,7 @@ public:
                                                           app.isAppCollectorGame ? "true" : "false",
                                                           app.hidden ? "true" : "false",
                                                           app.directLaunch ? "true" : "false",
-                                                          qPrintable(m_BoxArtManager->loadBoxArt(m_Computer, app).toDisplayString()));
+                                                          qPrintable(m_BoxArtManager->loadBoxArtFile(m_Computer, app).toDisplayString()));
     }
 
     Launcher *q_ptr;
@@ -0,0 +1,703 @@
+#include "replayinput.h"
+
+#include "settings/streamingpreferences.h"
+#include "streaming/input/input.h"
+#include "streaming/input/recorder.h"
+
+#include <QFile>
+#include <QHash>
+#include <QTemporaryFile>
+#include <QVector>
+
+namespace CliReplayInput
+{
+
+enum HandlerType {
+    HandlerKeyboard,
+    HandlerMouseButton,
+    HandlerMouseMotion,
+    HandlerMouseWheel,
+    HandlerGamepadAxis,
+    HandlerGamepadButton,
+    HandlerGamepadDevice,
+    HandlerGamepadSensor,
+    HandlerGamepadTouchpad,
+    HandlerGamepadBattery,
+    HandlerTouch,
+    HandlerMax
+};
+
+static const char* const k_HandlerNames[HandlerMax] = {
+    "Keyboard",
+    "MouseButton",
+    "MouseMotion",
+    "MouseWheel",
+    "GamepadAxis",
+    "GamepadButton",
+    "GamepadDevice",
+    "GamepadSensor",
+    "GamepadTouchpad",
+    "GamepadBattery",
+    "Touch",
+};
+
+typedef struct _REPLAY_STATS {
+    uint32_t handlerCalls[HandlerMax];
+    Uint64 handlerTicks[HandlerMax];
+    uint32_t sentEvents[InputDispatcher::EventTypeMax];
+    uint32_t skippedEvents;
+    Uint64 replayTicks;
+} REPLAY_STATS, *PREPLAY_STATS;
+
+typedef struct _EXPECTED_EVENTS {
+    InputDispatcher::EventType type;
+    uint32_t count;
+} EXPECTED_EVENTS;
+
+// What the input handler must send for the recording built by buildTestRecording().
+// Any event type not listed here must not be sent at all.
+static const EXPECTED_EVENTS k_TestExpectedEvents[] = {
+    // A and Space are pressed and released, and the Space repeat is ignored.
+    // B is still down when the recording ends, so it's raised by the replay.
+    { InputDispatcher::EventKeyboard, 6 },
+    // Each burst of motion is batched into a single event
+    { InputDispatcher::EventMouseMove, 2 },
+    { InputDispatcher::EventMouseButton, 4 },
+};
+
+// Feeds one pass of a recording through a fresh input handler
+class InputReplay
+{
+public:
+    InputReplay(const INPUT_RECORDING_HEADER& header, PREPLAY_STATS stats)
+        : m_Header(header),
+          m_Stats(stats),
+          m_Window(nullptr),
+          m_Handler(nullptr)
+    {
+    }
+
+    ~InputReplay()
+    {
+        delete m_Handler;
+        removeGamepads();
+
+        if (m_Window != nullptr) {
+            SDL_DestroyWindow(m_Window);
+        }
+    }
+
+    bool replay(const QVector<SDL_Event>& events, bool realtime)
+    {
+        StreamingPreferences prefs(nullptr);
+
+        // Match the configuration the input was recorded with
+        prefs.multiController = (m_Header.flags & INPUT_RECORDING_FLAG_MULTI_CONTROLLER) != 0;
+        prefs.absoluteMouseMode = (m_Header.flags & INPUT_RECORDING_FLAG_ABSOLUTE_MOUSE) != 0;
+        prefs.absoluteTouchMode = (m_Header.flags & INPUT_RECORDING_FLAG_ABSOLUTE_TOUCH) != 0;
+        prefs.gamepadMouse = (m_Header.flags & INPUT_RECORDING_FLAG_GAMEPAD_MOUSE) != 0;
+        prefs.swapMouseButtons = (m_Header.flags & INPUT_RECORDING_FLAG_SWAP_MOUSE_BUTTONS) != 0;
+        prefs.reverseScrollDirection = (m_Header.flags & INPUT_RECORDING_FLAG_REVERSE_SCROLL) != 0;
+        prefs.swapFaceButtons = (m_Header.flags & INPUT_RECORDING_FLAG_SWAP_FACE_BUTTONS) != 0;
+        prefs.captureSysKeysMode = (StreamingPreferences::CaptureSysKeysMode)m_Header.captureSysKeysMode;
+
+        m_Window = SDL_CreateWindow("Moonlight Input Replay",
+                                    SDL_WINDOWPOS_UNDEFINED,
+                                    SDL_WINDOWPOS_UNDEFINED,
+                                    m_Header.windowWidth > 0 ? m_Header.windowWidth : m_Header.streamWidth,
+                                    m_Header.windowHeight > 0 ? m_Header.windowHeight : m_Header.streamHeight,
+                                    SDL_WINDOW_HIDDEN);
+        if (m_Window == nullptr) {
+            fprintf(stderr, "SDL_CreateWindow() failed: %s\n", SDL_GetError());
+            return false;
+        }
+
+        m_Handler = new SdlInputHandler(prefs, m_Header.streamWidth, m_Header.streamHeight);
+        m_Handler->setWindow(m_Window);
+        m_Handler->setReplayMode(m_Stats->sentEvents);
+        m_Handler->setCaptureActive(true);
+
+        Uint32 firstTimestamp = events.first().common.timestamp;
+        Uint32 replayStartTime = SDL_GetTicks();
+
+        // Events that SDL reported with the same timestamp were most likely
+        // picked up by a single pass of the main loop, so we queue them together
+        // to give the input handler the same chances to batch them.
+        for (int i = 0; i < events.size();) {
+            Uint32 timestamp = events.at(i).common.timestamp;
+
+            if (realtime) {
+                Uint32 targetTime = timestamp - firstTimestamp;
+                Uint32 elapsedTime = SDL_GetTicks() - replayStartTime;
+                if (targetTime > elapsedTime) {
+                    SDL_Delay(targetTime - elapsedTime);
+                }
+            }
+
+            for (; i < events.size() && events.at(i).common.timestamp == timestamp; i++) {
+                SDL_Event event = events.at(i);
+                queueRecordedEvent(&event);
+            }
+
+            handleQueuedEvents();
+        }
+
+        m_Handler->setCaptureActive(false);
+        m_Handler->raiseAllKeys();
+
+        // Wait for the dispatcher to count everything
+        delete m_Handler;
+        m_Handler = nullptr;
+
+        return true;
+    }
+
+private:
+    void queueRecordedEvent(SDL_Event* event)
+    {
+        switch (event->type) {
+        case SDL_WINDOWEVENT:
+            // Input queued before the resize must be handled at the old size
+            handleQueuedEvents();
+            SDL_SetWindowSize(m_Window, event->window.data1, event->window.data2);
+            return;
+#if SDL_VERSION_ATLEAST(2, 0, 14)
+        case SDL_CONTROLLERDEVICEADDED:
+            addGamepad(&event->cdevice);
+            return;
+        case SDL_CONTROLLERDEVICEREMOVED:
+            if (!remapGamepad(&event->cdevice.which)) {
+                return;
+            }
+            break;
+        case SDL_CONTROLLERAXISMOTION:
+        {
+            // Axis and button events are generated by SDL from the virtual
+            // gamepad's state, so the state polled by mouse emulation matches.
+            SDL_Joystick* joystick = m_Gamepads.value(event->caxis.which);
+            if (joystick == nullptr) {
+                m_Stats->skippedEvents++;
+                return;
+            }
+
+            Sint16 value = event->caxis.value;
+            if (event->caxis.axis == SDL_CONTROLLER_AXIS_TRIGGERLEFT ||
+                    event->caxis.axis == SDL_CONTROLLER_AXIS_TRIGGERRIGHT) {
+                // Gamepad triggers are mapped from the full joystick axis range
+                value = (Sint16)(value * 2 + SDL_JOYSTICK_AXIS_MIN);
+            }
+            SDL_JoystickSetVirtualAxis(joystick, event->caxis.axis, value);
+            return;
+        }
+        case SDL_CONTROLLERBUTTONDOWN:
+        case SDL_CONTROLLERBUTTONUP:
+        {
+            SDL_Joystick* joystick = m_Gamepads.value(event->cbutton.which);
+            if (joystick == nullptr) {
+                m_Stats->skippedEvents++;
+                return;
+            }
+
+            SDL_JoystickSetVirtualButton(joystick, event->cbutton.button, event->cbutton.state);
+            return;
+        }
+        case SDL_CONTROLLERSENSORUPDATE:
+            if (!remapGamepad(&event->csensor.which)) {
+                return;
+            }
+            break;
+        case SDL_CONTROLLERTOUCHPADDOWN:
+        case SDL_CONTROLLERTOUCHPADUP:
+        case SDL_CONTROLLERTOUCHPADMOTION:
+            if (!remapGamepad(&event->ctouchpad.which)) {
+                return;
+            }
+            break;
+#if SDL_VERSION_ATLEAST(2, 24, 0)
+        case SDL_JOYBATTERYUPDATED:
+            if (!remapGamepad(&event->jbattery.which)) {
+                return;
+            }
+            break;
+#endif
+#else
+        case SDL_CONTROLLERDEVICEADDED:
+        case SDL_CONTROLLERDEVICEREMOVED:
+        case SDL_CONTROLLERAXISMOTION:
+        case SDL_CONTROLLERBUTTONDOWN:
+        case SDL_CONTROLLERBUTTONUP:
+            // Gamepads can't be replayed without virtual joystick support
+            m_Stats->skippedEvents++;
+            return;
+#endif
+        default:
+            break;
+        }
+
+        if (SDL_PushEvent(event) < 0) {
+            m_Stats->skippedEvents++;
+        }
+    }
+
+    void handleQueuedEvents()
+    {
+        SDL_Event event;
+
+        while (SDL_PollEvent(&event)) {
+            handleEvent(&event);
+        }
+    }
+
+    void handleEvent(SDL_Event* event)
+    {
+        HandlerType type;
+        Uint64 start = SDL_GetPerformanceCounter();
+
+        switch (event->type) {
+        case SDL_KEYUP:
+        case SDL_KEYDOWN:
+            m_Handler->handleKeyEvent(&event->key);
+            type = HandlerKeyboard;
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            m_Handler->handleMouseButtonEvent(&event->button);
+            type = HandlerMouseButton;
+            break;
+        case SDL_MOUSEMOTION:
+            m_Handler->handleMouseMotionEvent(&event->motion);
+            type = HandlerMouseMotion;
+            break;
+        case SDL_MOUSEWHEEL:
+            m_Handler->handleMouseWheelEvent(&event->wheel);
+            type = HandlerMouseWheel;
+            break;
+        case SDL_CONTROLLERAXISMOTION:
+            m_Handler->handleControllerAxisEvent(&event->caxis);
+            type = HandlerGamepadAxis;
+            break;
+        case SDL_CONTROLLERBUTTONDOWN:
+        case SDL_CONTROLLERBUTTONUP:
+            m_Handler->handleControllerButtonEvent(&event->cbutton);
+            type = HandlerGamepadButton;
+            break;
+        case SDL_CONTROLLERDEVICEADDED:
+        case SDL_CONTROLLERDEVICEREMOVED:
+            m_Handler->handleControllerDeviceEvent(&event->cdevice);
+            type = HandlerGamepadDevice;
+            break;
+#if SDL_VERSION_ATLEAST(2, 0, 14)
+        case SDL_CONTROLLERSENSORUPDATE:
+            m_Handler->handleControllerSensorEvent(&event->csensor);
+            type = HandlerGamepadSensor;
+            break;
+        case SDL_CONTROLLERTOUCHPADDOWN:
+        case SDL_CONTROLLERTOUCHPADUP:
+        case SDL_CONTROLLERTOUCHPADMOTION:
+            m_Handler->handleControllerTouchpadEvent(&event->ctouchpad);
+            type = HandlerGamepadTouchpad;
+            break;
+#endif
+#if SDL_VERSION_ATLEAST(2, 24, 0)
+        case SDL_JOYBATTERYUPDATED:
+            m_Handler->handleJoystickBatteryEvent(&event->jbattery);
+            type = HandlerGamepadBattery;
+            break;
+#endif
+        case SDL_FINGERDOWN:
+        case SDL_FINGERMOTION:
+        case SDL_FINGERUP:
+            m_Handler->handleTouchFingerEvent(&event->tfinger);
+            type = HandlerTouch;
+            break;
+        default:
+            // Quit requests from key combos, window events, etc.
+            return;
+        }
+
+        m_Stats->handlerTicks[type] += SDL_GetPerformanceCounter() - start;
+        m_Stats->handlerCalls[type]++;
+    }
+
+#if SDL_VERSION_ATLEAST(2, 0, 14)
+    void addGamepad(SDL_ControllerDeviceEvent* event)
+    {
+        // Attaching the gamepad generates device events that we discard below,
+        // so handle everything that was queued before it first.
+        handleQueuedEvents();
+
+        int deviceIndex = SDL_JoystickAttachVirtual(SDL_JOYSTICK_TYPE_GAMECONTROLLER,
+                                                    SDL_CONTROLLER_AXIS_MAX,
+                                                    SDL_CONTROLLER_BUTTON_MAX,
+                                                    0);
+        if (deviceIndex < 0) {
+            fprintf(stderr, "SDL_JoystickAttachVirtual() failed: %s\n", SDL_GetError());
+            m_Stats->skippedEvents++;
+            return;
+        }
+
+        SDL_Joystick* joystick = SDL_JoystickOpen(deviceIndex);
+        if (joystick == nullptr) {
+            fprintf(stderr, "SDL_JoystickOpen() failed: %s\n", SDL_GetError());
+            SDL_JoystickDetachVirtual(deviceIndex);
+            m_Stats->skippedEvents++;
+            return;
+        }
+
+        // Triggers rest at the minimum of the underlying joystick axis
+        SDL_JoystickSetVirtualAxis(joystick, SDL_CONTROLLER_AXIS_TRIGGERLEFT, SDL_JOYSTICK_AXIS_MIN);
+        SDL_JoystickSetVirtualAxis(joystick, SDL_CONTROLLER_AXIS_TRIGGERRIGHT, SDL_JOYSTICK_AXIS_MIN);
+        SDL_JoystickUpdate();
+
+        // Replace SDL's own events for the new device with the recorded one
+        SDL_PumpEvents();
+        SDL_FlushEvents(SDL_JOYAXISMOTION, SDL_CONTROLLERDEVICEREMAPPED);
+
+        m_Joysticks.append(joystick);
+        m_Gamepads.insert(event->which, joystick);
+
+        event->which = deviceIndex;
+        SDL_PushEvent((SDL_Event*)event);
+    }
+
+    bool remapGamepad(SDL_JoystickID* id)
+    {
+        SDL_Joystick* joystick = m_Gamepads.value(*id);
+        if (joystick == nullptr) {
+            m_Stats->skippedEvents++;
+            return false;
+        }
+
+        *id = SDL_JoystickInstanceID(joystick);
+        return true;
+    }
+#endif
+
+    void removeGamepads()
+    {
+#if SDL_VERSION_ATLEAST(2, 0, 14)
+        for (SDL_Joystick* joystick : m_Joysticks) {
+            SDL_JoystickClose(joystick);
+        }
+
+        for (int i = SDL_NumJoysticks() - 1; i >= 0; i--) {
+            if (SDL_JoystickIsVirtual(i)) {
+                SDL_JoystickDetachVirtual(i);
+            }
+        }
+
+        SDL_PumpEvents();
+        SDL_FlushEvents(SDL_JOYAXISMOTION, SDL_CONTROLLERDEVICEREMAPPED);
+#endif
+
+        m_Joysticks.clear();
+        m_Gamepads.clear();
+    }
+
+    const INPUT_RECORDING_HEADER& m_Header;
+    PREPLAY_STATS m_Stats;
+    SDL_Window* m_Window;
+    SdlInputHandler* m_Handler;
+
+    // Recorded instance ID to the virtual gamepad replaying it
+    QHash<SDL_JoystickID, SDL_Joystick*> m_Gamepads;
+    QVector<SDL_Joystick*> m_Joysticks;
+};
+
+static bool readRecording(const QString& fileName, PINPUT_RECORDING_HEADER header, QVector<SDL_Event>& events)
+{
+    QFile file(fileName);
+    SDL_version linkedVersion;
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "Failed to open %s: %s\n",
+                qPrintable(fileName), qPrintable(file.errorString()));
+        return false;
+    }
+
+    if (file.read((char*)header, sizeof(*header)) != sizeof(*header) ||
+            header->magic != INPUT_RECORDING_MAGIC) {
+        fprintf(stderr, "%s is not an input recording\n", qPrintable(fileName));
+        return false;
+    }
+
+    if (header->version != INPUT_RECORDING_VERSION) {
+        fprintf(stderr, "Unsupported input recording version: %u\n", header->version);
+        return false;
+    }
+
+    // Events are stored in SDL's native layout
+    SDL_GetVersion(&linkedVersion);
+    if (header->eventSize != sizeof(SDL_Event) ||
+            header->sdlMajor != linkedVersion.major ||
+            header->sdlMinor != linkedVersion.minor) {
+        fprintf(stderr, "Recording was made with SDL %d.%d.%d but this build uses SDL %d.%d.%d\n",
+                header->sdlMajor, header->sdlMinor, header->sdlPatch,
+                linkedVersion.major, linkedVersion.minor, linkedVersion.patch);
+        return false;
+    }
+
+    QByteArray data = file.readAll();
+    events.resize(data.size() / (int)sizeof(SDL_Event));
+    if (events.isEmpty()) {
+        fprintf(stderr, "%s contains no input events\n", qPrintable(fileName));
+        return false;
+    }
+
+    memcpy(events.data(), data.constData(), events.size() * sizeof(SDL_Event));
+    return true;
+}
+
+static bool writeRecording(QFile& file, const INPUT_RECORDING_HEADER& header, const QVector<SDL_Event>& events)
+{
+    qint64 eventsSize = events.size() * (qint64)sizeof(SDL_Event);
+
+    return file.write((const char*)&header, sizeof(header)) == sizeof(header) &&
+           file.write((const char*)events.constData(), eventsSize) == eventsSize &&
+           file.flush();
+}
+
+static void addKeyEvent(QVector<SDL_Event>& events, Uint32 timestamp, Uint32 type,
+                        SDL_Scancode scancode, Uint8 repeat = 0)
+{
+    SDL_Event event = {};
+
+    event.key.type = type;
+    event.key.timestamp = timestamp;
+    event.key.state = type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED;
+    event.key.repeat = repeat;
+    event.key.keysym.scancode = scancode;
+    event.key.keysym.sym = SDL_GetKeyFromScancode(scancode);
+    events.append(event);
+}
+
+static void addMouseButtonEvent(QVector<SDL_Event>& events, Uint32 timestamp, Uint32 type, Uint8 button)
+{
+    SDL_Event event = {};
+
+    event.button.type = type;
+    event.button.timestamp = timestamp;
+    event.button.button = button;
+    event.button.state = type == SDL_MOUSEBUTTONDOWN ? SDL_PRESSED : SDL_RELEASED;
+    event.button.clicks = 1;
+    events.append(event);
+}
+
+static void addMouseMotionEvent(QVector<SDL_Event>& events, Uint32 timestamp, Sint32 xrel, Sint32 yrel)
+{
+    SDL_Event event = {};
+
+    event.motion.type = SDL_MOUSEMOTION;
+    event.motion.timestamp = timestamp;
+    event.motion.xrel = xrel;
+    event.motion.yrel = yrel;
+    events.append(event);
+}
+
+// Builds the recording replayed by --self-test. Recordings are stored in SDL's
+// native layout, so this one is built at runtime rather than shipped as a file.
+// Events with the same timestamp are queued together, as if they were picked
+// up by a single pass of the main loop.
+static void buildTestRecording(PINPUT_RECORDING_HEADER header, QVector<SDL_Event>& events)
+{
+    SDL_version linkedVersion;
+
+    SDL_GetVersion(&linkedVersion);
+
+    SDL_zerop(header);
+    header->magic = INPUT_RECORDING_MAGIC;
+    header->version = INPUT_RECORDING_VERSION;
+    header->eventSize = sizeof(SDL_Event);
+    header->sdlMajor = linkedVersion.major;
+    header->sdlMinor = linkedVersion.minor;
+    header->sdlPatch = linkedVersion.patch;
+    header->streamWidth = header->windowWidth = 1280;
+    header->streamHeight = header->windowHeight = 720;
+    header->captureSysKeysMode = StreamingPreferences::CSK_OFF;
+
+    events.clear();
+
+    addKeyEvent(events, 10, SDL_KEYDOWN, SDL_SCANCODE_A);
+    addKeyEvent(events, 20, SDL_KEYUP, SDL_SCANCODE_A);
+
+    addMouseMotionEvent(events, 30, 1, 0);
+    addMouseMotionEvent(events, 30, 2, 1);
+    addMouseMotionEvent(events, 30, 0, 3);
+
+    addMouseButtonEvent(events, 40, SDL_MOUSEBUTTONDOWN, SDL_BUTTON_LEFT);
+    addMouseButtonEvent(events, 50, SDL_MOUSEBUTTONUP, SDL_BUTTON_LEFT);
+
+    addMouseMotionEvent(events, 60, -4, 0);
+    addMouseMotionEvent(events, 60, 1, 1);
+
+    addMouseButtonEvent(events, 70, SDL_MOUSEBUTTONDOWN, SDL_BUTTON_RIGHT);
+    addMouseButtonEvent(events, 80, SDL_MOUSEBUTTONUP, SDL_BUTTON_RIGHT);
+
+    addKeyEvent(events, 90, SDL_KEYDOWN, SDL_SCANCODE_SPACE);
+    addKeyEvent(events, 100, SDL_KEYDOWN, SDL_SCANCODE_SPACE, 1);
+    addKeyEvent(events, 110, SDL_KEYUP, SDL_SCANCODE_SPACE);
+
+    addKeyEvent(events, 120, SDL_KEYDOWN, SDL_SCANCODE_B);
+}
+
+static bool replayRecording(const INPUT_RECORDING_HEADER& header, const QVector<SDL_Event>& events,
+                            int iterations, bool realtime, PREPLAY_STATS stats)
+{
+    bool ret = true;
+
+    // Keep the gamepad subsystem alive across iterations, so each one
+    // doesn't have to enumerate the real gamepads again
+    if (SDL_InitSubSystem(SDL_INIT_GAMECONTROLLER) != 0) {
+        fprintf(stderr, "SDL_InitSubSystem(SDL_INIT_GAMECONTROLLER) failed: %s\n", SDL_GetError());
+        return false;
+    }
+
+    // Real gamepads aren't part of the replay
+    SDL_PumpEvents();
+    SDL_FlushEvents(SDL_FIRSTEVENT, SDL_LASTEVENT);
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < iterations && ret; i++) {
+        InputReplay inputReplay(header, stats);
+        ret = inputReplay.replay(events, realtime);
+    }
+    stats->replayTicks += SDL_GetPerformanceCounter() - start;
+
+    SDL_QuitSubSystem(SDL_INIT_GAMECONTROLLER);
+    return ret;
+}
+
+static int runSelfTest()
+{
+    INPUT_RECORDING_HEADER header;
+    QVector<SDL_Event> events;
+    QTemporaryFile file;
+    REPLAY_STATS stats;
+    bool passed = true;
+
+    buildTestRecording(&header, events);
+
+    // Go through a file so reading recordings is tested too
+    if (!file.open() || !writeRecording(file, header, events)) {
+        fprintf(stderr, "Failed to write test recording: %s\n", qPrintable(file.errorString()));
+        return 1;
+    }
+    file.close();
+
+    if (!readRecording(file.fileName(), &header, events)) {
+        return 1;
+    }
+
+    SDL_zero(stats);
+    if (!replayRecording(header, events, 1, false, &stats)) {
+        return 1;
+    }
+
+    for (int i = 0; i < InputDispatcher::EventTypeMax; i++) {
+        uint32_t expectedCount = 0;
+
+        for (const EXPECTED_EVENTS& expected : k_TestExpectedEvents) {
+            if (expected.type == i) {
+                expectedCount = expected.count;
+            }
+        }
+
+        if (stats.sentEvents[i] != expectedCount) {
+            fprintf(stderr, "Expected %u %s events to be sent, but got %u\n",
+                    expectedCount, InputDispatcher::getEventTypeName(i), stats.sentEvents[i]);
+            passed = false;
+        }
+    }
+
+    if (stats.skippedEvents != 0) {
+        fprintf(stderr, "%u recorded events could not be replayed\n", stats.skippedEvents);
+        passed = false;
+    }
+
+    fprintf(stdout, "Input replay self-test %s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
+
+static void printStats(const REPLAY_STATS& stats, bool printCSV)
+{
+    Uint64 perfFreq = SDL_GetPerformanceFrequency();
+
+    if (printCSV) {
+        fprintf(stdout, "Kind,Name,Count,TotalUs,MeanUs\n");
+    }
+    else {
+        fprintf(stdout, "%-17s %9s %11s %9s\n", "Handler", "Calls", "Total us", "Mean us");
+    }
+
+    for (int i = 0; i < HandlerMax; i++) {
+        if (stats.handlerCalls[i] == 0) {
+            continue;
+        }
+
+        double totalUs = (double)stats.handlerTicks[i] * 1000000.0 / perfFreq;
+        double meanUs = totalUs / stats.handlerCalls[i];
+
+        if (printCSV) {
+            fprintf(stdout, "handler,%s,%u,%.1f,%.2f\n",
+                    k_HandlerNames[i], stats.handlerCalls[i], totalUs, meanUs);
+        }
+        else {
+            fprintf(stdout, "%-17s %9u %11.1f %9.2f\n",
+                    k_HandlerNames[i], stats.handlerCalls[i], totalUs, meanUs);
+        }
+    }
+
+    if (!printCSV) {
+        fprintf(stdout, "\n%-17s %9s\n", "Sent", "Events");
+    }
+
+    for (int i = 0; i < InputDispatcher::EventTypeMax; i++) {
+        if (stats.sentEvents[i] == 0) {
+            continue;
+        }
+
+        if (printCSV) {
+            fprintf(stdout, "sent,%s,%u,,\n",
+                    InputDispatcher::getEventTypeName(i), stats.sentEvents[i]);
+        }
+        else {
+            fprintf(stdout, "%-17s %9u\n",
+                    InputDispatcher::getEventTypeName(i), stats.sentEvents[i]);
+        }
+    }
+
+    if (!printCSV && stats.skippedEvents != 0) {
+        fprintf(stdout, "\n%u recorded events could not be replayed\n", stats.skippedEvents);
+    }
+}
+
+int run(const ReplayInputCommandLineParser& arguments)
+{
+    INPUT_RECORDING_HEADER header;
+    QVector<SDL_Event> events;
+    REPLAY_STATS stats;
+
+    if (arguments.isSelfTest()) {
+        return runSelfTest();
+    }
+
+    if (!readRecording(arguments.getFileName(), &header, events)) {
+        return 1;
+    }
+
+    SDL_zero(stats);
+    if (!replayRecording(header, events, arguments.getIterations(), arguments.isRealtime(), &stats)) {
+        return 1;
+    }
+
+    if (!arguments.isPrintCSV()) {
+        fprintf(stdout, "Replayed %d events %d times in %.1f ms\n\n",
+                (int)events.size(), arguments.getIterations(),
+                (double)stats.replayTicks * 1000.0 / SDL_GetPerformanceFrequency());
+    }
+
+    printStats(stats, arguments.isPrintCSV());
+    return 0;
+}
+
+}
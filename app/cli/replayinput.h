@@ -0,0 +1,11 @@
+#pragma once
+
+#include "commandlineparser.h"
+
+namespace CliReplayInput
+{
+
+// Replays an input recording through the input handler and returns the process exit code
+int run(const ReplayInputCommandLineParser& arguments);
+
+}
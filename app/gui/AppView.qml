@@ -77,37 +77,35 @@ CenteredGridView {
         property alias appContextMenu: appContextMenuLoader.item
         property alias appNameText: appNameTextLoader.item
 
+        // GridView also creates delegates for items just outside the view, so tell
+        // the model which ones are actually on screen to fetch their box art first.
+        property bool onScreen: y + height > appGrid.contentY && y < appGrid.contentY + appGrid.height
+
+        onOnScreenChanged: appModel.setBoxArtOnScreen(model.appid, onScreen)
+        Component.onCompleted: appModel.setBoxArtOnScreen(model.appid, onScreen)
+
+        // Don't fetch box art for items that were scrolled away before it was fetched
+        Component.onDestruction: appModel.cancelBoxArt(model.appid)
+
         // Dim the app if it's hidden
         opacity: model.hidden ? 0.4 : 1.0
 
         Image {
-            property bool isPlaceholder: false
+            // Nearly all of Nvidia's official box art does not match the dimensions of placeholder
+            // images, however the one known exception is Overcooked. Therefore, we only use the
+            // placeholder layout if this is not an app collector game. We know the officially
+            // supported games all have box art, so this check is not required.
+            property bool isPlaceholder: !model.isAppCollectorGame && model.boxArtPlaceholder
 
             id: appIcon
             anchors.horizontalCenter: parent.horizontalCenter
             y: 10
             source: model.boxart
 
-            onSourceSizeChanged: {
-                // Nearly all of Nvidia's official box art does not match the dimensions of placeholder
-                // images, however the one known exception is Overcooked. Therefore, we only execute
-                // the image size checks if this is not an app collector game. We know the officially
-                // supported games all have box art, so this check is not required.
-                if (!model.isAppCollectorGame &&
-                    ((sourceSize.width === 130 && sourceSize.height === 180) || // GFE 2.0 placeholder image
-                     (sourceSize.width === 628 && sourceSize.height === 888) || // GFE 3.0 placeholder image
-                     (sourceSize.width === 200 && sourceSize.height === 266)))  // Our no_app_image.png
-                {
-                    isPlaceholder = true
-                }
-                else
-                {
-                    isPlaceholder = false
-                }
-
-                width = 200
-                height = 267
-            }
+            // Box art thumbnails are scaled for high DPI displays, so
+            // size the image explicitly rather than by its pixel size
+            width: 200
+            height: 267
 
             // Display a tooltip with the full name if it's truncated
             ToolTip.text: model.name
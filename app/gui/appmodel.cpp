@@ -5,6 +5,8 @@ AppModel::AppModel(QObject *parent)
 {
     connect(&m_BoxArtManager, &BoxArtManager::boxArtLoadComplete,
             this, &AppModel::handleBoxArtLoaded);
+    connect(&m_BoxArtManager, &BoxArtManager::boxArtPlaceholderLoaded,
+            this, &AppModel::handleBoxArtPlaceholderLoaded);
 }
 
 void AppModel::initialize(ComputerManager* computerManager, int computerIndex, bool showHiddenGames)
@@ -93,6 +95,9 @@ QVariant AppModel::data(const QModelIndex &index, int role) const
         return app.directLaunch;
     case AppCollectorGameRole:
         return app.isAppCollectorGame;
+    case BoxArtPlaceholderRole:
+        // FIXME: const-correctness
+        return const_cast<BoxArtManager&>(m_BoxArtManager).isBoxArtPlaceholder(m_Computer, app);
     default:
         return QVariant();
     }
@@ -109,6 +114,7 @@ QHash<int, QByteArray> AppModel::roleNames() const
     names[AppIdRole] = "appid";
     names[DirectLaunchRole] = "directLaunch";
     names[AppCollectorGameRole] = "appCollectorGame";
+    names[BoxArtPlaceholderRole] = "boxArtPlaceholder";
 
     return names;
 }
@@ -250,6 +256,16 @@ void AppModel::setAppDirectLaunch(int appIndex, bool directLaunch)
     m_ComputerManager->clientSideAttributeUpdated(m_Computer);
 }
 
+void AppModel::setBoxArtOnScreen(int appId, bool onScreen)
+{
+    m_BoxArtManager.setBoxArtOnScreen(m_Computer, appId, onScreen);
+}
+
+void AppModel::cancelBoxArt(int appId)
+{
+    m_BoxArtManager.cancelBoxArt(m_Computer, appId);
+}
+
 void AppModel::handleComputerStateChanged(NvComputer* computer)
 {
     // Ignore updates for computers that aren't ours
@@ -312,9 +328,25 @@ void AppModel::handleBoxArtLoaded(NvComputer* computer, NvApp app, QUrl /* image
         // Let our view know the box art data has changed for this app
         emit dataChanged(createIndex(index, 0),
                          createIndex(index, 0),
-                         QVector<int>() << BoxArtRole);
+                         QVector<int>() << BoxArtRole << BoxArtPlaceholderRole);
     }
     else {
         qWarning() << "App not found for box art callback:" << app.name;
     }
 }
+
+void AppModel::handleBoxArtPlaceholderLoaded(QString uuid, int appId)
+{
+    if (uuid != m_Computer->uuid) {
+        return;
+    }
+
+    for (int i = 0; i < m_VisibleApps.count(); i++) {
+        if (m_VisibleApps[i].id == appId) {
+            emit dataChanged(createIndex(i, 0),
+                             createIndex(i, 0),
+                             QVector<int>() << BoxArtPlaceholderRole);
+            break;
+        }
+    }
+}
@@ -19,6 +19,7 @@ class AppModel : public QAbstractListModel
         AppIdRole,
         DirectLaunchRole,
         AppCollectorGameRole,
+        BoxArtPlaceholderRole,
     };
 
 public:
@@ -41,6 +42,10 @@ public:
 
     Q_INVOKABLE void setAppDirectLaunch(int appIndex, bool directLaunch);
 
+    Q_INVOKABLE void setBoxArtOnScreen(int appId, bool onScreen);
+
+    Q_INVOKABLE void cancelBoxArt(int appId);
+
     QVariant data(const QModelIndex &index, int role) const override;
 
     int rowCount(const QModelIndex &parent) const override;
@@ -52,6 +57,8 @@ private slots:
 
     void handleBoxArtLoaded(NvComputer* computer, NvApp app, QUrl image);
 
+    void handleBoxArtPlaceholderLoaded(QString uuid, int appId);
+
 signals:
     void computerLost();
 
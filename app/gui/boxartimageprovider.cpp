@@ -0,0 +1,37 @@
+#include "boxartimageprovider.h"
+#include "backend/boxartcache.h"
+
+BoxArtImageProvider::BoxArtImageProvider()
+    // Requests for thumbnails that aren't in the memory cache have to go to disk,
+    // so always load them off the UI thread even if the Image isn't asynchronous.
+    : QQuickImageProvider(QQuickImageProvider::Image,
+                          QQmlImageProviderBase::ForceAsynchronousImageLoading)
+{
+}
+
+QImage BoxArtImageProvider::requestImage(const QString& id, QSize* size, const QSize& requestedSize)
+{
+    QString uuid = id.section('/', 0, 0);
+    bool ok;
+    int appId = id.section('/', 1, 1).toInt(&ok);
+    QImage image;
+
+    if (!uuid.isEmpty() && ok) {
+        image = BoxArtCache::get()->load(uuid, appId);
+    }
+
+    if (image.isNull()) {
+        // The box art was evicted from the cache since the URL was handed out
+        image = QImage(":/res/no_app_image.png");
+    }
+
+    if (size != nullptr) {
+        *size = image.size();
+    }
+
+    if (requestedSize.isValid() && requestedSize != image.size()) {
+        image = image.scaled(requestedSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    return image;
+}
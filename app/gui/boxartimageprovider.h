@@ -0,0 +1,12 @@
+#pragma once
+
+#include <QQuickImageProvider>
+
+// Serves box art thumbnails from BoxArtCache to QML as image://boxart/<uuid>/<appId>
+class BoxArtImageProvider : public QQuickImageProvider
+{
+public:
+    BoxArtImageProvider();
+
+    QImage requestImage(const QString& id, QSize* size, const QSize& requestedSize) override;
+};
@@ -0,0 +1,335 @@
+#include "logger.h"
+
+#include "SDL_compat.h"
+
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QRegularExpression>
+
+#include <atomic>
+
+// Must be a power of 2
+#define LOG_RING_SIZE 1024
+
+// Sized so a record is 512 bytes. Longer messages are rare, so
+// we'll take the hit of a heap allocation to store those.
+#define LOG_RECORD_TEXT_SIZE 472
+
+typedef struct _LOG_RECORD {
+    // Set to the ring position when this record is free to be written
+    // and to the position + 1 when it has been written and can be read.
+    QAtomicInteger<quint32> sequence;
+
+    quint32 timeMs;
+    LogSource source;
+    const char* level;
+    int category;
+    int length;
+    char* overflow;
+    char text[LOG_RECORD_TEXT_SIZE];
+} LOG_RECORD, *PLOG_RECORD;
+
+// StreamUtils::enterAsyncLoggingMode() exposes control of this to the
+// Session class to enable async logging once the stream has started.
+extern QAtomicInt g_AsyncLoggingEnabled;
+
+static LOG_RECORD s_Ring[LOG_RING_SIZE];
+static QAtomicInteger<quint32> s_EnqueuePos;
+static quint32 s_DequeuePos;
+static QAtomicInteger<quint32> s_DroppedMessages;
+
+static QElapsedTimer s_LoggerTime;
+static SDL_Thread* s_WriterThread;
+static SDL_sem* s_WriterSem;
+static QAtomicInt s_WriterSleeping;
+static QAtomicInt s_WriterShouldQuit;
+
+// Protects everything below, which is only touched while writing
+static QMutex s_WriteMutex;
+static QIODevice* s_Device;
+static QFile s_StderrFile;
+static QByteArray s_WriteBuffer;
+static quint64 s_MaxBytes;
+static quint64 s_BytesWritten;
+static QRegularExpression k_RikeyRegex("&rikey=\\w+");
+static QRegularExpression k_RikeyIdRegex("&rikeyid=[\\d-]+");
+
+static
+void appendMessage(quint32 timeMs, LogSource source, const char* level, int category,
+                   const char* message, int length)
+{
+    int start = s_WriteBuffer.size();
+
+    // Continuation lines from FFmpeg are written as-is
+    if (source != LogSourceFfmpeg || level != nullptr) {
+        char prefix[64];
+
+        quint32 seconds = timeMs / 1000;
+        switch (source) {
+        case LogSourceSdl:
+            SDL_snprintf(prefix, sizeof(prefix), "%02u:%02u:%02u - SDL %s (%d): ",
+                         (seconds / 3600) % 24, (seconds / 60) % 60, seconds % 60, level, category);
+            break;
+        case LogSourceQt:
+            SDL_snprintf(prefix, sizeof(prefix), "%02u:%02u:%02u - Qt %s: ",
+                         (seconds / 3600) % 24, (seconds / 60) % 60, seconds % 60, level);
+            break;
+        case LogSourceFfmpeg:
+            SDL_snprintf(prefix, sizeof(prefix), "%02u:%02u:%02u - FFmpeg: ",
+                         (seconds / 3600) % 24, (seconds / 60) % 60, seconds % 60);
+            break;
+        }
+
+        s_WriteBuffer.append(prefix);
+    }
+
+    s_WriteBuffer.append(message, length);
+
+    // FFmpeg provides its own line endings
+    if (source != LogSourceFfmpeg) {
+        s_WriteBuffer.append('\n');
+    }
+
+    // Strip session encryption keys and IVs from the logs. Only a few
+    // messages can contain them, so don't run the regexes on the rest.
+    if (s_WriteBuffer.indexOf("rikey", start) >= 0) {
+        QString line = QString::fromUtf8(s_WriteBuffer.constData() + start, s_WriteBuffer.size() - start);
+        line.replace(k_RikeyRegex, "&rikey=REDACTED");
+        line.replace(k_RikeyIdRegex, "&rikeyid=REDACTED");
+        s_WriteBuffer.truncate(start);
+        s_WriteBuffer.append(line.toUtf8());
+    }
+
+    if (s_MaxBytes != 0) {
+        quint64 lineLength = s_WriteBuffer.size() - start;
+        if (s_BytesWritten >= s_MaxBytes) {
+            s_WriteBuffer.truncate(start);
+        }
+        else if (s_BytesWritten >= s_MaxBytes - lineLength) {
+            // Write one final message
+            s_WriteBuffer.truncate(start);
+            s_WriteBuffer.append("Log size limit reached!\n");
+        }
+
+        s_BytesWritten += lineLength;
+    }
+}
+
+// Must be called with s_WriteMutex held, which makes us the only consumer
+static
+void drainRing()
+{
+    for (;;) {
+        PLOG_RECORD record = &s_Ring[s_DequeuePos & (LOG_RING_SIZE - 1)];
+        if (record->sequence.loadAcquire() != s_DequeuePos + 1) {
+            // Nothing else has been written yet
+            break;
+        }
+
+        appendMessage(record->timeMs, record->source, record->level, record->category,
+                      record->overflow != nullptr ? record->overflow : record->text,
+                      record->length);
+
+        if (record->overflow != nullptr) {
+            free(record->overflow);
+            record->overflow = nullptr;
+        }
+
+        // Hand the record back to producers for the next lap around the ring
+        record->sequence.storeRelease(s_DequeuePos + LOG_RING_SIZE);
+        s_DequeuePos++;
+    }
+
+    quint32 droppedMessages = s_DroppedMessages.fetchAndStoreRelaxed(0);
+    if (droppedMessages != 0) {
+        char message[64];
+        int length = SDL_snprintf(message, sizeof(message), "%u log messages dropped", droppedMessages);
+        appendMessage((quint32)s_LoggerTime.elapsed(), LogSourceSdl, "Warn", SDL_LOG_CATEGORY_APPLICATION,
+                      message, length);
+    }
+}
+
+// Must be called with s_WriteMutex held
+static
+void writeBuffer()
+{
+    if (!s_WriteBuffer.isEmpty()) {
+        s_Device->write(s_WriteBuffer);
+        s_WriteBuffer.clear();
+    }
+
+    QFileDevice* file = qobject_cast<QFileDevice*>(s_Device);
+    if (file != nullptr) {
+        file->flush();
+    }
+}
+
+// Must be called with s_WriteMutex held
+static
+bool isRingEmpty()
+{
+    return s_Ring[s_DequeuePos & (LOG_RING_SIZE - 1)].sequence.loadAcquire() != s_DequeuePos + 1;
+}
+
+static
+int SDLCALL writerThreadProc(void*)
+{
+    for (;;) {
+        bool empty;
+
+        {
+            QMutexLocker locker(&s_WriteMutex);
+            drainRing();
+            writeBuffer();
+        }
+
+        if (s_WriterShouldQuit.loadAcquire()) {
+            break;
+        }
+
+        // SDL semaphores are a mutex and condition variable on some platforms,
+        // so producers only post when we say we're going to sleep. Anything
+        // published before they could have seen that must be written first.
+        s_WriterSleeping.fetchAndStoreOrdered(1);
+
+        // Pairs with the fence in Logger::log(). Without both, the producer could
+        // miss our flag while we miss its record, and we'd sleep with it queued.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        {
+            QMutexLocker locker(&s_WriteMutex);
+            empty = isRingEmpty();
+        }
+
+        if (empty) {
+            SDL_SemWait(s_WriterSem);
+        }
+        else {
+            // If a producer beat us to this, its post will just
+            // cause an extra pass through the loop later.
+            s_WriterSleeping.fetchAndStoreOrdered(0);
+        }
+    }
+
+    return 0;
+}
+
+static
+bool enqueueRecord(LogSource source, const char* level, int category,
+                   const char* message, int length)
+{
+    PLOG_RECORD record;
+    quint32 pos = s_EnqueuePos.loadAcquire();
+
+    for (;;) {
+        record = &s_Ring[pos & (LOG_RING_SIZE - 1)];
+
+        qint32 diff = (qint32)(record->sequence.loadAcquire() - pos);
+        if (diff == 0) {
+            // This record is free, so try to claim it
+            if (s_EnqueuePos.testAndSetRelaxed(pos, pos + 1, pos)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            // The writer hasn't caught up with us
+            return false;
+        }
+        else {
+            // Another thread claimed this record first
+            pos = s_EnqueuePos.loadAcquire();
+        }
+    }
+
+    record->timeMs = (quint32)s_LoggerTime.elapsed();
+    record->source = source;
+    record->level = level;
+    record->category = category;
+    record->length = length;
+    if (length <= LOG_RECORD_TEXT_SIZE) {
+        memcpy(record->text, message, length);
+    }
+    else {
+        record->overflow = (char*)malloc(length);
+        if (record->overflow != nullptr) {
+            memcpy(record->overflow, message, length);
+        }
+        else {
+            record->length = LOG_RECORD_TEXT_SIZE;
+            memcpy(record->text, message, LOG_RECORD_TEXT_SIZE);
+        }
+    }
+
+    // Publish the record to the writer
+    record->sequence.storeRelease(pos + 1);
+    return true;
+}
+
+void Logger::initialize(QIODevice* device, quint64 maxBytes)
+{
+    for (quint32 i = 0; i < LOG_RING_SIZE; i++) {
+        s_Ring[i].sequence.storeRelease(i);
+    }
+
+    if (device == nullptr) {
+        s_StderrFile.open(stderr, QIODevice::WriteOnly | QIODevice::Text);
+        device = &s_StderrFile;
+    }
+
+    s_Device = device;
+    s_MaxBytes = maxBytes;
+    s_LoggerTime.start();
+
+    s_WriterSem = SDL_CreateSemaphore(0);
+    s_WriterThread = SDL_CreateThread(writerThreadProc, "Logger", nullptr);
+}
+
+void Logger::shutdown()
+{
+    if (s_WriterThread != nullptr) {
+        s_WriterShouldQuit.storeRelease(1);
+
+        // Wake the writer whether it's sleeping or not
+        SDL_SemPost(s_WriterSem);
+        SDL_WaitThread(s_WriterThread, nullptr);
+        s_WriterThread = nullptr;
+    }
+
+    if (s_WriterSem != nullptr) {
+        SDL_DestroySemaphore(s_WriterSem);
+        s_WriterSem = nullptr;
+    }
+
+    // Write anything that was logged after the writer exited
+    QMutexLocker locker(&s_WriteMutex);
+    drainRing();
+    writeBuffer();
+}
+
+void Logger::log(LogSource source, const char* level, int category,
+                 const char* message, int length)
+{
+    if (g_AsyncLoggingEnabled && s_WriterThread != nullptr) {
+        if (enqueueRecord(source, level, category, message, length)) {
+            // Only one producer needs to wake the writer. The fence orders
+            // publishing our record before we check if the writer is asleep.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (s_WriterSleeping.testAndSetOrdered(1, 0)) {
+                SDL_SemPost(s_WriterSem);
+            }
+        }
+        else {
+            s_DroppedMessages.fetchAndAddRelaxed(1);
+        }
+    }
+    else {
+        // Write the message immediately, after anything still
+        // queued from when we were in async logging mode.
+        QMutexLocker locker(&s_WriteMutex);
+        drainRing();
+        appendMessage((quint32)s_LoggerTime.elapsed(), source, level, category, message, length);
+        writeBuffer();
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QIODevice>
+
+enum LogSource {
+    LogSourceSdl,
+    LogSourceQt,
+    LogSourceFfmpeg
+};
+
+// Writes log messages from all libraries to a single device. Once the
+// stream has started (see StreamUtils::enterAsyncLoggingMode()), messages
+// are copied into a preallocated ring of fixed-size records without taking
+// any locks, then formatted and written in batches by a dedicated thread.
+class Logger
+{
+public:
+    // If device is null, messages are written to stderr. Once maxBytes
+    // have been written, further messages are discarded (0 is unlimited).
+    static
+    void initialize(QIODevice* device, quint64 maxBytes);
+
+    // Writes any pending messages and stops the writer thread
+    static
+    void shutdown();
+
+    // The level must be a string literal. For FFmpeg, a null level
+    // means this message continues the previous line.
+    static
+    void log(LogSource source, const char* level, int category,
+             const char* message, int length);
+};
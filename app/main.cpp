@@ -3,14 +3,11 @@
 #include <QQmlContext>
 #include <QIcon>
 #include <QQuickStyle>
-#include <QMutex>
 #include <QtDebug>
 #include <QNetworkProxyFactory>
 #include <QPalette>
 #include <QFont>
 #include <QCursor>
-#include <QElapsedTimer>
-#include <QRegularExpression>
 
 #ifdef Q_OS_UNIX
 #include <sys/socket.h>
@@ -27,15 +24,21 @@
 #include "streaming/video/ffmpeg.h"
 #endif
 
+#include "cli/benchmarkaudio.h"
+#include "cli/benchmarkserverinfo.h"
 #include "cli/listapps.h"
 #include "cli/quitstream.h"
 #include "cli/startstream.h"
 #include "cli/pair.h"
+#include "cli/replayinput.h"
 #include "cli/commandlineparser.h"
+#include "logger.h"
 #include "path.h"
 #include "utils.h"
 #include "gui/computermodel.h"
 #include "gui/appmodel.h"
+#include "gui/boxartimageprovider.h"
+#include "backend/boxartcache.h"
 #include "backend/computermanager.h"
 #include "backend/systemproperties.h"
 #include "streaming/session.h"
@@ -51,73 +54,16 @@
 // FIXME: Clean this up
 QAtomicInt g_AsyncLoggingEnabled;
 
-static QElapsedTimer s_LoggerTime;
-static QTextStream s_LoggerStream(stderr);
-static QThreadPool s_LoggerThread;
-static QMutex s_SyncLoggerMutex;
 static bool s_SuppressVerboseOutput;
-static QRegularExpression k_RikeyRegex("&rikey=\\w+");
-static QRegularExpression k_RikeyIdRegex("&rikeyid=[\\d-]+");
 #ifdef LOG_TO_FILE
 // Max log file size of 10 MB
 static const uint64_t k_MaxLogSizeBytes = 10 * 1024 * 1024;
-static QAtomicInteger<uint64_t> s_LogBytesWritten = 0;
 static QFile* s_LoggerFile;
 #endif
 
-class LoggerTask : public QRunnable
-{
-public:
-    LoggerTask(const QString& msg) : m_Msg(msg)
-    {
-        setAutoDelete(true);
-    }
-
-    void run() override
-    {
-        // QTextStream is not thread-safe, so we must lock. This will generally
-        // only contend in synchronous logging mode or during a transition
-        // between synchronous and asynchronous. Asynchronous won't contend in
-        // the common case because we only have a single logging thread.
-        QMutexLocker locker(&s_SyncLoggerMutex);
-        s_LoggerStream << m_Msg;
-        s_LoggerStream.flush();
-    }
-
-private:
-    QString m_Msg;
-};
-
-void logToLoggerStream(QString& message)
-{
-    // Strip session encryption keys and IVs from the logs
-    message.replace(k_RikeyRegex, "&rikey=REDACTED");
-    message.replace(k_RikeyIdRegex, "&rikeyid=REDACTED");
-
-#ifdef LOG_TO_FILE
-    auto oldLogSize = s_LogBytesWritten.fetchAndAddRelaxed(message.size());
-    if (oldLogSize >= k_MaxLogSizeBytes) {
-        return;
-    }
-    else if (oldLogSize >= k_MaxLogSizeBytes - message.size()) {
-        // Write one final message
-        message = "Log size limit reached!";
-    }
-#endif
-
-    if (g_AsyncLoggingEnabled) {
-        // Queue the log message to be written asynchronously
-        s_LoggerThread.start(new LoggerTask(message));
-    }
-    else {
-        // Log the message immediately
-        LoggerTask(message).run();
-    }
-}
-
 void sdlLogToDiskHandler(void*, int category, SDL_LogPriority priority, const char* message)
 {
-    QString priorityTxt;
+    const char* priorityTxt;
 
     switch (priority) {
     case SDL_LOG_PRIORITY_VERBOSE:
@@ -155,15 +101,12 @@ void sdlLogToDiskHandler(void*, int category, SDL_LogPriority priority, const ch
         break;
     }
 
-    QTime logTime = QTime::fromMSecsSinceStartOfDay(s_LoggerTime.elapsed());
-    QString txt = QString("%1 - SDL %2 (%3): %4\n").arg(logTime.toString()).arg(priorityTxt).arg(category).arg(message);
-
-    logToLoggerStream(txt);
+    Logger::log(LogSourceSdl, priorityTxt, category, message, (int)strlen(message));
 }
 
 void qtLogToDiskHandler(QtMsgType type, const QMessageLogContext&, const QString& msg)
 {
-    QString typeTxt;
+    const char* typeTxt = "Unknown";
 
     switch (type) {
     case QtDebugMsg:
@@ -192,10 +135,8 @@ void qtLogToDiskHandler(QtMsgType type, const QMessageLogContext&, const QString
         break;
     }
 
-    QTime logTime = QTime::fromMSecsSinceStartOfDay(s_LoggerTime.elapsed());
-    QString txt = QString("%1 - Qt %2: %3\n").arg(logTime.toString()).arg(typeTxt).arg(msg);
-
-    logToLoggerStream(txt);
+    QByteArray txt = msg.toUtf8();
+    Logger::log(LogSourceQt, typeTxt, 0, txt.constData(), txt.size());
 }
 
 #ifdef HAVE_FFMPEG
@@ -219,15 +160,8 @@ void ffmpegLogToDiskHandler(void* ptr, int level, const char* fmt, va_list vl)
 
     av_log_format_line(ptr, level, fmt, vl, lineBuffer, sizeof(lineBuffer), &printPrefix);
 
-    if (shouldPrefixThisMessage) {
-        QTime logTime = QTime::fromMSecsSinceStartOfDay(s_LoggerTime.elapsed());
-        QString txt = QString("%1 - FFmpeg: %2").arg(logTime.toString()).arg(lineBuffer);
-        logToLoggerStream(txt);
-    }
-    else {
-        QString txt = QString(lineBuffer);
-        logToLoggerStream(txt);
-    }
+    Logger::log(LogSourceFfmpeg, shouldPrefixThisMessage ? "" : nullptr, 0,
+                lineBuffer, (int)strlen(lineBuffer));
 }
 
 #endif
@@ -339,14 +273,15 @@ int main(int argc, char *argv[])
     s_LoggerFile = new QFile(tempDir.filePath(QString("Moonlight-%1.log").arg(QDateTime::currentSecsSinceEpoch())));
     if (s_LoggerFile->open(QIODevice::WriteOnly | QIODevice::Text)) {
         QTextStream(stderr) << "Redirecting log output to " << s_LoggerFile->fileName() << Qt::endl;
-        s_LoggerStream.setDevice(s_LoggerFile);
+        Logger::initialize(s_LoggerFile, k_MaxLogSizeBytes);
+    }
+    else {
+        Logger::initialize(nullptr, k_MaxLogSizeBytes);
     }
+#else
+    Logger::initialize(nullptr, 0);
 #endif
 
-    // Serialize log messages on a single thread
-    s_LoggerThread.setMaxThreadCount(1);
-    s_LoggerTime.start();
-
     // Register our logger with all libraries
 #if SDL_VERSION_ATLEAST(3, 0, 0)
     SDL_SetLogOutputFunction(sdlLogToDiskHandler, nullptr);
@@ -484,10 +419,17 @@ int main(int argc, char *argv[])
     configureSignalHandlers();
 #endif
 
+    // The box art cache is used from worker threads, so it must
+    // be created on the main thread before any of them start.
+    BoxArtCache::initialize();
+
     GlobalCommandLineParser parser;
     GlobalCommandLineParser::ParseResult commandLineParserResult = parser.parse(app.arguments());
     switch (commandLineParserResult) {
     case GlobalCommandLineParser::ListRequested:
+    case GlobalCommandLineParser::BenchmarkAudioRequested:
+    case GlobalCommandLineParser::ReplayInputRequested:
+    case GlobalCommandLineParser::BenchmarkServerInfoRequested:
         // Don't log to the console since it will jumble the command output
         s_SuppressVerboseOutput = true;
         break;
@@ -632,16 +574,55 @@ int main(int argc, char *argv[])
             hasGUI = false;
             break;
         }
+    case GlobalCommandLineParser::BenchmarkAudioRequested:
+        {
+            BenchmarkAudioCommandLineParser benchmarkParser;
+            benchmarkParser.parse(app.arguments());
+            int exitCode = CliBenchmarkAudio::run(benchmarkParser);
+
+            // Exit as soon as the event loop starts
+            QMetaObject::invokeMethod(&app, [exitCode]() { QCoreApplication::exit(exitCode); }, Qt::QueuedConnection);
+            hasGUI = false;
+            break;
+        }
+    case GlobalCommandLineParser::ReplayInputRequested:
+        {
+            ReplayInputCommandLineParser replayParser;
+            replayParser.parse(app.arguments());
+            int exitCode = CliReplayInput::run(replayParser);
+
+            // Exit as soon as the event loop starts
+            QMetaObject::invokeMethod(&app, [exitCode]() { QCoreApplication::exit(exitCode); }, Qt::QueuedConnection);
+            hasGUI = false;
+            break;
+        }
+    case GlobalCommandLineParser::BenchmarkServerInfoRequested:
+        {
+            BenchmarkServerInfoCommandLineParser benchmarkParser;
+            benchmarkParser.parse(app.arguments());
+            int exitCode = CliBenchmarkServerInfo::run(benchmarkParser);
+
+            // Exit as soon as the event loop starts
+            QMetaObject::invokeMethod(&app, [exitCode]() { QCoreApplication::exit(exitCode); }, Qt::QueuedConnection);
+            hasGUI = false;
+            break;
+        }
     }
 
     if (hasGUI) {
         engine.rootContext()->setContextProperty("initialView", initialView);
         engine.rootContext()->setContextProperty("runConfigChecks", commandLineParserResult == GlobalCommandLineParser::NormalStartRequested);
 
+        // The engine takes ownership of the image provider
+        engine.addImageProvider("boxart", new BoxArtImageProvider());
+
         // Load the main.qml file
         engine.load(QUrl(QStringLiteral("qrc:/gui/main.qml")));
         if (engine.rootObjects().isEmpty())
             return -1;
+
+        // Find out whether we need larger audio packets before the first stream
+        Session::startOpusDecoderSpeedTest();
     }
 
     int err = app.exec();
@@ -665,7 +646,7 @@ int main(int argc, char *argv[])
     Q_ASSERT(g_AsyncLoggingEnabled == 0);
 
     // Wait for pending log messages to be printed
-    s_LoggerThread.waitForDone();
+    Logger::shutdown();
 
     return err;
 }
@@ -10,6 +10,7 @@ QString Path::s_CacheDir;
 QString Path::s_LogDir;
 QString Path::s_BoxArtCacheDir;
 QString Path::s_QmlCacheDir;
+QString Path::s_HostStoreDir;
 
 QString Path::getLogDir()
 {
@@ -29,6 +30,12 @@ QString Path::getQmlCacheDir()
     return s_QmlCacheDir;
 }
 
+QString Path::getHostStoreDir()
+{
+    Q_ASSERT(!s_HostStoreDir.isEmpty());
+    return s_HostStoreDir;
+}
+
 QByteArray Path::readDataFile(QString fileName)
 {
     QFile dataFile(getDataFilePath(fileName));
@@ -108,6 +115,7 @@ void Path::initialize(bool portable)
         s_LogDir = QDir::currentPath();
         s_BoxArtCacheDir = QDir::currentPath() + "/boxart";
         s_QmlCacheDir = QDir::currentPath() + "/qmlcache";
+        s_HostStoreDir = QDir::currentPath() + "/hosts";
 
         // In order for the If-Modified-Since logic to work in MappingFetcher,
         // the cache directory must be different than the current directory.
@@ -124,5 +132,6 @@ void Path::initialize(bool portable)
         s_CacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
         s_BoxArtCacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/boxart";
         s_QmlCacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/qmlcache";
+        s_HostStoreDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/hosts";
     }
 }
@@ -1,14 +1,102 @@
 #include "../session.h"
+#include "../startupprofiler.h"
+#include "opusbench.h"
 #include "renderers/renderer.h"
+#include "utils.h"
 
 #ifdef HAVE_SLAUDIO
 #include "renderers/slaud.h"
 #endif
 
 #include "renderers/sdl.h"
+#include "renderers/null.h"
+#include "renderers/wav.h"
 
 #include <Limelight.h>
 
+#include <QMap>
+#include <QMutex>
+#include <QRunnable>
+#include <QThreadPool>
+
+// Enough packets that a single preemption or page fault
+// can't move the median cost we use to make our decision.
+#define OPUS_SPEED_TEST_PACKETS 500
+
+// Results are cached for the life of the process since the decoding
+// performance of the client won't change, unless the decoder was found to
+// be slow. In that case, we measure again after the next stream in case
+// something else was hogging the CPU.
+static QMutex s_OpusSpeedTestLock;
+static QMap<int, bool> s_SlowOpusDecoderCache;
+static QList<int> s_PendingOpusSpeedTests;
+
+class OpusSpeedTestTask : public QRunnable
+{
+public:
+    OpusSpeedTestTask(const QList<int>& channelCounts) :
+        m_ChannelCounts(channelCounts) {}
+
+private:
+    void run() override
+    {
+        for (int channelCount : m_ChannelCounts) {
+            // Measure the cost of 5 ms packets which are used unless we
+            // tell the host that our Opus decoder is slow.
+            OpusDecodeBenchmark::RESULT result;
+#ifdef HAVE_SLAUDIO
+            bool floatOutput = false;
+#else
+            bool floatOutput = true;
+#endif
+            bool ok = OpusDecodeBenchmark::run(channelCount, 240, floatOutput,
+                                               OPUS_SPEED_TEST_PACKETS, &result);
+
+            // The audio thread also has to receive and decrypt packets and
+            // submit them to the audio device, so we consider the decoder to
+            // be slow if it typically needs more than a quarter of each
+            // packet's duration.
+            bool slow = ok && result.p50Us > 5000 / 4;
+            if (ok) {
+                SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                            "Opus decode cost for %d channels: %.1f us (median) %.1f us (p99) - %s",
+                            channelCount,
+                            result.p50Us,
+                            result.p99Us,
+                            slow ? "slow" : "fast");
+            }
+
+            QMutexLocker locker(&s_OpusSpeedTestLock);
+            if (ok) {
+                s_SlowOpusDecoderCache.insert(channelCount, slow);
+            }
+            s_PendingOpusSpeedTests.removeAll(channelCount);
+        }
+    }
+
+    QList<int> m_ChannelCounts;
+};
+
+// Must be called with s_OpusSpeedTestLock held
+static
+void queueOpusSpeedTests(const QList<int>& channelCounts)
+{
+    QList<int> newChannelCounts;
+
+    for (int channelCount : channelCounts) {
+        // Skip decoders we already know are fast
+        if (s_SlowOpusDecoderCache.value(channelCount, true) &&
+                !s_PendingOpusSpeedTests.contains(channelCount)) {
+            newChannelCounts.append(channelCount);
+        }
+    }
+
+    if (!newChannelCounts.isEmpty()) {
+        s_PendingOpusSpeedTests.append(newChannelCounts);
+        QThreadPool::globalInstance()->start(new OpusSpeedTestTask(newChannelCounts));
+    }
+}
+
 #define TRY_INIT_RENDERER(renderer, opusConfig)        \
 {                                                      \
     IAudioRenderer* __renderer = new renderer();       \
@@ -25,6 +113,14 @@ IAudioRenderer* Session::createAudioRenderer(const POPUS_MULTISTREAM_CONFIGURATI
         TRY_INIT_RENDERER(SdlAudioRenderer, opusConfig)
         return nullptr;
     }
+    else if (mlAudio == "null") {
+        TRY_INIT_RENDERER(NullAudioRenderer, opusConfig)
+        return nullptr;
+    }
+    else if (mlAudio == "wav") {
+        TRY_INIT_RENDERER(WavAudioRenderer, opusConfig)
+        return nullptr;
+    }
 #if defined(HAVE_SLAUDIO)
     else if (mlAudio == "slaudio") {
         TRY_INIT_RENDERER(SLAudioRenderer, opusConfig)
@@ -66,6 +162,8 @@ bool Session::initializeAudioRenderer()
         return false;
     }
 
+    m_AudioRenderer->setStatsWindow(&m_ActiveWndAudioStats);
+
     // Allow the chosen renderer to remap Opus channels as needed to ensure proper output
     m_ActiveAudioConfig = m_OriginalAudioConfig;
     m_AudioRenderer->remapChannels(&m_ActiveAudioConfig);
@@ -93,19 +191,55 @@ bool Session::initializeAudioRenderer()
     return true;
 }
 
-int Session::getAudioRendererCapabilities(int audioConfiguration)
+void Session::startOpusDecoderSpeedTest()
 {
-    int caps = 0;
+    QMutexLocker locker(&s_OpusSpeedTestLock);
 
-    Q_UNUSED(audioConfiguration);
+    // Stereo first since it's what most users stream with
+    queueOpusSpeedTests({ 2, 6, 8 });
+}
 
-    // All audio renderers support arbitrary audio duration
-    caps |= CAPABILITY_SUPPORTS_ARBITRARY_AUDIO_DURATION;
+bool Session::isOpusDecoderSlow(int audioConfiguration)
+{
+    int channelCount = CHANNEL_COUNT_FROM_AUDIO_CONFIGURATION(audioConfiguration);
+    bool slow;
+
+    if (Utils::getEnvironmentVariableOverride("SLOW_OPUS_DECODER", &slow)) {
+        return slow;
+    }
+
+    QMutexLocker locker(&s_OpusSpeedTestLock);
+
+    // Even if we're going to measure this again, keep using the
+    // last result until we're done streaming.
+    if (s_SlowOpusDecoderCache.contains(channelCount)) {
+        return s_SlowOpusDecoderCache.value(channelCount);
+    }
+
+    // Don't hold up the stream or compete with it for CPU time by running
+    // the benchmark now. It will run once this stream is over.
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "Opus decoder speed for %d channels is not known yet",
+                channelCount);
 
 #ifdef STEAM_LINK
     // Steam Link devices have slow Opus decoders
-    caps |= CAPABILITY_SLOW_OPUS_DECODER;
+    return true;
+#else
+    return false;
 #endif
+}
+
+int Session::getAudioRendererCapabilities(int audioConfiguration)
+{
+    int caps = 0;
+
+    // All audio renderers support arbitrary audio duration
+    caps |= CAPABILITY_SUPPORTS_ARBITRARY_AUDIO_DURATION;
+
+    if (isOpusDecoderSlow(audioConfiguration)) {
+        caps |= CAPABILITY_SLOW_OPUS_DECODER;
+    }
 
     return caps;
 }
@@ -119,13 +253,17 @@ bool Session::testAudio(int audioConfiguration)
     opusConfig.samplesPerFrame = 240;
     opusConfig.channelCount = CHANNEL_COUNT_FROM_AUDIO_CONFIGURATION(audioConfiguration);
 
+    int phase = StartupProfiler::get()->beginPhase("testAudio (%d channels)", opusConfig.channelCount);
+
     IAudioRenderer* audioRenderer = createAudioRenderer(&opusConfig);
     if (audioRenderer == nullptr) {
+        StartupProfiler::get()->endPhase(phase, false);
         return false;
     }
 
     delete audioRenderer;
 
+    StartupProfiler::get()->endPhase(phase);
     return true;
 }
 
@@ -138,8 +276,134 @@ int Session::arInit(int /* audioConfiguration */,
     return 0;
 }
 
+void Session::addAudioStats(AUDIO_STATS& src, AUDIO_STATS& dst)
+{
+    dst.receivedPackets += src.receivedPackets;
+    dst.decodedPackets += src.decodedPackets;
+    dst.submittedPackets += src.submittedPackets;
+    dst.droppedPackets += src.droppedPackets;
+    dst.droppedSamples += src.droppedSamples;
+    dst.underruns += src.underruns;
+    dst.totalQueueDepthMs += src.totalQueueDepthMs;
+    dst.maxQueueDepthMs = qMax(dst.maxQueueDepthMs, src.maxQueueDepthMs);
+    dst.totalDecodeTimeUs += src.totalDecodeTimeUs;
+    dst.totalBackpressureTimeUs += src.totalBackpressureTimeUs;
+    dst.totalOutputLatencyUs += src.totalOutputLatencyUs;
+    dst.packetsWithOutputLatency += src.packetsWithOutputLatency;
+
+    // Initialize the measurement start point if this is the first audio stat window
+    if (!dst.measurementStartUs) {
+        dst.measurementStartUs = src.measurementStartUs;
+    }
+}
+
+void Session::stringifyAudioStats(AUDIO_STATS& stats, char* output, int length)
+{
+    int offset = 0;
+    int ret;
+
+    // Start with an empty string
+    output[offset] = 0;
+
+    if (stats.receivedPackets == 0) {
+        return;
+    }
+
+    double avgDecodeMs = stats.decodedPackets != 0 ?
+                             (double)(stats.totalDecodeTimeUs / 1000.0) / stats.decodedPackets :
+                             0.0;
+    double avgQueueMs = stats.submittedPackets != 0 ?
+                            (double)stats.totalQueueDepthMs / stats.submittedPackets :
+                            0.0;
+    double avgWaitMs = stats.submittedPackets != 0 ?
+                           (double)(stats.totalBackpressureTimeUs / 1000.0) / stats.submittedPackets :
+                           0.0;
+
+    ret = snprintf(&output[offset],
+                   length - offset,
+                   "Audio Decode %.2f ms  Queue %.1f ms (max %u)\n"
+                   "Audio Wait %.2f ms  Underruns %u  Dropped %u samples\n",
+                   avgDecodeMs,
+                   avgQueueMs,
+                   stats.maxQueueDepthMs,
+                   avgWaitMs,
+                   stats.underruns,
+                   stats.droppedSamples);
+    if (ret < 0 || ret >= length - offset) {
+        SDL_assert(false);
+        return;
+    }
+
+    offset += ret;
+
+    if (stats.packetsWithOutputLatency != 0) {
+        ret = snprintf(&output[offset],
+                       length - offset,
+                       "Audio Output Latency %.1f ms\n",
+                       (double)(stats.totalOutputLatencyUs / 1000.0) / stats.packetsWithOutputLatency);
+        if (ret < 0 || ret >= length - offset) {
+            SDL_assert(false);
+            return;
+        }
+
+        offset += ret;
+    }
+}
+
+void Session::logAudioStats(AUDIO_STATS& stats, const char* title)
+{
+    if (stats.receivedPackets != 0) {
+        char audioStatsStr[512];
+        stringifyAudioStats(stats, audioStatsStr, sizeof(audioStatsStr));
+
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "\n%s\n------------------\n"
+                    "Packets received/decoded/submitted: %u/%u/%u\n%s",
+                    title,
+                    stats.receivedPackets,
+                    stats.decodedPackets,
+                    stats.submittedPackets,
+                    audioStatsStr);
+    }
+}
+
+void Session::appendAudioStats(char* output, int length)
+{
+    int offset = (int)strlen(output);
+
+    SDL_AtomicLock(&m_AudioStatsLock);
+    stringifyAudioStats(m_LastWndAudioStats, &output[offset], length - offset);
+    SDL_AtomicUnlock(&m_AudioStatsLock);
+}
+
+// Called on the audio thread
+void Session::flipAudioStatsWindow()
+{
+    uint64_t now = LiGetMicroseconds();
+
+    if (m_ActiveWndAudioStats.measurementStartUs == 0) {
+        m_ActiveWndAudioStats.measurementStartUs = now;
+    }
+    else if (now > m_ActiveWndAudioStats.measurementStartUs + 1000000) {
+        // The lock protects the last window from concurrent readers
+        // on the video decoder thread that populate the overlay.
+        SDL_AtomicLock(&m_AudioStatsLock);
+        addAudioStats(m_ActiveWndAudioStats, m_GlobalAudioStats);
+        SDL_memcpy(&m_LastWndAudioStats, &m_ActiveWndAudioStats, sizeof(m_ActiveWndAudioStats));
+        SDL_AtomicUnlock(&m_AudioStatsLock);
+
+        SDL_zero(m_ActiveWndAudioStats);
+        m_ActiveWndAudioStats.measurementStartUs = now;
+    }
+}
+
 void Session::arCleanup()
 {
+    // Accumulate the partial window and log stats for the whole session
+    s_ActiveSession->addAudioStats(s_ActiveSession->m_ActiveWndAudioStats, s_ActiveSession->m_GlobalAudioStats);
+    SDL_zero(s_ActiveSession->m_ActiveWndAudioStats);
+    s_ActiveSession->logAudioStats(s_ActiveSession->m_GlobalAudioStats, "Global audio stats");
+
     delete s_ActiveSession->m_AudioRenderer;
     s_ActiveSession->m_AudioRenderer = nullptr;
 
@@ -165,6 +429,9 @@ void Session::arDecodeAndPlaySample(char* sampleData, int sampleLength)
     }
 #endif
 
+    s_ActiveSession->flipAudioStatsWindow();
+    s_ActiveSession->m_ActiveWndAudioStats.receivedPackets++;
+
     // See if we need to drop this sample
     if (s_ActiveSession->m_DropAudioEndTime != 0) {
         if (SDL_TICKS_PASSED(SDL_GetTicks(), s_ActiveSession->m_DropAudioEndTime)) {
@@ -176,6 +443,8 @@ void Session::arDecodeAndPlaySample(char* sampleData, int sampleLength)
         }
         else {
             // We're still in the drop window
+            s_ActiveSession->m_ActiveWndAudioStats.droppedPackets++;
+            s_ActiveSession->m_ActiveWndAudioStats.droppedSamples += s_ActiveSession->m_OriginalAudioConfig.samplesPerFrame;
             return;
         }
     }
@@ -196,6 +465,7 @@ void Session::arDecodeAndPlaySample(char* sampleData, int sampleLength)
             return;
         }
 
+        uint64_t decodeStartUs = LiGetMicroseconds();
         if (s_ActiveSession->m_AudioRenderer->getAudioBufferFormat() == IAudioRenderer::AudioFormat::Float32NE) {
             samplesDecoded = opus_multistream_decode_float(s_ActiveSession->m_OpusDecoder,
                                                            (unsigned char*)sampleData,
@@ -213,10 +483,19 @@ void Session::arDecodeAndPlaySample(char* sampleData, int sampleLength)
                                                      0);
         }
 
+        s_ActiveSession->m_ActiveWndAudioStats.totalDecodeTimeUs += LiGetMicroseconds() - decodeStartUs;
+
         // Update desiredSize with the number of bytes actually populated by the decoding operation
         if (samplesDecoded > 0) {
             SDL_assert(desiredBufferSize >= frameSize * samplesDecoded);
             desiredBufferSize = frameSize * samplesDecoded;
+            s_ActiveSession->m_ActiveWndAudioStats.decodedPackets++;
+
+            // Sample the depth of the receive queue at the time of submission
+            uint32_t queueDepthMs = LiGetPendingAudioDuration();
+            s_ActiveSession->m_ActiveWndAudioStats.totalQueueDepthMs += queueDepthMs;
+            s_ActiveSession->m_ActiveWndAudioStats.maxQueueDepthMs = qMax(s_ActiveSession->m_ActiveWndAudioStats.maxQueueDepthMs, queueDepthMs);
+            s_ActiveSession->m_ActiveWndAudioStats.submittedPackets++;
         }
         else {
             desiredBufferSize = 0;
@@ -0,0 +1,198 @@
+#include "opusbench.h"
+
+#include "SDL_compat.h"
+
+#include <opus_multistream.h>
+
+#include <QtMath>
+#include <algorithm>
+
+#define BENCHMARK_SAMPLE_RATE 48000
+
+// Packets decoded before timing starts to warm up caches
+#define BENCHMARK_WARMUP_PACKETS 10
+
+bool OpusDecodeBenchmark::generatePackets(int channelCount, int samplesPerFrame, int packetCount,
+                                          POPUS_MULTISTREAM_CONFIGURATION opusConfig,
+                                          QVector<QByteArray>& packets)
+{
+    int err;
+
+    SDL_zerop(opusConfig);
+    opusConfig->sampleRate = BENCHMARK_SAMPLE_RATE;
+    opusConfig->channelCount = channelCount;
+    opusConfig->samplesPerFrame = samplesPerFrame;
+
+    OpusMSEncoder* encoder =
+            opus_multistream_surround_encoder_create(opusConfig->sampleRate,
+                                                     channelCount,
+                                                     channelCount > 2 ? 1 : 0,
+                                                     &opusConfig->streams,
+                                                     &opusConfig->coupledStreams,
+                                                     opusConfig->mapping,
+                                                     OPUS_APPLICATION_RESTRICTED_LOWDELAY,
+                                                     &err);
+    if (encoder == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Failed to create Opus encoder: %d",
+                     err);
+        return false;
+    }
+
+    // Match the default bitrates used by hosts for normal quality audio
+    int bitrate;
+    switch (channelCount) {
+    case 2:
+        bitrate = 96000;
+        break;
+    case 6:
+        bitrate = 256000;
+        break;
+    default:
+        bitrate = 450000;
+        break;
+    }
+    opus_multistream_encoder_ctl(encoder, OPUS_SET_BITRATE(bitrate));
+
+    QVector<float> pcm(samplesPerFrame * channelCount);
+    unsigned char packet[4000];
+    uint32_t noiseState = 0x12345678;
+    int64_t sampleIndex = 0;
+
+    packets.clear();
+    packets.reserve(packetCount);
+    for (int i = 0; i < packetCount; i++) {
+        // Generate a distinct tone plus some noise on each channel so the
+        // encoder can't take any shortcuts on silent or identical channels.
+        for (int s = 0; s < samplesPerFrame; s++, sampleIndex++) {
+            for (int c = 0; c < channelCount; c++) {
+                noiseState = noiseState * 1664525 + 1013904223;
+                float noise = ((int32_t)noiseState / 2147483648.0f) * 0.05f;
+                float tone = qSin(2 * M_PI * (220.0 * (c + 1)) * sampleIndex / opusConfig->sampleRate) * 0.4f;
+                pcm[s * channelCount + c] = tone + noise;
+            }
+        }
+
+        int len = opus_multistream_encode_float(encoder, pcm.constData(), samplesPerFrame,
+                                                packet, sizeof(packet));
+        if (len < 0) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                         "opus_multistream_encode_float() failed: %d",
+                         len);
+            opus_multistream_encoder_destroy(encoder);
+            return false;
+        }
+
+        packets.append(QByteArray((const char*)packet, len));
+    }
+
+    opus_multistream_encoder_destroy(encoder);
+    return true;
+}
+
+bool OpusDecodeBenchmark::measureDecode(const OPUS_MULTISTREAM_CONFIGURATION* opusConfig,
+                                        const QVector<QByteArray>& packets,
+                                        bool floatOutput,
+                                        PRESULT result)
+{
+    int err;
+
+    if (packets.size() <= BENCHMARK_WARMUP_PACKETS) {
+        return false;
+    }
+
+    OpusMSDecoder* decoder =
+            opus_multistream_decoder_create(opusConfig->sampleRate,
+                                            opusConfig->channelCount,
+                                            opusConfig->streams,
+                                            opusConfig->coupledStreams,
+                                            opusConfig->mapping,
+                                            &err);
+    if (decoder == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Failed to create decoder: %d",
+                     err);
+        return false;
+    }
+
+    QVector<float> floatPcm(opusConfig->samplesPerFrame * opusConfig->channelCount);
+    QVector<short> shortPcm(opusConfig->samplesPerFrame * opusConfig->channelCount);
+    QVector<double> costsUs;
+    costsUs.reserve(packets.size());
+
+    Uint64 perfFreq = SDL_GetPerformanceFrequency();
+    for (int i = 0; i < packets.size(); i++) {
+        const QByteArray& packet = packets.at(i);
+        int samplesDecoded;
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        if (floatOutput) {
+            samplesDecoded = opus_multistream_decode_float(decoder,
+                                                           (const unsigned char*)packet.constData(),
+                                                           packet.size(),
+                                                           floatPcm.data(),
+                                                           opusConfig->samplesPerFrame,
+                                                           0);
+        }
+        else {
+            samplesDecoded = opus_multistream_decode(decoder,
+                                                     (const unsigned char*)packet.constData(),
+                                                     packet.size(),
+                                                     shortPcm.data(),
+                                                     opusConfig->samplesPerFrame,
+                                                     0);
+        }
+        Uint64 end = SDL_GetPerformanceCounter();
+
+        if (samplesDecoded <= 0) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                         "Opus decode failed: %d",
+                         samplesDecoded);
+            opus_multistream_decoder_destroy(decoder);
+            return false;
+        }
+
+        if (i >= BENCHMARK_WARMUP_PACKETS) {
+            costsUs.append((double)(end - start) * 1000000.0 / perfFreq);
+        }
+    }
+
+    opus_multistream_decoder_destroy(decoder);
+
+    std::sort(costsUs.begin(), costsUs.end());
+
+    double totalUs = 0;
+    for (double cost : costsUs) {
+        totalUs += cost;
+    }
+
+    int count = (int)costsUs.size();
+    auto percentile = [&costsUs, count](int pct) {
+        return costsUs.at(qMin(count - 1, (int)((int64_t)count * pct / 100)));
+    };
+
+    result->channelCount = opusConfig->channelCount;
+    result->samplesPerFrame = opusConfig->samplesPerFrame;
+    result->floatOutput = floatOutput;
+    result->packetCount = count;
+    result->meanUs = totalUs / count;
+    result->p50Us = percentile(50);
+    result->p90Us = percentile(90);
+    result->p99Us = percentile(99);
+    result->maxUs = costsUs.last();
+    return true;
+}
+
+bool OpusDecodeBenchmark::run(int channelCount, int samplesPerFrame, bool floatOutput,
+                              int packetCount, PRESULT result)
+{
+    OPUS_MULTISTREAM_CONFIGURATION opusConfig;
+    QVector<QByteArray> packets;
+
+    if (!generatePackets(channelCount, samplesPerFrame, packetCount + BENCHMARK_WARMUP_PACKETS,
+                         &opusConfig, packets)) {
+        return false;
+    }
+
+    return measureDecode(&opusConfig, packets, floatOutput, result);
+}
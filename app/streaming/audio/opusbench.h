@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Limelight.h>
+#include <QByteArray>
+#include <QVector>
+
+class OpusDecodeBenchmark
+{
+public:
+    typedef struct _RESULT {
+        int channelCount;
+        int samplesPerFrame;
+        bool floatOutput;
+        int packetCount;
+        double meanUs;
+        double p50Us;
+        double p90Us;
+        double p99Us;
+        double maxUs;
+    } RESULT, *PRESULT;
+
+    // Encodes synthetic audio into Opus multistream packets using the same
+    // stream layout and bitrates that hosts use for the given channel count.
+    static
+    bool generatePackets(int channelCount, int samplesPerFrame, int packetCount,
+                         POPUS_MULTISTREAM_CONFIGURATION opusConfig,
+                         QVector<QByteArray>& packets);
+
+    // Decodes the packets and reports per-packet decode cost percentiles
+    static
+    bool measureDecode(const OPUS_MULTISTREAM_CONFIGURATION* opusConfig,
+                       const QVector<QByteArray>& packets,
+                       bool floatOutput,
+                       PRESULT result);
+
+    static
+    bool run(int channelCount, int samplesPerFrame, bool floatOutput,
+             int packetCount, PRESULT result);
+};
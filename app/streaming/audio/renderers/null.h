@@ -0,0 +1,35 @@
+#pragma once
+
+#include "renderer.h"
+#include "SDL_compat.h"
+
+// Audio renderer that discards all samples. It simulates a device clock to
+// provide the same backpressure behavior as a real output device, which allows
+// benchmarking the audio pipeline on machines without audio hardware.
+class NullAudioRenderer : public IAudioRenderer
+{
+public:
+    NullAudioRenderer();
+
+    virtual ~NullAudioRenderer();
+
+    virtual bool prepareForPlayback(const OPUS_MULTISTREAM_CONFIGURATION* opusConfig);
+
+    virtual void* getAudioBuffer(int* size);
+
+    virtual bool submitAudio(int bytesWritten);
+
+    virtual AudioFormat getAudioBufferFormat();
+
+private:
+    uint64_t getQueuedDurationUs();
+
+    void* m_AudioBuffer;
+    int m_FrameSize;
+    int m_FrameDurationUs;
+    int m_BytesPerSecond;
+    int m_ClockPpm;
+    bool m_Unclocked;
+    uint64_t m_DeviceClockStartUs;
+    uint64_t m_SubmittedDurationUs;
+};
@@ -0,0 +1,133 @@
+#include "null.h"
+#include "utils.h"
+
+#include <Limelight.h>
+
+NullAudioRenderer::NullAudioRenderer()
+    : m_AudioBuffer(nullptr),
+      m_FrameSize(0),
+      m_FrameDurationUs(0),
+      m_BytesPerSecond(0),
+      m_ClockPpm(0),
+      m_Unclocked(false),
+      m_DeviceClockStartUs(0),
+      m_SubmittedDurationUs(0)
+{
+}
+
+bool NullAudioRenderer::prepareForPlayback(const OPUS_MULTISTREAM_CONFIGURATION* opusConfig)
+{
+    m_FrameSize = opusConfig->samplesPerFrame *
+                  opusConfig->channelCount *
+                  getAudioBufferSampleSize();
+    m_BytesPerSecond = opusConfig->sampleRate *
+                       opusConfig->channelCount *
+                       getAudioBufferSampleSize();
+    m_FrameDurationUs = (int)((uint64_t)opusConfig->samplesPerFrame * 1000000 / opusConfig->sampleRate);
+
+    // The simulated device clock can be skewed relative to the system clock
+    // to reproduce the drift of real audio hardware (in parts per million).
+    if (Utils::getEnvironmentVariableOverride("NULL_AUDIO_CLOCK_PPM", &m_ClockPpm)) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                    "Using simulated audio device clock skew: %d ppm",
+                    m_ClockPpm);
+    }
+
+    // An unclocked device consumes samples as fast as they are submitted,
+    // which is useful for measuring the raw cost of the decoding path.
+    if (Utils::getEnvironmentVariableOverride("NULL_AUDIO_UNCLOCKED", &m_Unclocked) && m_Unclocked) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                    "Simulated audio device clock is disabled");
+    }
+
+    m_AudioBuffer = SDL_malloc(m_FrameSize);
+    if (m_AudioBuffer == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Failed to allocate audio buffer");
+        return false;
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "Using null audio renderer with %d samples per frame",
+                opusConfig->samplesPerFrame);
+
+    return true;
+}
+
+NullAudioRenderer::~NullAudioRenderer()
+{
+    if (m_AudioBuffer != nullptr) {
+        SDL_free(m_AudioBuffer);
+    }
+}
+
+void* NullAudioRenderer::getAudioBuffer(int*)
+{
+    return m_AudioBuffer;
+}
+
+uint64_t NullAudioRenderer::getQueuedDurationUs()
+{
+    if (m_DeviceClockStartUs == 0) {
+        return 0;
+    }
+
+    // Compute how much audio the simulated device has played since it started
+    uint64_t playedDurationUs = (LiGetMicroseconds() - m_DeviceClockStartUs) * (1000000 + m_ClockPpm) / 1000000;
+    if (playedDurationUs >= m_SubmittedDurationUs) {
+        // The device has run dry
+        return 0;
+    }
+
+    return m_SubmittedDurationUs - playedDurationUs;
+}
+
+bool NullAudioRenderer::submitAudio(int bytesWritten)
+{
+    if (bytesWritten == 0 || m_Unclocked) {
+        // Nothing to do
+        return true;
+    }
+
+    // Don't queue if there's already more than 30 ms of audio data waiting
+    // in Moonlight's audio queue. This matches the SDL renderer's behavior.
+    if (LiGetPendingAudioDuration() > 30) {
+        return true;
+    }
+
+    // If the simulated device ran out of samples, it restarts
+    // playback from the point where the new samples arrive.
+    if (getQueuedDurationUs() == 0) {
+        if (m_Stats != nullptr && m_DeviceClockStartUs != 0) {
+            m_Stats->underruns++;
+        }
+
+        m_DeviceClockStartUs = LiGetMicroseconds();
+        m_SubmittedDurationUs = 0;
+    }
+
+    // Provide backpressure in the same way the SDL renderer does when
+    // there are more than 10 frames waiting in the device queue.
+    uint64_t backpressureStartUs = LiGetMicroseconds();
+    for (int i = 0; i < 100; i++) {
+        if (getQueuedDurationUs() <= (uint64_t)m_FrameDurationUs * 10) {
+            break;
+        }
+
+        SDL_Delay(1);
+    }
+
+    if (m_Stats != nullptr) {
+        m_Stats->totalBackpressureTimeUs += LiGetMicroseconds() - backpressureStartUs;
+        m_Stats->totalOutputLatencyUs += getQueuedDurationUs();
+        m_Stats->packetsWithOutputLatency++;
+    }
+
+    m_SubmittedDurationUs += (uint64_t)bytesWritten * 1000000 / m_BytesPerSecond;
+    return true;
+}
+
+IAudioRenderer::AudioFormat NullAudioRenderer::getAudioBufferFormat()
+{
+    return AudioFormat::Float32NE;
+}
@@ -3,9 +3,27 @@
 #include <Limelight.h>
 #include <QtGlobal>
 
+typedef struct _AUDIO_STATS {
+    uint32_t receivedPackets;
+    uint32_t decodedPackets;
+    uint32_t submittedPackets;
+    uint32_t droppedPackets;                   // dropped during drop windows
+    uint32_t droppedSamples;                   // dropped during drop windows
+    uint32_t underruns;                        // reported by renderer
+    uint32_t totalQueueDepthMs;                // low-res from moonlight-common-c (1ms)
+    uint32_t maxQueueDepthMs;                  // low-res from moonlight-common-c (1ms)
+    uint64_t totalDecodeTimeUs;                // high-res (1us)
+    uint64_t totalBackpressureTimeUs;          // high-res (1us), reported by renderer
+    uint64_t totalOutputLatencyUs;             // high-res (1us), reported by renderer
+    uint32_t packetsWithOutputLatency;
+    uint64_t measurementStartUs;               // microseconds
+} AUDIO_STATS, *PAUDIO_STATS;
+
 class IAudioRenderer
 {
 public:
+    IAudioRenderer() : m_Stats(nullptr) {}
+
     virtual ~IAudioRenderer() {}
 
     virtual bool prepareForPlayback(const OPUS_MULTISTREAM_CONFIGURATION* opusConfig) = 0;
@@ -41,4 +59,13 @@ public:
             Q_UNREACHABLE();
         }
     }
+
+    // Stats are only written from submitAudio() on the audio thread
+    void setStatsWindow(PAUDIO_STATS stats) {
+        m_Stats = stats;
+    }
+
+protected:
+    // May be null (such as for test renderers)
+    PAUDIO_STATS m_Stats;
 };
@@ -22,4 +22,7 @@ private:
     SDL_AudioDeviceID m_AudioDevice;
     void* m_AudioBuffer;
     int m_FrameSize;
+    int m_BytesPerSecond;
+    int m_DeviceBufferUs;
+    bool m_HasQueuedAudio;
 };
@@ -4,7 +4,10 @@
 
 SdlAudioRenderer::SdlAudioRenderer()
     : m_AudioDevice(0),
-      m_AudioBuffer(nullptr)
+      m_AudioBuffer(nullptr),
+      m_BytesPerSecond(0),
+      m_DeviceBufferUs(0),
+      m_HasQueuedAudio(false)
 {
     SDL_assert(!SDL_WasInit(SDL_INIT_AUDIO));
 
@@ -51,6 +54,10 @@ bool SdlAudioRenderer::prepareForPlayback(const OPUS_MULTISTREAM_CONFIGURATION*
         return false;
     }
 
+    // Used to estimate output latency for the stats overlay
+    m_BytesPerSecond = have.freq * have.channels * getAudioBufferSampleSize();
+    m_DeviceBufferUs = (int)((uint64_t)have.samples * 1000000 / have.freq);
+
     SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
                 "Desired audio buffer: %u samples (%u bytes)",
                 want.samples,
@@ -105,9 +112,16 @@ bool SdlAudioRenderer::submitAudio(int bytesWritten)
         return true;
     }
 
+    // If SDL's queue has run dry since our last submission, the device
+    // must have played silence (or is about to).
+    if (m_Stats != nullptr && m_HasQueuedAudio && SDL_GetQueuedAudioSize(m_AudioDevice) == 0) {
+        m_Stats->underruns++;
+    }
+
     // Provide backpressure on the queue to ensure too many frames don't build up
     // in SDL's audio queue, but don't wait forever to avoid a deadlock if the
     // audio device fails.
+    uint64_t backpressureStartUs = LiGetMicroseconds();
     for (int i = 0; i < 100; i++) {
         // Our device may enter a permanent error status upon removal, so we need
         // to recreate the audio device to pick up the new default audio device.
@@ -123,11 +137,22 @@ bool SdlAudioRenderer::submitAudio(int bytesWritten)
         SDL_Delay(1);
     }
 
+    if (m_Stats != nullptr) {
+        m_Stats->totalBackpressureTimeUs += LiGetMicroseconds() - backpressureStartUs;
+
+        // This sample will play after everything in SDL's queue and the device buffer
+        m_Stats->totalOutputLatencyUs += (uint64_t)SDL_GetQueuedAudioSize(m_AudioDevice) * 1000000 / m_BytesPerSecond + m_DeviceBufferUs;
+        m_Stats->packetsWithOutputLatency++;
+    }
+
     if (SDL_QueueAudio(m_AudioDevice, m_AudioBuffer, bytesWritten) < 0) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
                      "Failed to queue audio sample: %s",
                      SDL_GetError());
     }
+    else {
+        m_HasQueuedAudio = true;
+    }
 
     return true;
 }
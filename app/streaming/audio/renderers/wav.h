@@ -0,0 +1,35 @@
+#pragma once
+
+#include "renderer.h"
+#include "SDL_compat.h"
+
+#include <QFile>
+
+// Audio renderer that writes all samples to a WAV file instead of an
+// audio device. This is useful for checking decoded audio output and
+// A/V sync on machines without audio hardware.
+class WavAudioRenderer : public IAudioRenderer
+{
+public:
+    WavAudioRenderer();
+
+    virtual ~WavAudioRenderer();
+
+    virtual bool prepareForPlayback(const OPUS_MULTISTREAM_CONFIGURATION* opusConfig);
+
+    virtual void* getAudioBuffer(int* size);
+
+    virtual bool submitAudio(int bytesWritten);
+
+    virtual AudioFormat getAudioBufferFormat();
+
+private:
+    bool writeHeader();
+
+    QFile m_File;
+    void* m_AudioBuffer;
+    int m_FrameSize;
+    int m_SampleRate;
+    int m_ChannelCount;
+    quint32 m_DataBytesWritten;
+};
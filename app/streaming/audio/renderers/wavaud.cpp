@@ -0,0 +1,142 @@
+#include "wav.h"
+#include "path.h"
+
+#include <QDir>
+#include <QDateTime>
+#include <QtEndian>
+
+#define WAV_HEADER_SIZE 44
+
+WavAudioRenderer::WavAudioRenderer()
+    : m_AudioBuffer(nullptr),
+      m_FrameSize(0),
+      m_SampleRate(0),
+      m_ChannelCount(0),
+      m_DataBytesWritten(0)
+{
+}
+
+bool WavAudioRenderer::prepareForPlayback(const OPUS_MULTISTREAM_CONFIGURATION* opusConfig)
+{
+    m_SampleRate = opusConfig->sampleRate;
+    m_ChannelCount = opusConfig->channelCount;
+    m_FrameSize = opusConfig->samplesPerFrame *
+                  opusConfig->channelCount *
+                  getAudioBufferSampleSize();
+
+    QString fileName = qgetenv("ML_AUDIO_WAV_FILE");
+    if (fileName.isEmpty()) {
+        fileName = QDir(Path::getLogDir()).filePath(QString("Moonlight-%1.wav").arg(QDateTime::currentSecsSinceEpoch()));
+    }
+
+    m_File.setFileName(fileName);
+    if (!m_File.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Failed to open WAV file %s: %s",
+                     qPrintable(fileName),
+                     qPrintable(m_File.errorString()));
+        return false;
+    }
+
+    // Write a placeholder header now. It will be rewritten with the
+    // final sizes when the renderer is destroyed.
+    if (!writeHeader()) {
+        return false;
+    }
+
+    m_AudioBuffer = SDL_malloc(m_FrameSize);
+    if (m_AudioBuffer == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Failed to allocate audio buffer");
+        return false;
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "Writing audio to WAV file: %s",
+                qPrintable(fileName));
+
+    return true;
+}
+
+WavAudioRenderer::~WavAudioRenderer()
+{
+    if (m_File.isOpen()) {
+        if (m_DataBytesWritten != 0) {
+            // Finalize the header with the actual data size
+            m_File.seek(0);
+            writeHeader();
+            m_File.close();
+        }
+        else {
+            // Don't leave empty files behind from audio tests
+            m_File.remove();
+        }
+    }
+
+    if (m_AudioBuffer != nullptr) {
+        SDL_free(m_AudioBuffer);
+    }
+}
+
+bool WavAudioRenderer::writeHeader()
+{
+    int bytesPerSample = getAudioBufferSampleSize();
+    char header[WAV_HEADER_SIZE];
+
+    SDL_memcpy(&header[0], "RIFF", 4);
+    qToLittleEndian<quint32>(WAV_HEADER_SIZE - 8 + m_DataBytesWritten, &header[4]);
+    SDL_memcpy(&header[8], "WAVE", 4);
+
+    SDL_memcpy(&header[12], "fmt ", 4);
+    qToLittleEndian<quint32>(16, &header[16]);
+    qToLittleEndian<quint16>(1, &header[20]); // WAVE_FORMAT_PCM
+    qToLittleEndian<quint16>(m_ChannelCount, &header[22]);
+    qToLittleEndian<quint32>(m_SampleRate, &header[24]);
+    qToLittleEndian<quint32>(m_SampleRate * m_ChannelCount * bytesPerSample, &header[28]);
+    qToLittleEndian<quint16>(m_ChannelCount * bytesPerSample, &header[32]);
+    qToLittleEndian<quint16>(bytesPerSample * 8, &header[34]);
+
+    SDL_memcpy(&header[36], "data", 4);
+    qToLittleEndian<quint32>(m_DataBytesWritten, &header[40]);
+
+    if (m_File.write(header, sizeof(header)) != sizeof(header)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Failed to write WAV header: %s",
+                     qPrintable(m_File.errorString()));
+        return false;
+    }
+
+    return true;
+}
+
+void* WavAudioRenderer::getAudioBuffer(int*)
+{
+    return m_AudioBuffer;
+}
+
+bool WavAudioRenderer::submitAudio(int bytesWritten)
+{
+    if (bytesWritten == 0) {
+        // Nothing to do
+        return true;
+    }
+
+    // WAV sample data is always little endian
+    qToLittleEndian<qint16>(m_AudioBuffer, bytesWritten / sizeof(qint16), m_AudioBuffer);
+
+    if (m_File.write((const char*)m_AudioBuffer, bytesWritten) != bytesWritten) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Failed to write WAV data: %s",
+                     qPrintable(m_File.errorString()));
+        return false;
+    }
+
+    m_DataBytesWritten += bytesWritten;
+    return true;
+}
+
+IAudioRenderer::AudioFormat WavAudioRenderer::getAudioBufferFormat()
+{
+    // 16-bit PCM is the most widely compatible WAV format
+    return AudioFormat::Sint16NE;
+}
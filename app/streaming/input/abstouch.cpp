@@ -19,11 +19,13 @@
 // How far the finger can move before it can override the double tap deadzone
 #define DOUBLE_TAP_DEAD_ZONE_DELTA 0.025f
 
-Uint32 SdlInputHandler::longPressTimerCallback(Uint32, void*)
+Uint32 SdlInputHandler::longPressTimerCallback(Uint32, void* param)
 {
+    auto me = reinterpret_cast<SdlInputHandler*>(param);
+
     // Raise the left click and start a right click
-    LiSendMouseButtonEvent(BUTTON_ACTION_RELEASE, BUTTON_LEFT);
-    LiSendMouseButtonEvent(BUTTON_ACTION_PRESS, BUTTON_RIGHT);
+    me->m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_RELEASE, BUTTON_LEFT);
+    me->m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_PRESS, BUTTON_RIGHT);
 
     return 0;
 }
@@ -127,14 +129,16 @@ void SdlInputHandler::handleAbsoluteFingerEvent(SDL_TouchFingerEvent* event)
         }
 
         if (isPen) {
-            LiSendPenEvent(eventType, LI_TOOL_TYPE_PEN, 0, vidrelx / dst.w, vidrely / dst.h, event->pressure,
-                           0.0f, 0.0f, LI_ROT_UNKNOWN, LI_TILT_UNKNOWN);
+            m_Dispatcher.sendPenEvent(eventType, LI_TOOL_TYPE_PEN, 0, vidrelx / dst.w, vidrely / dst.h, event->pressure,
+                                      0.0f, 0.0f, LI_ROT_UNKNOWN, LI_TILT_UNKNOWN,
+                                      InputEventOrigin(InputDevicePen, event->timestamp));
         }
         else
 #endif
         {
-            LiSendTouchEvent(eventType, pointerId, vidrelx / dst.w, vidrely / dst.h, event->pressure,
-                             0.0f, 0.0f, LI_ROT_UNKNOWN);
+            m_Dispatcher.sendTouchEvent(eventType, pointerId, vidrelx / dst.w, vidrely / dst.h, event->pressure,
+                                        0.0f, 0.0f, LI_ROT_UNKNOWN,
+                                        InputEventOrigin(InputDeviceTouch, event->timestamp));
         }
 
         if (!m_DisabledTouchFeedback) {
@@ -166,6 +170,8 @@ void SdlInputHandler::emulateAbsoluteFingerEvent(SDL_TouchFingerEvent* event)
         return;
     }
 
+    InputEventOrigin origin(InputDeviceTouch, event->timestamp);
+
     SDL_Rect src, dst;
     int windowWidth, windowHeight;
 
@@ -197,7 +203,7 @@ void SdlInputHandler::emulateAbsoluteFingerEvent(SDL_TouchFingerEvent* event)
         short y = qMin(qMax((int)(event->y * windowHeight), dst.y), dst.y + dst.h);
 
         // Update the cursor position relative to the video region
-        LiSendMousePositionEvent(x - dst.x, y - dst.y, dst.w, dst.h);
+        m_Dispatcher.sendMousePositionEvent(x - dst.x, y - dst.y, dst.w, dst.h, origin);
     }
 
     if (event->type == SDL_FINGERDOWN) {
@@ -207,10 +213,10 @@ void SdlInputHandler::emulateAbsoluteFingerEvent(SDL_TouchFingerEvent* event)
         SDL_RemoveTimer(m_LongPressTimer);
         m_LongPressTimer = SDL_AddTimer(LONG_PRESS_ACTIVATION_DELAY,
                                         longPressTimerCallback,
-                                        nullptr);
+                                        this);
 
         // Left button down on finger down
-        LiSendMouseButtonEvent(BUTTON_ACTION_PRESS, BUTTON_LEFT);
+        m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_PRESS, BUTTON_LEFT, origin);
     }
     else if (event->type == SDL_FINGERUP) {
         m_LastTouchUpEvent = *event;
@@ -220,9 +226,9 @@ void SdlInputHandler::emulateAbsoluteFingerEvent(SDL_TouchFingerEvent* event)
         m_LongPressTimer = 0;
 
         // Left button up on finger up
-        LiSendMouseButtonEvent(BUTTON_ACTION_RELEASE, BUTTON_LEFT);
+        m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_RELEASE, BUTTON_LEFT, origin);
 
         // Raise right button too in case we triggered a long press gesture
-        LiSendMouseButtonEvent(BUTTON_ACTION_RELEASE, BUTTON_RIGHT);
+        m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_RELEASE, BUTTON_RIGHT, origin);
     }
 }
@@ -0,0 +1,761 @@
+#include "dispatcher.h"
+#include "utils.h"
+
+#define QUEUE_MASK (INPUT_DISPATCH_QUEUE_SIZE - 1)
+
+InputDispatcher::InputDispatcher()
+    : m_DequeuePos(0),
+      m_LatencyStats(nullptr),
+      m_EventCounts(nullptr),
+      m_Thread(nullptr),
+      m_EventSemaphore(nullptr),
+      m_LoggedQueueFull(false),
+      m_AxisDeadband(0),
+      m_BatchWindowMs(0),
+      m_SentEvents(0),
+      m_CoalescedEvents(0),
+      m_TotalQueueTimeUs(0),
+      m_MaxQueueTimeUs(0),
+      m_BatchDeadlineUs(0),
+      m_SuppressedControllerEvents(0),
+      m_BatchedControllerEvents(0)
+{
+    SDL_AtomicSet(&m_EnqueuePos, 0);
+    SDL_AtomicSet(&m_Stopping, 0);
+
+    for (int i = 0; i < INPUT_DISPATCH_QUEUE_SIZE; i++) {
+        SDL_AtomicSet(&m_Queue[i].sequence, i);
+    }
+
+    for (int i = 0; i < INPUT_DISPATCH_MAX_CONTROLLERS; i++) {
+        m_ControllerBatches[i].hasSentState = false;
+        m_ControllerBatches[i].hasPendingEvent = false;
+    }
+}
+
+InputDispatcher::~InputDispatcher()
+{
+    stop();
+
+    if (m_EventSemaphore != nullptr) {
+        SDL_DestroySemaphore(m_EventSemaphore);
+    }
+}
+
+bool InputDispatcher::start(InputLatencyStats* latencyStats)
+{
+    SDL_assert(m_Thread == nullptr);
+
+    m_LatencyStats = latencyStats;
+
+    // Stick movement smaller than this (in axis units) isn't sent to the host
+    if (Utils::getEnvironmentVariableOverride("GAMEPAD_AXIS_DEADBAND", &m_AxisDeadband)) {
+        m_AxisDeadband = SDL_max(m_AxisDeadband, 0);
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "Using gamepad axis deadband: %d",
+                    m_AxisDeadband);
+    }
+
+    // Holding stick updates for up to a frame lets us send the state of all
+    // controllers together, at the cost of that much added latency.
+    if (Utils::getEnvironmentVariableOverride("GAMEPAD_BATCH_WINDOW_MS", &m_BatchWindowMs)) {
+        m_BatchWindowMs = SDL_max(m_BatchWindowMs, 0);
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "Using gamepad batching window: %d ms",
+                    m_BatchWindowMs);
+    }
+
+    m_EventSemaphore = SDL_CreateSemaphore(0);
+    if (m_EventSemaphore == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "SDL_CreateSemaphore() failed: %s",
+                     SDL_GetError());
+        return false;
+    }
+
+    m_Thread = SDL_CreateThread(InputDispatcher::dispatcherThread, "InputDispatch", this);
+    if (m_Thread == nullptr) {
+        // Events will be sent synchronously by the caller
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Failed to create input dispatch thread: %s",
+                     SDL_GetError());
+        return false;
+    }
+
+    return true;
+}
+
+void InputDispatcher::stop()
+{
+    if (m_Thread == nullptr) {
+        return;
+    }
+
+    SDL_AtomicSet(&m_Stopping, 1);
+    SDL_SemPost(m_EventSemaphore);
+    SDL_WaitThread(m_Thread, nullptr);
+    m_Thread = nullptr;
+
+    if (m_SentEvents != 0) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "Input dispatch: %u events sent (%u coalesced), average queueing time %.1f us, max %.1f us",
+                    m_SentEvents,
+                    m_CoalescedEvents,
+                    (double)m_TotalQueueTimeUs / m_SentEvents,
+                    (double)m_MaxQueueTimeUs);
+    }
+
+    if (m_SuppressedControllerEvents != 0 || m_BatchedControllerEvents != 0) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "Input dispatch: %u gamepad updates suppressed, %u batched",
+                    m_SuppressedControllerEvents,
+                    m_BatchedControllerEvents);
+    }
+}
+
+void InputDispatcher::setCountingSink(uint32_t* eventCounts)
+{
+    m_EventCounts = eventCounts;
+}
+
+const char* InputDispatcher::getEventTypeName(int type)
+{
+    switch (type) {
+    case EventMouseMove:
+        return "MouseMove";
+    case EventMousePosition:
+        return "MousePosition";
+    case EventMouseButton:
+        return "MouseButton";
+    case EventScroll:
+        return "Scroll";
+    case EventHScroll:
+        return "HScroll";
+    case EventHighResScroll:
+        return "HighResScroll";
+    case EventHighResHScroll:
+        return "HighResHScroll";
+    case EventKeyboard:
+        return "Keyboard";
+    case EventUtf8Text:
+        return "Utf8Text";
+    case EventTouch:
+        return "Touch";
+    case EventPen:
+        return "Pen";
+    case EventMultiController:
+        return "MultiController";
+    case EventControllerArrival:
+        return "ControllerArrival";
+    case EventControllerTouch:
+        return "ControllerTouch";
+    case EventControllerMotion:
+        return "ControllerMotion";
+    case EventControllerBattery:
+        return "ControllerBattery";
+    default:
+        return "Unknown";
+    }
+}
+
+bool InputDispatcher::tryEnqueue(PINPUT_EVENT event)
+{
+    QUEUE_CELL* cell;
+    int pos = SDL_AtomicGet(&m_EnqueuePos);
+
+    // Multiple producers (the main thread and SDL timer callbacks) claim cells by
+    // advancing the enqueue position. Each cell's sequence number tells us whether
+    // the consumer has finished with it from the previous trip around the ring.
+    for (;;) {
+        cell = &m_Queue[pos & QUEUE_MASK];
+
+        int diff = (int)((unsigned int)SDL_AtomicGet(&cell->sequence) - (unsigned int)pos);
+        if (diff == 0) {
+            if (SDL_AtomicCAS(&m_EnqueuePos, pos, (int)((unsigned int)pos + 1))) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            // The queue is full
+            return false;
+        }
+
+        // Another producer claimed this cell first
+        pos = SDL_AtomicGet(&m_EnqueuePos);
+    }
+
+    cell->event = *event;
+
+    // Publish the event to the consumer
+    SDL_AtomicSet(&cell->sequence, (int)((unsigned int)pos + 1));
+    return true;
+}
+
+bool InputDispatcher::tryDequeue(PINPUT_EVENT event)
+{
+    QUEUE_CELL* cell = &m_Queue[m_DequeuePos & QUEUE_MASK];
+
+    int diff = (int)((unsigned int)SDL_AtomicGet(&cell->sequence) - ((unsigned int)m_DequeuePos + 1));
+    if (diff < 0) {
+        // The queue is empty or the next event is still being written
+        return false;
+    }
+
+    *event = cell->event;
+
+    // Hand the cell back to the producers for the next trip around the ring
+    SDL_AtomicSet(&cell->sequence, (int)((unsigned int)m_DequeuePos + INPUT_DISPATCH_QUEUE_SIZE));
+    m_DequeuePos = (int)((unsigned int)m_DequeuePos + 1);
+    return true;
+}
+
+bool InputDispatcher::tryCoalesceEvent(PINPUT_EVENT pending, const INPUT_EVENT* event)
+{
+    if (pending->type != EventMouseMove || event->type != EventMouseMove) {
+        return false;
+    }
+
+    int deltaX = pending->mouseMove.deltaX + event->mouseMove.deltaX;
+    int deltaY = pending->mouseMove.deltaY + event->mouseMove.deltaY;
+    if (deltaX != (short)deltaX || deltaY != (short)deltaY) {
+        return false;
+    }
+
+    pending->mouseMove.deltaX = (short)deltaX;
+    pending->mouseMove.deltaY = (short)deltaY;
+
+    // Latency is measured from the oldest user input in the combined event
+    if (pending->origin.deviceClass == InputDeviceNone) {
+        pending->origin = event->origin;
+    }
+
+    return true;
+}
+
+void InputDispatcher::queueEvent(PINPUT_EVENT event)
+{
+    if (m_Thread == nullptr) {
+        // No dispatcher thread, so just send it now
+        dispatchEvent(event);
+        return;
+    }
+
+    event->enqueueTimeUs = LiGetMicroseconds();
+
+    // We never drop input events because losing a button or key release would leave
+    // it stuck down on the host. If the dispatcher thread falls this far behind,
+    // wait for it to catch up.
+    while (!tryEnqueue(event)) {
+        if (!m_LoggedQueueFull) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                        "Input dispatch queue is full!");
+            m_LoggedQueueFull = true;
+        }
+
+        SDL_Delay(1);
+    }
+
+    SDL_SemPost(m_EventSemaphore);
+}
+
+void InputDispatcher::dispatchEvent(PINPUT_EVENT event)
+{
+    if (m_LatencyStats != nullptr && event->origin.deviceClass != InputDeviceNone) {
+        m_LatencyStats->addSample(event->origin.deviceClass,
+                                  LiGetMicroseconds() - event->origin.inputTimeUs);
+    }
+
+    if (m_EventCounts != nullptr) {
+        m_EventCounts[event->type]++;
+        if (event->type == EventUtf8Text) {
+            SDL_free(event->utf8Text.text);
+        }
+        return;
+    }
+
+    switch (event->type) {
+    case EventMouseMove:
+        LiSendMouseMoveEvent(event->mouseMove.deltaX, event->mouseMove.deltaY);
+        break;
+    case EventMousePosition:
+        LiSendMousePositionEvent(event->mousePosition.x, event->mousePosition.y,
+                                 event->mousePosition.referenceWidth, event->mousePosition.referenceHeight);
+        break;
+    case EventMouseButton:
+        LiSendMouseButtonEvent(event->mouseButton.action, event->mouseButton.button);
+        break;
+    case EventScroll:
+        LiSendScrollEvent((signed char)event->scroll.amount);
+        break;
+    case EventHScroll:
+        LiSendHScrollEvent((signed char)event->scroll.amount);
+        break;
+    case EventHighResScroll:
+        LiSendHighResScrollEvent(event->scroll.amount);
+        break;
+    case EventHighResHScroll:
+        LiSendHighResHScrollEvent(event->scroll.amount);
+        break;
+    case EventKeyboard:
+        LiSendKeyboardEvent2(event->keyboard.keyCode, event->keyboard.keyAction,
+                             event->keyboard.modifiers, event->keyboard.flags);
+        break;
+    case EventUtf8Text:
+        LiSendUtf8TextEvent(event->utf8Text.text, event->utf8Text.length);
+        SDL_free(event->utf8Text.text);
+        break;
+    case EventTouch:
+        LiSendTouchEvent(event->touch.eventType, event->touch.pointerId,
+                         event->touch.x, event->touch.y, event->touch.pressureOrDistance,
+                         event->touch.contactAreaMajor, event->touch.contactAreaMinor,
+                         event->touch.rotation);
+        break;
+    case EventPen:
+        LiSendPenEvent(event->touch.eventType, event->touch.toolType, event->touch.penButtons,
+                       event->touch.x, event->touch.y, event->touch.pressureOrDistance,
+                       event->touch.contactAreaMajor, event->touch.contactAreaMinor,
+                       event->touch.rotation, event->touch.tilt);
+        break;
+    case EventMultiController:
+        LiSendMultiControllerEvent(event->controller.controllerNumber, event->controller.activeGamepadMask,
+                                   event->controller.buttonFlags,
+                                   event->controller.leftTrigger, event->controller.rightTrigger,
+                                   event->controller.leftStickX, event->controller.leftStickY,
+                                   event->controller.rightStickX, event->controller.rightStickY);
+        break;
+    case EventControllerArrival:
+        LiSendControllerArrivalEvent(event->controllerArrival.controllerNumber,
+                                     event->controllerArrival.activeGamepadMask,
+                                     event->controllerArrival.type,
+                                     event->controllerArrival.supportedButtonFlags,
+                                     event->controllerArrival.capabilities);
+        break;
+    case EventControllerTouch:
+        LiSendControllerTouchEvent(event->controllerTouch.controllerNumber, event->controllerTouch.eventType,
+                                   event->controllerTouch.pointerId,
+                                   event->controllerTouch.x, event->controllerTouch.y,
+                                   event->controllerTouch.pressure);
+        break;
+    case EventControllerMotion:
+        LiSendControllerMotionEvent(event->controllerMotion.controllerNumber, event->controllerMotion.motionType,
+                                    event->controllerMotion.x, event->controllerMotion.y, event->controllerMotion.z);
+        break;
+    case EventControllerBattery:
+        LiSendControllerBatteryEvent(event->controllerBattery.controllerNumber,
+                                     event->controllerBattery.batteryState,
+                                     event->controllerBattery.batteryPercentage);
+        break;
+    }
+}
+
+bool InputDispatcher::isControllerStateChanged(const CONTROLLER_STATE* sentState, const CONTROLLER_STATE* state, int axisDeadband)
+{
+    if (sentState->activeGamepadMask != state->activeGamepadMask ||
+            sentState->buttonFlags != state->buttonFlags ||
+            sentState->leftTrigger != state->leftTrigger ||
+            sentState->rightTrigger != state->rightTrigger) {
+        return true;
+    }
+
+    const short sentAxes[] = { sentState->leftStickX, sentState->leftStickY, sentState->rightStickX, sentState->rightStickY };
+    const short axes[] = { state->leftStickX, state->leftStickY, state->rightStickX, state->rightStickY };
+    for (int i = 0; i < (int)SDL_arraysize(axes); i++) {
+        if (axes[i] == sentAxes[i]) {
+            continue;
+        }
+
+        if (SDL_abs(axes[i] - sentAxes[i]) > axisDeadband) {
+            return true;
+        }
+
+        // A stick returning to center or reaching the edge is always sent,
+        // otherwise it could be left slightly off on the host.
+        if (axes[i] == 0 || axes[i] == SDL_JOYSTICK_AXIS_MIN || axes[i] == SDL_JOYSTICK_AXIS_MAX) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void InputDispatcher::sendControllerEvent(PINPUT_EVENT event)
+{
+    CONTROLLER_BATCH* batch = &m_ControllerBatches[event->controller.controllerNumber];
+
+    if (batch->hasSentState && !isControllerStateChanged(&batch->sentState, &event->controller, m_AxisDeadband)) {
+        m_SuppressedControllerEvents++;
+        return;
+    }
+
+    batch->sentState = event->controller;
+    batch->hasSentState = true;
+    dispatchEvent(event);
+}
+
+void InputDispatcher::batchControllerEvent(PINPUT_EVENT event)
+{
+    if (event->controller.controllerNumber < 0 || event->controller.controllerNumber >= INPUT_DISPATCH_MAX_CONTROLLERS) {
+        dispatchEvent(event);
+        return;
+    }
+
+    CONTROLLER_BATCH* batch = &m_ControllerBatches[event->controller.controllerNumber];
+
+    if (batch->hasPendingEvent) {
+        // Only stick and trigger movement is combined. Button changes must
+        // all reach the host, so the pending state goes out first.
+        if (batch->pendingEvent.controller.activeGamepadMask == event->controller.activeGamepadMask &&
+                batch->pendingEvent.controller.buttonFlags == event->controller.buttonFlags) {
+            InputEventOrigin origin = batch->pendingEvent.origin;
+
+            batch->pendingEvent = *event;
+            m_BatchedControllerEvents++;
+
+            // Latency is measured from the oldest user input in the batch
+            if (origin.deviceClass != InputDeviceNone) {
+                batch->pendingEvent.origin = origin;
+            }
+            return;
+        }
+
+        batch->hasPendingEvent = false;
+        sendControllerEvent(&batch->pendingEvent);
+    }
+
+    if (m_BatchWindowMs == 0) {
+        sendControllerEvent(event);
+        return;
+    }
+
+    batch->pendingEvent = *event;
+    batch->hasPendingEvent = true;
+
+    // The window starts with the first update after the last flush
+    if (m_BatchDeadlineUs == 0) {
+        m_BatchDeadlineUs = LiGetMicroseconds() + (uint64_t)m_BatchWindowMs * 1000;
+    }
+}
+
+void InputDispatcher::flushControllerEvents()
+{
+    for (int i = 0; i < INPUT_DISPATCH_MAX_CONTROLLERS; i++) {
+        CONTROLLER_BATCH* batch = &m_ControllerBatches[i];
+
+        if (batch->hasPendingEvent) {
+            batch->hasPendingEvent = false;
+            sendControllerEvent(&batch->pendingEvent);
+        }
+    }
+
+    m_BatchDeadlineUs = 0;
+}
+
+int InputDispatcher::dispatcherThread(void* context)
+{
+    InputDispatcher* me = reinterpret_cast<InputDispatcher*>(context);
+    INPUT_EVENT event;
+    INPUT_EVENT pendingEvent;
+    bool hasPendingEvent = false;
+
+    if (SDL_SetThreadPriority(SDL_THREAD_PRIORITY_HIGH) < 0) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                    "Unable to set input dispatch thread to high priority: %s",
+                    SDL_GetError());
+    }
+
+    for (;;) {
+        bool stopping = SDL_AtomicGet(&me->m_Stopping) != 0;
+
+        while (me->tryDequeue(&event)) {
+            uint64_t queueTimeUs = LiGetMicroseconds() - event.enqueueTimeUs;
+            me->m_TotalQueueTimeUs += queueTimeUs;
+            me->m_MaxQueueTimeUs = SDL_max(me->m_MaxQueueTimeUs, queueTimeUs);
+            me->m_SentEvents++;
+
+            // Hold on to each event until we see the next one, so we can
+            // combine them if they are both relative mouse motion.
+            if (hasPendingEvent) {
+                if (tryCoalesceEvent(&pendingEvent, &event)) {
+                    me->m_CoalescedEvents++;
+                    continue;
+                }
+
+                me->dispatchEvent(&pendingEvent);
+                hasPendingEvent = false;
+            }
+
+            switch (event.type) {
+            case EventMultiController:
+                me->batchControllerEvent(&event);
+                continue;
+            case EventControllerArrival:
+                // The host starts the new controller from scratch
+                me->flushControllerEvents();
+                if (event.controllerArrival.controllerNumber < INPUT_DISPATCH_MAX_CONTROLLERS) {
+                    me->m_ControllerBatches[event.controllerArrival.controllerNumber].hasSentState = false;
+                }
+                break;
+            case EventControllerTouch:
+            case EventControllerMotion:
+            case EventControllerBattery:
+                // Keep these in order with the gamepad state
+                me->flushControllerEvents();
+                break;
+            default:
+                break;
+            }
+
+            pendingEvent = event;
+            hasPendingEvent = true;
+        }
+
+        // Don't wait for another event before sending this one
+        if (hasPendingEvent) {
+            me->dispatchEvent(&pendingEvent);
+            hasPendingEvent = false;
+        }
+
+        if (me->m_BatchDeadlineUs != 0 && (stopping || LiGetMicroseconds() >= me->m_BatchDeadlineUs)) {
+            me->flushControllerEvents();
+        }
+
+        // Events queued before stop() was called have all been sent now
+        if (stopping) {
+            break;
+        }
+
+        if (me->m_BatchDeadlineUs != 0) {
+            // Wake up in time to send the batched gamepad state
+            uint64_t nowUs = LiGetMicroseconds();
+            uint32_t timeoutMs = me->m_BatchDeadlineUs > nowUs ?
+                                     (uint32_t)((me->m_BatchDeadlineUs - nowUs + 999) / 1000) : 0;
+            SDL_SemWaitTimeout(me->m_EventSemaphore, timeoutMs);
+        }
+        else {
+            SDL_SemWait(me->m_EventSemaphore);
+        }
+    }
+
+    return 0;
+}
+
+void InputDispatcher::sendMouseMoveEvent(short deltaX, short deltaY,
+                                         const InputEventOrigin& origin)
+{
+    INPUT_EVENT event;
+    event.type = EventMouseMove;
+    event.mouseMove.deltaX = deltaX;
+    event.mouseMove.deltaY = deltaY;
+    event.origin = origin;
+    queueEvent(&event);
+}
+
+void InputDispatcher::sendMousePositionEvent(short x, short y, short referenceWidth, short referenceHeight,
+                                             const InputEventOrigin& origin)
+{
+    INPUT_EVENT event;
+    event.type = EventMousePosition;
+    event.mousePosition.x = x;
+    event.mousePosition.y = y;
+    event.mousePosition.referenceWidth = referenceWidth;
+    event.mousePosition.referenceHeight = referenceHeight;
+    event.origin = origin;
+    queueEvent(&event);
+}
+
+void InputDispatcher::sendMouseButtonEvent(char action, int button,
+                                           const InputEventOrigin& origin)
+{
+    INPUT_EVENT event;
+    event.type = EventMouseButton;
+    event.mouseButton.action = action;
+    event.mouseButton.button = button;
+    event.origin = origin;
+    queueEvent(&event);
+}
+
+void InputDispatcher::sendScrollEvent(signed char scrollClicks,
+                                      const InputEventOrigin& origin)
+{
+    INPUT_EVENT event;
+    event.type = EventScroll;
+    event.scroll.amount = scrollClicks;
+    event.origin = origin;
+    queueEvent(&event);
+}
+
+void InputDispatcher::sendHScrollEvent(signed char scrollClicks,
+                                       const InputEventOrigin& origin)
+{
+    INPUT_EVENT event;
+    event.type = EventHScroll;
+    event.scroll.amount = scrollClicks;
+    event.origin = origin;
+    queueEvent(&event);
+}
+
+void InputDispatcher::sendHighResScrollEvent(short scrollAmount,
+                                             const InputEventOrigin& origin)
+{
+    INPUT_EVENT event;
+    event.type = EventHighResScroll;
+    event.scroll.amount = scrollAmount;
+    event.origin = origin;
+    queueEvent(&event);
+}
+
+void InputDispatcher::sendHighResHScrollEvent(short scrollAmount,
+                                              const InputEventOrigin& origin)
+{
+    INPUT_EVENT event;
+    event.type = EventHighResHScroll;
+    event.scroll.amount = scrollAmount;
+    event.origin = origin;
+    queueEvent(&event);
+}
+
+void InputDispatcher::sendKeyboardEvent(short keyCode, char keyAction, char modifiers, char flags,
+                                        const InputEventOrigin& origin)
+{
+    INPUT_EVENT event;
+    event.type = EventKeyboard;
+    event.keyboard.keyCode = keyCode;
+    event.keyboard.keyAction = keyAction;
+    event.keyboard.modifiers = modifiers;
+    event.keyboard.flags = flags;
+    event.origin = origin;
+    queueEvent(&event);
+}
+
+void InputDispatcher::sendUtf8TextEvent(const char* text, unsigned int length,
+                                        const InputEventOrigin& origin)
+{
+    INPUT_EVENT event;
+    event.type = EventUtf8Text;
+    event.utf8Text.text = (char*)SDL_malloc(length);
+    if (event.utf8Text.text == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Failed to allocate text event");
+        return;
+    }
+    SDL_memcpy(event.utf8Text.text, text, length);
+    event.utf8Text.length = length;
+    event.origin = origin;
+    queueEvent(&event);
+}
+
+void InputDispatcher::sendTouchEvent(uint8_t eventType, uint32_t pointerId, float x, float y, float pressureOrDistance,
+                                     float contactAreaMajor, float contactAreaMinor, uint16_t rotation,
+                                     const InputEventOrigin& origin)
+{
+    INPUT_EVENT event;
+    event.type = EventTouch;
+    event.touch.eventType = eventType;
+    event.touch.pointerId = pointerId;
+    event.touch.x = x;
+    event.touch.y = y;
+    event.touch.pressureOrDistance = pressureOrDistance;
+    event.touch.contactAreaMajor = contactAreaMajor;
+    event.touch.contactAreaMinor = contactAreaMinor;
+    event.touch.rotation = rotation;
+    event.origin = origin;
+    queueEvent(&event);
+}
+
+void InputDispatcher::sendPenEvent(uint8_t eventType, uint8_t toolType, uint8_t penButtons, float x, float y,
+                                   float pressureOrDistance, float contactAreaMajor, float contactAreaMinor,
+                                   uint16_t rotation, uint8_t tilt,
+                                   const InputEventOrigin& origin)
+{
+    INPUT_EVENT event;
+    event.type = EventPen;
+    event.touch.eventType = eventType;
+    event.touch.toolType = toolType;
+    event.touch.penButtons = penButtons;
+    event.touch.x = x;
+    event.touch.y = y;
+    event.touch.pressureOrDistance = pressureOrDistance;
+    event.touch.contactAreaMajor = contactAreaMajor;
+    event.touch.contactAreaMinor = contactAreaMinor;
+    event.touch.rotation = rotation;
+    event.touch.tilt = tilt;
+    event.origin = origin;
+    queueEvent(&event);
+}
+
+void InputDispatcher::sendMultiControllerEvent(short controllerNumber, short activeGamepadMask, int buttonFlags,
+                                               unsigned char leftTrigger, unsigned char rightTrigger,
+                                               short leftStickX, short leftStickY, short rightStickX, short rightStickY,
+                                               const InputEventOrigin& origin)
+{
+    INPUT_EVENT event;
+    event.type = EventMultiController;
+    event.controller.controllerNumber = controllerNumber;
+    event.controller.activeGamepadMask = activeGamepadMask;
+    event.controller.buttonFlags = buttonFlags;
+    event.controller.leftTrigger = leftTrigger;
+    event.controller.rightTrigger = rightTrigger;
+    event.controller.leftStickX = leftStickX;
+    event.controller.leftStickY = leftStickY;
+    event.controller.rightStickX = rightStickX;
+    event.controller.rightStickY = rightStickY;
+    event.origin = origin;
+    queueEvent(&event);
+}
+
+void InputDispatcher::sendControllerArrivalEvent(uint8_t controllerNumber, uint16_t activeGamepadMask, uint8_t type,
+                                                 uint32_t supportedButtonFlags, uint16_t capabilities,
+                                                 const InputEventOrigin& origin)
+{
+    INPUT_EVENT event;
+    event.type = EventControllerArrival;
+    event.controllerArrival.controllerNumber = controllerNumber;
+    event.controllerArrival.activeGamepadMask = activeGamepadMask;
+    event.controllerArrival.type = type;
+    event.controllerArrival.supportedButtonFlags = supportedButtonFlags;
+    event.controllerArrival.capabilities = capabilities;
+    event.origin = origin;
+    queueEvent(&event);
+}
+
+void InputDispatcher::sendControllerTouchEvent(uint8_t controllerNumber, uint8_t eventType, uint32_t pointerId,
+                                               float x, float y, float pressure,
+                                               const InputEventOrigin& origin)
+{
+    INPUT_EVENT event;
+    event.type = EventControllerTouch;
+    event.controllerTouch.controllerNumber = controllerNumber;
+    event.controllerTouch.eventType = eventType;
+    event.controllerTouch.pointerId = pointerId;
+    event.controllerTouch.x = x;
+    event.controllerTouch.y = y;
+    event.controllerTouch.pressure = pressure;
+    event.origin = origin;
+    queueEvent(&event);
+}
+
+void InputDispatcher::sendControllerMotionEvent(uint8_t controllerNumber, uint8_t motionType, float x, float y, float z,
+                                                const InputEventOrigin& origin)
+{
+    INPUT_EVENT event;
+    event.type = EventControllerMotion;
+    event.controllerMotion.controllerNumber = controllerNumber;
+    event.controllerMotion.motionType = motionType;
+    event.controllerMotion.x = x;
+    event.controllerMotion.y = y;
+    event.controllerMotion.z = z;
+    event.origin = origin;
+    queueEvent(&event);
+}
+
+void InputDispatcher::sendControllerBatteryEvent(uint8_t controllerNumber, uint8_t batteryState, uint8_t batteryPercentage,
+                                                 const InputEventOrigin& origin)
+{
+    INPUT_EVENT event;
+    event.type = EventControllerBattery;
+    event.controllerBattery.controllerNumber = controllerNumber;
+    event.controllerBattery.batteryState = batteryState;
+    event.controllerBattery.batteryPercentage = batteryPercentage;
+    event.origin = origin;
+    queueEvent(&event);
+}
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <Limelight.h>
+#include "SDL_compat.h"
+#include "latencystats.h"
+
+// Must be a power of 2
+#define INPUT_DISPATCH_QUEUE_SIZE 1024
+
+// Controller numbers supported by the host
+#define INPUT_DISPATCH_MAX_CONTROLLERS 16
+
+// Sends translated input events to the host from a dedicated high priority
+// thread, so input isn't delayed by rendering or other work on the main thread.
+// Events can be queued from any thread without taking a lock and are always
+// sent in the order they were queued. Relative mouse motion that queues up
+// back to back (from the mouse and gamepad mouse emulation, for example) is
+// combined into a single event.
+//
+// Gamepad state is only sent when it differs from the last state sent for that
+// controller. Stick movement within the configured deadband is suppressed, and
+// an optional batching window holds stick updates so that the latest state of
+// every controller is sent together.
+class InputDispatcher
+{
+public:
+    enum EventType {
+        EventMouseMove,
+        EventMousePosition,
+        EventMouseButton,
+        EventScroll,
+        EventHScroll,
+        EventHighResScroll,
+        EventHighResHScroll,
+        EventKeyboard,
+        EventUtf8Text,
+        EventTouch,
+        EventPen,
+        EventMultiController,
+        EventControllerArrival,
+        EventControllerTouch,
+        EventControllerMotion,
+        EventControllerBattery,
+        EventTypeMax
+    };
+
+    InputDispatcher();
+
+    ~InputDispatcher();
+
+    bool start(InputLatencyStats* latencyStats);
+
+    // Sends any events still in the queue before returning
+    void stop();
+
+    // Counts events by type instead of sending them to the host. This is
+    // used to replay recorded input without a connection. The array must
+    // have EventTypeMax elements and must not be read until stop() returns.
+    void setCountingSink(uint32_t* eventCounts);
+
+    static
+    const char* getEventTypeName(int type);
+
+    void sendMouseMoveEvent(short deltaX, short deltaY,
+                            const InputEventOrigin& origin = InputEventOrigin());
+
+    void sendMousePositionEvent(short x, short y, short referenceWidth, short referenceHeight,
+                                const InputEventOrigin& origin = InputEventOrigin());
+
+    void sendMouseButtonEvent(char action, int button,
+                              const InputEventOrigin& origin = InputEventOrigin());
+
+    void sendScrollEvent(signed char scrollClicks,
+                         const InputEventOrigin& origin = InputEventOrigin());
+
+    void sendHScrollEvent(signed char scrollClicks,
+                          const InputEventOrigin& origin = InputEventOrigin());
+
+    void sendHighResScrollEvent(short scrollAmount,
+                                const InputEventOrigin& origin = InputEventOrigin());
+
+    void sendHighResHScrollEvent(short scrollAmount,
+                                 const InputEventOrigin& origin = InputEventOrigin());
+
+    void sendKeyboardEvent(short keyCode, char keyAction, char modifiers, char flags = 0,
+                           const InputEventOrigin& origin = InputEventOrigin());
+
+    void sendUtf8TextEvent(const char* text, unsigned int length,
+                           const InputEventOrigin& origin = InputEventOrigin());
+
+    void sendTouchEvent(uint8_t eventType, uint32_t pointerId, float x, float y, float pressureOrDistance,
+                        float contactAreaMajor, float contactAreaMinor, uint16_t rotation,
+                        const InputEventOrigin& origin = InputEventOrigin());
+
+    void sendPenEvent(uint8_t eventType, uint8_t toolType, uint8_t penButtons, float x, float y,
+                      float pressureOrDistance, float contactAreaMajor, float contactAreaMinor,
+                      uint16_t rotation, uint8_t tilt,
+                      const InputEventOrigin& origin = InputEventOrigin());
+
+    void sendMultiControllerEvent(short controllerNumber, short activeGamepadMask, int buttonFlags,
+                                  unsigned char leftTrigger, unsigned char rightTrigger,
+                                  short leftStickX, short leftStickY, short rightStickX, short rightStickY,
+                                  const InputEventOrigin& origin = InputEventOrigin());
+
+    void sendControllerArrivalEvent(uint8_t controllerNumber, uint16_t activeGamepadMask, uint8_t type,
+                                    uint32_t supportedButtonFlags, uint16_t capabilities,
+                                    const InputEventOrigin& origin = InputEventOrigin());
+
+    void sendControllerTouchEvent(uint8_t controllerNumber, uint8_t eventType, uint32_t pointerId,
+                                  float x, float y, float pressure,
+                                  const InputEventOrigin& origin = InputEventOrigin());
+
+    void sendControllerMotionEvent(uint8_t controllerNumber, uint8_t motionType, float x, float y, float z,
+                                   const InputEventOrigin& origin = InputEventOrigin());
+
+    void sendControllerBatteryEvent(uint8_t controllerNumber, uint8_t batteryState, uint8_t batteryPercentage,
+                                    const InputEventOrigin& origin = InputEventOrigin());
+
+private:
+    typedef struct _CONTROLLER_STATE {
+        short controllerNumber;
+        short activeGamepadMask;
+        int buttonFlags;
+        unsigned char leftTrigger, rightTrigger;
+        short leftStickX, leftStickY;
+        short rightStickX, rightStickY;
+    } CONTROLLER_STATE;
+
+    typedef struct _INPUT_EVENT {
+        EventType type;
+        InputEventOrigin origin;
+        uint64_t enqueueTimeUs;
+        union {
+            struct {
+                short deltaX, deltaY;
+            } mouseMove;
+            struct {
+                short x, y;
+                short referenceWidth, referenceHeight;
+            } mousePosition;
+            struct {
+                char action;
+                int button;
+            } mouseButton;
+            struct {
+                short amount;
+            } scroll;
+            struct {
+                short keyCode;
+                char keyAction;
+                char modifiers;
+                char flags;
+            } keyboard;
+            struct {
+                // Owned by the event and freed after sending
+                char* text;
+                unsigned int length;
+            } utf8Text;
+            struct {
+                uint8_t eventType;
+                uint8_t toolType;
+                uint8_t penButtons;
+                uint8_t tilt;
+                uint32_t pointerId;
+                float x, y;
+                float pressureOrDistance;
+                float contactAreaMajor, contactAreaMinor;
+                uint16_t rotation;
+            } touch;
+            CONTROLLER_STATE controller;
+            struct {
+                uint8_t controllerNumber;
+                uint8_t type;
+                uint16_t activeGamepadMask;
+                uint32_t supportedButtonFlags;
+                uint16_t capabilities;
+            } controllerArrival;
+            struct {
+                uint8_t controllerNumber;
+                uint8_t eventType;
+                uint32_t pointerId;
+                float x, y;
+                float pressure;
+            } controllerTouch;
+            struct {
+                uint8_t controllerNumber;
+                uint8_t motionType;
+                float x, y, z;
+            } controllerMotion;
+            struct {
+                uint8_t controllerNumber;
+                uint8_t batteryState;
+                uint8_t batteryPercentage;
+            } controllerBattery;
+        };
+    } INPUT_EVENT, *PINPUT_EVENT;
+
+    typedef struct _CONTROLLER_BATCH {
+        bool hasSentState;
+        CONTROLLER_STATE sentState;
+        bool hasPendingEvent;
+        INPUT_EVENT pendingEvent;
+    } CONTROLLER_BATCH;
+
+    typedef struct _QUEUE_CELL {
+        SDL_atomic_t sequence;
+        INPUT_EVENT event;
+    } QUEUE_CELL;
+
+    void queueEvent(PINPUT_EVENT event);
+
+    bool tryEnqueue(PINPUT_EVENT event);
+
+    bool tryDequeue(PINPUT_EVENT event);
+
+    static
+    bool tryCoalesceEvent(PINPUT_EVENT pending, const INPUT_EVENT* event);
+
+    void dispatchEvent(PINPUT_EVENT event);
+
+    static
+    bool isControllerStateChanged(const CONTROLLER_STATE* sentState, const CONTROLLER_STATE* state, int axisDeadband);
+
+    void batchControllerEvent(PINPUT_EVENT event);
+
+    void sendControllerEvent(PINPUT_EVENT event);
+
+    void flushControllerEvents();
+
+    static int dispatcherThread(void* context);
+
+    QUEUE_CELL m_Queue[INPUT_DISPATCH_QUEUE_SIZE];
+    SDL_atomic_t m_EnqueuePos;
+    int m_DequeuePos;
+
+    InputLatencyStats* m_LatencyStats;
+    uint32_t* m_EventCounts;
+    SDL_Thread* m_Thread;
+    SDL_sem* m_EventSemaphore;
+    SDL_atomic_t m_Stopping;
+    bool m_LoggedQueueFull;
+    int m_AxisDeadband;
+    int m_BatchWindowMs;
+
+    // Only accessed by the dispatcher thread until it has exited
+    uint32_t m_SentEvents;
+    uint32_t m_CoalescedEvents;
+    uint64_t m_TotalQueueTimeUs;
+    uint64_t m_MaxQueueTimeUs;
+    CONTROLLER_BATCH m_ControllerBatches[INPUT_DISPATCH_MAX_CONTROLLERS];
+    uint64_t m_BatchDeadlineUs;
+    uint32_t m_SuppressedControllerEvents;
+    uint32_t m_BatchedControllerEvents;
+};
@@ -3,21 +3,30 @@
 #include <Limelight.h>
 #include "SDL_compat.h"
 #include "settings/mappingmanager.h"
+#include "streaming/streamutils.h"
 
 #include <QtMath>
 
 // How long the Start button must be pressed to toggle mouse emulation
 #define MOUSE_EMULATION_LONG_PRESS_TIME 750
 
-// How long between polling the gamepad to send virtual mouse input
-#define MOUSE_EMULATION_POLLING_INTERVAL 50
+// The speed curve below was tuned for polling the gamepad every 50 ms.
+// We now poll at the display refresh rate and scale motion by the
+// elapsed time, so the cursor speed is the same at any polling rate.
+#define MOUSE_EMULATION_REFERENCE_INTERVAL 50
 
-// Determines how fast the mouse will move each interval
+// Determines how fast the mouse will move each reference interval
 #define MOUSE_EMULATION_MOTION_MULTIPLIER 4
 
 // Determines the maximum motion amount before allowing movement
 #define MOUSE_EMULATION_DEADZONE 2
 
+// Number of points in the precomputed speed curve, from center to full deflection
+#define MOUSE_EMULATION_CURVE_POINTS 1024
+
+// Limits how far the cursor can jump if a timer callback is very late
+#define MOUSE_EMULATION_MAX_ELAPSED_US 100000
+
 // Haptic capabilities (in addition to those from SDL_HapticQuery())
 #define ML_HAPTIC_GC_RUMBLE         (1U << 16)
 #define ML_HAPTIC_SIMPLE_RUMBLE     (1U << 17)
@@ -51,7 +60,7 @@ SdlInputHandler::findStateForGamepad(SDL_JoystickID id)
     return nullptr;
 }
 
-void SdlInputHandler::sendGamepadState(GamepadState* state)
+void SdlInputHandler::sendGamepadState(GamepadState* state, const InputEventOrigin& origin)
 {
     SDL_assert(m_GamepadMask == 0x1 || m_MultiController);
 
@@ -101,15 +110,16 @@ void SdlInputHandler::sendGamepadState(GamepadState* state)
         }
     }
 
-    LiSendMultiControllerEvent(state->index,
-                               m_GamepadMask,
-                               buttons,
-                               lt,
-                               rt,
-                               lsX,
-                               lsY,
-                               rsX,
-                               rsY);
+    m_Dispatcher.sendMultiControllerEvent(state->index,
+                                          m_GamepadMask,
+                                          buttons,
+                                          lt,
+                                          rt,
+                                          lsX,
+                                          lsY,
+                                          rsX,
+                                          rsY,
+                                          origin);
 }
 
 void SdlInputHandler::sendGamepadBatteryState(GamepadState* state, SDL_JoystickPowerLevel level)
@@ -150,7 +160,36 @@ void SdlInputHandler::sendGamepadBatteryState(GamepadState* state, SDL_JoystickP
         return;
     }
 
-    LiSendControllerBatteryEvent(state->index, batteryState, batteryPercentage);
+    m_Dispatcher.sendControllerBatteryEvent(state->index, batteryState, batteryPercentage);
+}
+
+float SdlInputHandler::getMouseEmulationVelocity(int axisValue)
+{
+    // Cursor speed in pixels per second for each point on the curve
+    static const struct MouseEmulationCurve {
+        MouseEmulationCurve()
+        {
+            for (int i = 0; i <= MOUSE_EMULATION_CURVE_POINTS; i++) {
+                // Produce a base vector for mouse movement with increased speed as we deviate further from center
+                float delta = qPow((float)i / MOUSE_EMULATION_CURVE_POINTS * MOUSE_EMULATION_MOTION_MULTIPLIER, 3);
+
+                // Enforce deadzones
+                delta = delta > MOUSE_EMULATION_DEADZONE ? delta - MOUSE_EMULATION_DEADZONE : 0;
+
+                velocity[i] = delta * 1000 / MOUSE_EMULATION_REFERENCE_INTERVAL;
+            }
+        }
+
+        float velocity[MOUSE_EMULATION_CURVE_POINTS + 1];
+    } curve;
+
+    float position = qMin(qAbs(axisValue) / 32766.0f, 1.0f) * MOUSE_EMULATION_CURVE_POINTS;
+    int index = qMin((int)position, MOUSE_EMULATION_CURVE_POINTS - 1);
+
+    // Interpolate between the nearest points on the curve
+    float velocity = curve.velocity[index] + (curve.velocity[index + 1] - curve.velocity[index]) * (position - index);
+
+    return axisValue < 0 ? -velocity : velocity;
 }
 
 Uint32 SdlInputHandler::mouseEmulationTimerCallback(Uint32 interval, void *param)
@@ -160,6 +199,10 @@ Uint32 SdlInputHandler::mouseEmulationTimerCallback(Uint32 interval, void *param
     int rawX;
     int rawY;
 
+    uint64_t now = LiGetMicroseconds();
+    float elapsedSecs = SDL_min(now - gamepad->mouseEmulationLastTimeUs, (uint64_t)MOUSE_EMULATION_MAX_ELAPSED_US) / 1000000.0f;
+    gamepad->mouseEmulationLastTimeUs = now;
+
     // Determine which analog stick is currently receiving the strongest input
     if (abs(gamepad->lsX) + abs(gamepad->lsY) > abs(gamepad->rsX) + abs(gamepad->rsY)) {
         rawX = gamepad->lsX;
@@ -170,19 +213,27 @@ Uint32 SdlInputHandler::mouseEmulationTimerCallback(Uint32 interval, void *param
         rawY = -gamepad->rsY;
     }
 
-    float deltaX;
-    float deltaY;
+    float velocityX = getMouseEmulationVelocity(rawX);
+    float velocityY = getMouseEmulationVelocity(rawY);
+
+    if (velocityX == 0 && velocityY == 0) {
+        // Don't carry leftover motion into the next time the stick moves
+        gamepad->mouseEmulationRemainderX = gamepad->mouseEmulationRemainderY = 0;
+        return interval;
+    }
+
+    // Send whole pixels and carry the fractional motion into the next tick
+    gamepad->mouseEmulationRemainderX += velocityX * elapsedSecs;
+    gamepad->mouseEmulationRemainderY += velocityY * elapsedSecs;
 
-    // Produce a base vector for mouse movement with increased speed as we deviate further from center
-    deltaX = qPow(rawX / 32766.0f * MOUSE_EMULATION_MOTION_MULTIPLIER, 3);
-    deltaY = qPow(rawY / 32766.0f * MOUSE_EMULATION_MOTION_MULTIPLIER, 3);
+    int deltaX = (int)gamepad->mouseEmulationRemainderX;
+    int deltaY = (int)gamepad->mouseEmulationRemainderY;
 
-    // Enforce deadzones
-    deltaX = qAbs(deltaX) > MOUSE_EMULATION_DEADZONE ? deltaX - MOUSE_EMULATION_DEADZONE : 0;
-    deltaY = qAbs(deltaY) > MOUSE_EMULATION_DEADZONE ? deltaY - MOUSE_EMULATION_DEADZONE : 0;
+    gamepad->mouseEmulationRemainderX -= deltaX;
+    gamepad->mouseEmulationRemainderY -= deltaY;
 
     if (deltaX != 0 || deltaY != 0) {
-        LiSendMouseMoveEvent((short)deltaX, (short)deltaY);
+        gamepad->handler->m_Dispatcher.sendMouseMoveEvent((short)deltaX, (short)deltaY);
     }
 
     return interval;
@@ -196,6 +247,9 @@ void SdlInputHandler::handleControllerAxisEvent(SDL_ControllerAxisEvent* event)
         return;
     }
 
+    // Latency is measured from the oldest event in the batch
+    InputEventOrigin origin(InputDeviceGamepad, event->timestamp);
+
     // Batch all pending axis motion events for this gamepad to save CPU time
     SDL_Event nextEvent;
     for (;;) {
@@ -248,7 +302,7 @@ void SdlInputHandler::handleControllerAxisEvent(SDL_ControllerAxisEvent* event)
 
     // Only send the gamepad state to the host if it's not in mouse emulation mode
     if (state->mouseEmulationTimer == 0) {
-        sendGamepadState(state);
+        sendGamepadState(state, origin);
     }
 }
 
@@ -266,6 +320,8 @@ void SdlInputHandler::handleControllerButtonEvent(SDL_ControllerButtonEvent* eve
         return;
     }
 
+    InputEventOrigin origin(InputDeviceGamepad, event->timestamp);
+
     if (m_SwapFaceButtons) {
         switch (event->button) {
         case SDL_CONTROLLER_BUTTON_A:
@@ -291,31 +347,31 @@ void SdlInputHandler::handleControllerButtonEvent(SDL_ControllerButtonEvent* eve
         }
         else if (state->mouseEmulationTimer != 0) {
             if (event->button == SDL_CONTROLLER_BUTTON_A) {
-                LiSendMouseButtonEvent(BUTTON_ACTION_PRESS, BUTTON_LEFT);
+                m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_PRESS, BUTTON_LEFT, origin);
             }
             else if (event->button == SDL_CONTROLLER_BUTTON_B) {
-                LiSendMouseButtonEvent(BUTTON_ACTION_PRESS, BUTTON_RIGHT);
+                m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_PRESS, BUTTON_RIGHT, origin);
             }
             else if (event->button == SDL_CONTROLLER_BUTTON_X) {
-                LiSendMouseButtonEvent(BUTTON_ACTION_PRESS, BUTTON_MIDDLE);
+                m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_PRESS, BUTTON_MIDDLE, origin);
             }
             else if (event->button == SDL_CONTROLLER_BUTTON_LEFTSHOULDER) {
-                LiSendMouseButtonEvent(BUTTON_ACTION_PRESS, BUTTON_X1);
+                m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_PRESS, BUTTON_X1, origin);
             }
             else if (event->button == SDL_CONTROLLER_BUTTON_RIGHTSHOULDER) {
-                LiSendMouseButtonEvent(BUTTON_ACTION_PRESS, BUTTON_X2);
+                m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_PRESS, BUTTON_X2, origin);
             }
             else if (event->button == SDL_CONTROLLER_BUTTON_DPAD_UP) {
-                LiSendScrollEvent(1);
+                m_Dispatcher.sendScrollEvent(1, origin);
             }
             else if (event->button == SDL_CONTROLLER_BUTTON_DPAD_DOWN) {
-                LiSendScrollEvent(-1);
+                m_Dispatcher.sendScrollEvent(-1, origin);
             }
             else if (event->button == SDL_CONTROLLER_BUTTON_DPAD_RIGHT) {
-                LiSendHScrollEvent(1);
+                m_Dispatcher.sendHScrollEvent(1, origin);
             }
             else if (event->button == SDL_CONTROLLER_BUTTON_DPAD_LEFT) {
-                LiSendHScrollEvent(-1);
+                m_Dispatcher.sendHScrollEvent(-1, origin);
             }
         }
     }
@@ -330,37 +386,46 @@ void SdlInputHandler::handleControllerButtonEvent(SDL_ControllerButtonEvent* eve
 
                     SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
                                 "Mouse emulation deactivated");
-                    Session::get()->notifyMouseEmulationMode(false);
-                    Session::get()->getOverlayManager().showToast(Overlay::ToastInfo, Overlay::ToastCategoryGamepadMouse, "Mouse Mode: Off");
+                    if (Session::get() != nullptr) {
+                        Session::get()->notifyMouseEmulationMode(false);
+                        Session::get()->getOverlayManager().showToast(Overlay::ToastInfo, Overlay::ToastCategoryGamepadMouse, "Mouse Mode: Off");
+                    }
                 }
                 else if (m_GamepadMouse) {
                     // Send the start button up event to the host, since we won't do it below
-                    sendGamepadState(state);
+                    sendGamepadState(state, origin);
 
-                    state->mouseEmulationTimer = SDL_AddTimer(MOUSE_EMULATION_POLLING_INTERVAL, SdlInputHandler::mouseEmulationTimerCallback, state);
+                    // Poll at the display refresh rate for smooth cursor motion
+                    int refreshRate = m_Window != nullptr ? StreamUtils::getDisplayRefreshRate(m_Window) : 60;
+                    state->mouseEmulationLastTimeUs = LiGetMicroseconds();
+                    state->mouseEmulationRemainderX = state->mouseEmulationRemainderY = 0;
+                    state->mouseEmulationTimer = SDL_AddTimer(SDL_max(1000 / SDL_max(refreshRate, 1), 1),
+                                                              SdlInputHandler::mouseEmulationTimerCallback, state);
 
                     SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
                                 "Mouse emulation active");
-                    Session::get()->getOverlayManager().showToast(Overlay::ToastInfo, Overlay::ToastCategoryGamepadMouse, "Mouse Mode: Active\nA=Left, B=Right");
-                    Session::get()->notifyMouseEmulationMode(true);
+                    if (Session::get() != nullptr) {
+                        Session::get()->getOverlayManager().showToast(Overlay::ToastInfo, Overlay::ToastCategoryGamepadMouse, "Mouse Mode: Active\nA=Left, B=Right");
+                        Session::get()->notifyMouseEmulationMode(true);
+                    }
                 }
             }
         }
         else if (state->mouseEmulationTimer != 0) {
             if (event->button == SDL_CONTROLLER_BUTTON_A) {
-                LiSendMouseButtonEvent(BUTTON_ACTION_RELEASE, BUTTON_LEFT);
+                m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_RELEASE, BUTTON_LEFT, origin);
             }
             else if (event->button == SDL_CONTROLLER_BUTTON_B) {
-                LiSendMouseButtonEvent(BUTTON_ACTION_RELEASE, BUTTON_RIGHT);
+                m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_RELEASE, BUTTON_RIGHT, origin);
             }
             else if (event->button == SDL_CONTROLLER_BUTTON_X) {
-                LiSendMouseButtonEvent(BUTTON_ACTION_RELEASE, BUTTON_MIDDLE);
+                m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_RELEASE, BUTTON_MIDDLE, origin);
             }
             else if (event->button == SDL_CONTROLLER_BUTTON_LEFTSHOULDER) {
-                LiSendMouseButtonEvent(BUTTON_ACTION_RELEASE, BUTTON_X1);
+                m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_RELEASE, BUTTON_X1, origin);
             }
             else if (event->button == SDL_CONTROLLER_BUTTON_RIGHTSHOULDER) {
-                LiSendMouseButtonEvent(BUTTON_ACTION_RELEASE, BUTTON_X2);
+                m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_RELEASE, BUTTON_X2, origin);
             }
         }
     }
@@ -377,8 +442,8 @@ void SdlInputHandler::handleControllerButtonEvent(SDL_ControllerButtonEvent* eve
         SDL_PushEvent(&event);
 
         // Clear buttons down on this gamepad
-        LiSendMultiControllerEvent(state->index, m_GamepadMask,
-                                   0, 0, 0, 0, 0, 0, 0);
+        m_Dispatcher.sendMultiControllerEvent(state->index, m_GamepadMask,
+                                              0, 0, 0, 0, 0, 0, 0);
         return;
     }
 
@@ -388,18 +453,20 @@ void SdlInputHandler::handleControllerButtonEvent(SDL_ControllerButtonEvent* eve
                     "Detected stats toggle gamepad combo");
 
         // Toggle the stats overlay
-        Session::get()->getOverlayManager().setOverlayState(Overlay::OverlayDebug,
-                                                            !Session::get()->getOverlayManager().isOverlayEnabled(Overlay::OverlayDebug));
+        if (Session::get() != nullptr) {
+            Session::get()->getOverlayManager().setOverlayState(Overlay::OverlayDebug,
+                                                                !Session::get()->getOverlayManager().isOverlayEnabled(Overlay::OverlayDebug));
+        }
 
         // Clear buttons down on this gamepad
-        LiSendMultiControllerEvent(state->index, m_GamepadMask,
-                                   0, 0, 0, 0, 0, 0, 0);
+        m_Dispatcher.sendMultiControllerEvent(state->index, m_GamepadMask,
+                                              0, 0, 0, 0, 0, 0, 0);
         return;
     }
 
     // Only send the gamepad state to the host if it's not in mouse emulation mode
     if (state->mouseEmulationTimer == 0) {
-        sendGamepadState(state);
+        sendGamepadState(state, origin);
     }
 }
 
@@ -412,34 +479,70 @@ void SdlInputHandler::handleControllerSensorEvent(SDL_ControllerSensorEvent* eve
         return;
     }
 
+    InputEventOrigin origin(InputDeviceGamepad, event->timestamp);
+
     switch (event->sensor) {
     case SDL_SENSOR_ACCEL:
-        if (state->accelReportPeriodMs &&
-                SDL_TICKS_PASSED(event->timestamp, state->lastAccelEventTime + state->accelReportPeriodMs) &&
-                memcmp(event->data, state->lastAccelEventData, sizeof(event->data)) != 0) {
-            memcpy(state->lastAccelEventData, event->data, sizeof(event->data));
-            state->lastAccelEventTime = event->timestamp;
-
-            LiSendControllerMotionEvent((uint8_t)state->index, LI_MOTION_TYPE_ACCEL, event->data[0], event->data[1], event->data[2]);
-        }
+        handleMotionSensorSample(state, &state->accelState, LI_MOTION_TYPE_ACCEL, event->data, 1.0f, origin);
         break;
     case SDL_SENSOR_GYRO:
-        if (state->gyroReportPeriodMs &&
-                SDL_TICKS_PASSED(event->timestamp, state->lastGyroEventTime + state->gyroReportPeriodMs) &&
-                memcmp(event->data, state->lastGyroEventData, sizeof(event->data)) != 0) {
-            memcpy(state->lastGyroEventData, event->data, sizeof(event->data));
-            state->lastGyroEventTime = event->timestamp;
-
-            // Convert rad/s to deg/s
-            LiSendControllerMotionEvent((uint8_t)state->index, LI_MOTION_TYPE_GYRO,
-                                        event->data[0] * 57.2957795f,
-                                        event->data[1] * 57.2957795f,
-                                        event->data[2] * 57.2957795f);
-        }
+        // Convert rad/s to deg/s
+        handleMotionSensorSample(state, &state->gyroState, LI_MOTION_TYPE_GYRO, event->data, 57.2957795f, origin);
         break;
     }
 }
 
+void SdlInputHandler::handleMotionSensorSample(GamepadState* state, MotionSensorState* sensor, uint8_t motionType,
+                                               const float* data, float scale, const InputEventOrigin& origin)
+{
+    const int axes = SDL_arraysize(sensor->sampleSum);
+
+    if (sensor->reportPeriodUs == 0) {
+        // The host hasn't asked for this sensor
+        return;
+    }
+
+    // Sensors usually sample much faster than the host wants reports, so we
+    // average every sample in the report period rather than sending whichever
+    // one happens to arrive after the period ends.
+    if (sensor->sampleCount == 0) {
+        sensor->firstSampleOrigin = origin;
+    }
+    for (int i = 0; i < axes; i++) {
+        sensor->sampleSum[i] += data[i];
+    }
+    sensor->sampleCount++;
+
+    uint64_t now = LiGetMicroseconds();
+    if (now < sensor->nextReportTimeUs) {
+        return;
+    }
+
+    // Advance from the previous deadline to keep reports evenly spaced,
+    // unless we've fallen a whole period behind (sensor paused, etc).
+    sensor->nextReportTimeUs += sensor->reportPeriodUs;
+    if (sensor->nextReportTimeUs <= now) {
+        sensor->nextReportTimeUs = now + sensor->reportPeriodUs;
+    }
+
+    float report[axes];
+    for (int i = 0; i < axes; i++) {
+        report[i] = sensor->sampleSum[i] / sensor->sampleCount * scale;
+        sensor->sampleSum[i] = 0;
+    }
+    sensor->sampleCount = 0;
+
+    // Don't send the host the same report again
+    if (memcmp(report, sensor->lastReportData, sizeof(report)) == 0) {
+        return;
+    }
+    memcpy(sensor->lastReportData, report, sizeof(report));
+
+    m_Dispatcher.sendControllerMotionEvent((uint8_t)state->index, motionType,
+                                           report[0], report[1], report[2],
+                                           sensor->firstSampleOrigin);
+}
+
 void SdlInputHandler::handleControllerTouchpadEvent(SDL_ControllerTouchpadEvent* event)
 {
     GamepadState* state = findStateForGamepad(event->which);
@@ -462,7 +565,8 @@ void SdlInputHandler::handleControllerTouchpadEvent(SDL_ControllerTouchpadEvent*
         return;
     }
 
-    LiSendControllerTouchEvent((uint8_t)state->index, eventType, event->finger, event->x, event->y, event->pressure);
+    InputEventOrigin origin(InputDeviceGamepad, event->timestamp);
+    m_Dispatcher.sendControllerTouchEvent((uint8_t)state->index, eventType, event->finger, event->x, event->y, event->pressure, origin);
 }
 
 #endif
@@ -564,6 +668,7 @@ void SdlInputHandler::handleControllerDeviceEvent(SDL_ControllerDeviceEvent* eve
             state->index = 0;
         }
 
+        state->handler = this;
         state->controller = controller;
         state->jsId = SDL_JoystickInstanceID(SDL_GameControllerGetJoystick(state->controller));
 
@@ -710,7 +815,7 @@ void SdlInputHandler::handleControllerDeviceEvent(SDL_ControllerDeviceEvent* eve
 #endif
             type == LI_CTYPE_PS;
 
-        LiSendControllerArrivalEvent(state->index, m_GamepadMask, type, supportedButtonFlags, capabilities);
+        m_Dispatcher.sendControllerArrivalEvent(state->index, m_GamepadMask, type, supportedButtonFlags, capabilities);
 #else
 
         // Send an empty event to tell the PC we've arrived
@@ -726,7 +831,9 @@ void SdlInputHandler::handleControllerDeviceEvent(SDL_ControllerDeviceEvent* eve
         state = findStateForGamepad(event->which);
         if (state != NULL) {
             if (state->mouseEmulationTimer != 0) {
-                Session::get()->notifyMouseEmulationMode(false);
+                if (Session::get() != nullptr) {
+                    Session::get()->notifyMouseEmulationMode(false);
+                }
                 SDL_RemoveTimer(state->mouseEmulationTimer);
             }
 
@@ -752,8 +859,8 @@ void SdlInputHandler::handleControllerDeviceEvent(SDL_ControllerDeviceEvent* eve
                         state->index);
 
             // Send a final event to let the PC know this gamepad is gone
-            LiSendMultiControllerEvent(state->index, m_GamepadMask,
-                                       0, 0, 0, 0, 0, 0, 0);
+            m_Dispatcher.sendMultiControllerEvent(state->index, m_GamepadMask,
+                                                  0, 0, 0, 0, 0, 0, 0);
 
             // Clear all remaining state from this slot
             SDL_memset(state, 0, sizeof(*state));
@@ -871,19 +978,31 @@ void SdlInputHandler::setMotionEventState(uint16_t controllerNumber, uint8_t mot
 
 #if SDL_VERSION_ATLEAST(2, 0, 14)
     if (m_GamepadState[controllerNumber].controller != nullptr) {
-        uint8_t reportPeriodMs = reportRateHz ? (1000 / reportRateHz) : 0;
+        MotionSensorState* sensor;
+        SDL_SensorType sensorType;
 
         switch (motionType) {
         case LI_MOTION_TYPE_ACCEL:
-            m_GamepadState[controllerNumber].accelReportPeriodMs = reportPeriodMs;
-            SDL_GameControllerSetSensorEnabled(m_GamepadState[controllerNumber].controller, SDL_SENSOR_ACCEL, reportRateHz ? SDL_TRUE : SDL_FALSE);
+            sensor = &m_GamepadState[controllerNumber].accelState;
+            sensorType = SDL_SENSOR_ACCEL;
             break;
 
         case LI_MOTION_TYPE_GYRO:
-            m_GamepadState[controllerNumber].gyroReportPeriodMs = reportPeriodMs;
-            SDL_GameControllerSetSensorEnabled(m_GamepadState[controllerNumber].controller, SDL_SENSOR_GYRO, reportRateHz ? SDL_TRUE : SDL_FALSE);
+            sensor = &m_GamepadState[controllerNumber].gyroState;
+            sensorType = SDL_SENSOR_GYRO;
             break;
+
+        default:
+            return;
         }
+
+        // Start a fresh report schedule at the new rate
+        sensor->reportPeriodUs = reportRateHz ? (1000000 / reportRateHz) : 0;
+        sensor->nextReportTimeUs = 0;
+        sensor->sampleCount = 0;
+        SDL_zero(sensor->sampleSum);
+        SDL_zero(sensor->lastReportData);
+        SDL_GameControllerSetSensorEnabled(m_GamepadState[controllerNumber].controller, sensorType, reportRateHz ? SDL_TRUE : SDL_FALSE);
     }
 #endif
 }
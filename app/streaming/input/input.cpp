@@ -9,8 +9,12 @@
 #include <QDir>
 #include <QGuiApplication>
 
-SdlInputHandler::SdlInputHandler(StreamingPreferences& prefs, int streamWidth, int streamHeight)
-    : m_MultiController(prefs.multiController),
+SdlInputHandler::SdlInputHandler(StreamingPreferences& prefs, int streamWidth, int streamHeight,
+                                 InputLatencyStats* latencyStats)
+    : m_TextPaster(&m_Dispatcher),
+      m_ReplayMode(false),
+      m_Window(nullptr),
+      m_MultiController(prefs.multiController),
       m_GamepadMouse(prefs.gamepadMouse),
       m_SwapMouseButtons(prefs.swapMouseButtons),
       m_ReverseScrollDirection(prefs.reverseScrollDirection),
@@ -214,13 +218,18 @@ SdlInputHandler::SdlInputHandler(StreamingPreferences& prefs, int streamWidth, i
     SDL_zero(m_LastTouchDownEvent);
     SDL_zero(m_LastTouchUpEvent);
     SDL_zero(m_TouchDownEvent);
+
+    // If this fails, events will be sent directly from the calling thread
+    m_Dispatcher.start(latencyStats);
 }
 
 SdlInputHandler::~SdlInputHandler()
 {
     for (int i = 0; i < MAX_GAMEPADS; i++) {
         if (m_GamepadState[i].mouseEmulationTimer != 0) {
-            Session::get()->notifyMouseEmulationMode(false);
+            if (Session::get() != nullptr) {
+                Session::get()->notifyMouseEmulationMode(false);
+            }
             SDL_RemoveTimer(m_GamepadState[i].mouseEmulationTimer);
         }
 #if !SDL_VERSION_ATLEAST(2, 0, 9)
@@ -238,6 +247,13 @@ SdlInputHandler::~SdlInputHandler()
     SDL_RemoveTimer(m_RightButtonReleaseTimer);
     SDL_RemoveTimer(m_DragTimer);
 
+    // Stop typing any pasted text before the dispatcher goes away
+    m_TextPaster.cancel();
+
+    // Send any input still waiting in the dispatch queue. This must happen
+    // before the connection is stopped.
+    m_Dispatcher.stop();
+
 #if !SDL_VERSION_ATLEAST(2, 0, 9)
     SDL_QuitSubSystem(SDL_INIT_HAPTIC);
     SDL_assert(!SDL_WasInit(SDL_INIT_HAPTIC));
@@ -280,7 +296,7 @@ void SdlInputHandler::raiseAllKeys()
                 (int)m_KeysDown.count());
 
     for (auto keyDown : std::as_const(m_KeysDown)) {
-        LiSendKeyboardEvent(keyDown, KEY_ACTION_UP, 0);
+        m_Dispatcher.sendKeyboardEvent(keyDown, KEY_ACTION_UP, 0);
     }
 
     m_KeysDown.clear();
@@ -404,15 +420,16 @@ bool SdlInputHandler::isSystemKeyCaptureActive()
 void SdlInputHandler::setCaptureActive(bool active)
 {
     if (active) {
-        // If we're in relative mode, try to activate SDL's relative mouse mode
-        if (m_AbsoluteMouseMode || SDL_SetRelativeMouseMode(SDL_TRUE) < 0) {
+        // If we're in relative mode, try to activate SDL's relative mouse mode.
+        // Replays don't take over the real mouse.
+        if (m_AbsoluteMouseMode || m_ReplayMode || SDL_SetRelativeMouseMode(SDL_TRUE) < 0) {
             // Relative mouse mode didn't work or was disabled, so we'll just hide the cursor
             SDL_ShowCursor(m_MouseCursorCapturedVisibilityState);
             m_FakeCaptureActive = true;
         }
 
         // Synchronize the client and host cursor when activating absolute capture
-        if (m_AbsoluteMouseMode) {
+        if (m_AbsoluteMouseMode && !m_ReplayMode) {
             int mouseX, mouseY;
             int windowX, windowY;
 
@@ -455,10 +472,16 @@ void SdlInputHandler::setCaptureActive(bool active)
     updateKeyboardGrabState();
 }
 
+void SdlInputHandler::setReplayMode(uint32_t* eventCounts)
+{
+    m_ReplayMode = true;
+    m_Dispatcher.setCountingSink(eventCounts);
+}
+
 void SdlInputHandler::handleTouchFingerEvent(SDL_TouchFingerEvent* event)
 {
 #if SDL_VERSION_ATLEAST(2, 0, 10)
-    if (SDL_GetTouchDeviceType(event->touchId) != SDL_TOUCH_DEVICE_DIRECT) {
+    if (!m_ReplayMode && SDL_GetTouchDeviceType(event->touchId) != SDL_TOUCH_DEVICE_DIRECT) {
         // Ignore anything that isn't a touchscreen. We may get callbacks
         // for trackpads, but we want to handle those in the mouse path.
         return;
@@ -2,10 +2,30 @@
 
 #include "settings/streamingpreferences.h"
 #include "backend/computermanager.h"
+#include "dispatcher.h"
+#include "textpaster.h"
 
 #include "SDL_compat.h"
 
+class SdlInputHandler;
+
+#if SDL_VERSION_ATLEAST(2, 0, 14)
+// Samples from a gamepad motion sensor are averaged into evenly
+// spaced reports at the rate requested by the host.
+struct MotionSensorState {
+    uint32_t reportPeriodUs;
+    uint64_t nextReportTimeUs;
+
+    float sampleSum[SDL_arraysize(SDL_ControllerSensorEvent::data)];
+    uint32_t sampleCount;
+    InputEventOrigin firstSampleOrigin;
+
+    float lastReportData[SDL_arraysize(SDL_ControllerSensorEvent::data)];
+};
+#endif
+
 struct GamepadState {
+    SdlInputHandler* handler;
     SDL_GameController* controller;
     SDL_JoystickID jsId;
     short index;
@@ -17,19 +37,17 @@ struct GamepadState {
 #endif
 
     SDL_TimerID mouseEmulationTimer;
+    uint64_t mouseEmulationLastTimeUs;
+    float mouseEmulationRemainderX;
+    float mouseEmulationRemainderY;
     uint32_t lastStartDownTime;
 
     bool clickpadButtonEmulationEnabled;
     bool emulatedClickpadButtonDown;
 
 #if SDL_VERSION_ATLEAST(2, 0, 14)
-    uint8_t gyroReportPeriodMs;
-    float lastGyroEventData[SDL_arraysize(SDL_ControllerSensorEvent::data)];
-    uint32_t lastGyroEventTime;
-
-    uint8_t accelReportPeriodMs;
-    float lastAccelEventData[SDL_arraysize(SDL_ControllerSensorEvent::data)];
-    uint32_t lastAccelEventTime;
+    MotionSensorState gyroState;
+    MotionSensorState accelState;
 #endif
 
     int buttons;
@@ -84,7 +102,8 @@ struct DualSenseOutputReport{
 class SdlInputHandler
 {
 public:
-    explicit SdlInputHandler(StreamingPreferences& prefs, int streamWidth, int streamHeight);
+    explicit SdlInputHandler(StreamingPreferences& prefs, int streamWidth, int streamHeight,
+                             InputLatencyStats* latencyStats = nullptr);
 
     ~SdlInputHandler();
 
@@ -154,6 +173,11 @@ public:
 
     void updatePointerRegionLock();
 
+    // Used to replay recorded input without a connection. Events that would be
+    // sent to the host are counted in eventCounts instead, and touch events are
+    // accepted even though the recorded touch device no longer exists.
+    void setReplayMode(uint32_t* eventCounts);
+
     static
     QString getUnmappedGamepads();
 
@@ -176,7 +200,7 @@ private:
     GamepadState*
     findStateForGamepad(SDL_JoystickID id);
 
-    void sendGamepadState(GamepadState* state);
+    void sendGamepadState(GamepadState* state, const InputEventOrigin& origin = InputEventOrigin());
 
     void sendGamepadBatteryState(GamepadState* state, SDL_JoystickPowerLevel level);
 
@@ -196,6 +220,14 @@ private:
     static
     Uint32 mouseEmulationTimerCallback(Uint32 interval, void* param);
 
+    static
+    float getMouseEmulationVelocity(int axisValue);
+
+#if SDL_VERSION_ATLEAST(2, 0, 14)
+    void handleMotionSensorSample(GamepadState* state, MotionSensorState* sensor, uint8_t motionType,
+                                  const float* data, float scale, const InputEventOrigin& origin);
+#endif
+
     static
     Uint32 releaseLeftButtonTimerCallback(Uint32 interval, void* param);
 
@@ -205,6 +237,9 @@ private:
     static
     Uint32 dragTimerCallback(Uint32 interval, void* param);
 
+    InputDispatcher m_Dispatcher;
+    TextPaster m_TextPaster;
+    bool m_ReplayMode;
     SDL_Window* m_Window;
     bool m_MultiController;
     bool m_GamepadMouse;
@@ -42,7 +42,9 @@ void SdlInputHandler::performSpecialKeyCombo(KeyCombo combo)
     case KeyComboToggleFullScreen:
         SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
                     "Detected full-screen toggle combo");
-        Session::s_ActiveSession->toggleFullscreen();
+        if (Session::get() != nullptr) {
+            Session::get()->toggleFullscreen();
+        }
 
         // Force raise all keys just be safe across this full-screen/windowed
         // transition just in case key events get lost.
@@ -54,8 +56,10 @@ void SdlInputHandler::performSpecialKeyCombo(KeyCombo combo)
                     "Detected stats toggle combo");
 
         // Toggle the stats overlay
-        Session::get()->getOverlayManager().setOverlayState(Overlay::OverlayDebug,
-                                                            !Session::get()->getOverlayManager().isOverlayEnabled(Overlay::OverlayDebug));
+        if (Session::get() != nullptr) {
+            Session::get()->getOverlayManager().setOverlayState(Overlay::OverlayDebug,
+                                                                !Session::get()->getOverlayManager().isOverlayEnabled(Overlay::OverlayDebug));
+        }
         break;
 
     case KeyComboToggleMouseMode:
@@ -94,6 +98,14 @@ void SdlInputHandler::performSpecialKeyCombo(KeyCombo combo)
 
     case KeyComboPasteText:
     {
+        // The same combo stops a paste that is still being typed
+        if (m_TextPaster.isActive()) {
+            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                        "Detected cancel paste combo");
+            m_TextPaster.cancel();
+            break;
+        }
+
         SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
                     "Detected type clipboard text combo");
 
@@ -103,21 +115,10 @@ void SdlInputHandler::performSpecialKeyCombo(KeyCombo combo)
 
         char* text;
         if (SDL_HasClipboardText() && (text = SDL_GetClipboardText()) != nullptr) {
-            // Sending both CR and LF will lead to two newlines in the destination for
-            // each newline in the source, so we fix up any CRLFs into just a single LF.
-            for (char* c = text; *c != 0; c++) {
-                if (*c == '\r' && *(c + 1) == '\n') {
-                    // We're using strlen() rather than strlen() - 1 since we need to add 1
-                    // to copy the null terminator which is not included in strlen()'s count.
-                    memmove(c, c + 1, strlen(c));
-                }
-            }
+            size_t length = TextPaster::normalizeLineEndings(text, strlen(text));
 
-            // Send this text to the PC
-            LiSendUtf8TextEvent(text, (unsigned int)strlen(text));
-
-            // SDL_GetClipboardText() allocates, so we must free
-            SDL_free((void*)text);
+            // Send this text to the PC. The paster frees the text when it's done.
+            m_TextPaster.start(text, length);
         }
         else {
             SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
@@ -164,7 +165,9 @@ void SdlInputHandler::performSpecialKeyCombo(KeyCombo combo)
                 modeText = "System Keys: Off";
                 break;
             }
-            Session::get()->getOverlayManager().showToast(Overlay::ToastInfo, Overlay::ToastCategoryCaptureKeys, modeText);
+            if (Session::get() != nullptr) {
+                Session::get()->getOverlayManager().showToast(Overlay::ToastInfo, Overlay::ToastCategoryCaptureKeys, modeText);
+            }
         }
         break;
 
@@ -513,9 +516,10 @@ void SdlInputHandler::handleKeyEvent(SDL_KeyboardEvent* event)
         m_KeysDown.remove(keyCode);
     }
 
-    LiSendKeyboardEvent2(0x8000 | keyCode,
-                        event->state == SDL_PRESSED ?
-                            KEY_ACTION_DOWN : KEY_ACTION_UP,
-                        modifiers,
-                        shouldNotConvertToScanCodeOnServer ? SS_KBE_FLAG_NON_NORMALIZED : 0);
+    m_Dispatcher.sendKeyboardEvent(0x8000 | keyCode,
+                                   event->state == SDL_PRESSED ?
+                                       KEY_ACTION_DOWN : KEY_ACTION_UP,
+                                   modifiers,
+                                   shouldNotConvertToScanCodeOnServer ? SS_KBE_FLAG_NON_NORMALIZED : 0,
+                                   InputEventOrigin(InputDeviceKeyboard, event->timestamp));
 }
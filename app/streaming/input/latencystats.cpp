@@ -0,0 +1,147 @@
+#include "latencystats.h"
+
+#include <Limelight.h>
+
+InputEventOrigin::InputEventOrigin()
+    : deviceClass(InputDeviceNone),
+      inputTimeUs(0)
+{
+}
+
+InputEventOrigin::InputEventOrigin(InputDeviceClass deviceClass, Uint32 sdlTimestamp)
+    : deviceClass(deviceClass)
+{
+    Uint32 now = SDL_GetTicks();
+
+    inputTimeUs = LiGetMicroseconds();
+    if (SDL_TICKS_PASSED(now, sdlTimestamp)) {
+        inputTimeUs -= (uint64_t)(now - sdlTimestamp) * 1000;
+    }
+}
+
+InputLatencyStats::InputLatencyStats()
+    : m_Lock(0)
+{
+    SDL_zero(m_Window);
+    SDL_zero(m_Global);
+}
+
+void InputLatencyStats::addSample(InputDeviceClass deviceClass, uint64_t latencyUs)
+{
+    if (deviceClass < 0 || deviceClass >= InputDeviceMax) {
+        return;
+    }
+
+    int bucket = (int)SDL_min(latencyUs / INPUT_LATENCY_BUCKET_US, (uint64_t)INPUT_LATENCY_BUCKETS - 1);
+
+    PHISTOGRAM histograms[] = { &m_Window[deviceClass], &m_Global[deviceClass] };
+
+    SDL_AtomicLock(&m_Lock);
+    for (PHISTOGRAM histogram : histograms) {
+        histogram->count++;
+        histogram->maxUs = SDL_max(histogram->maxUs, latencyUs);
+        histogram->buckets[bucket]++;
+    }
+    SDL_AtomicUnlock(&m_Lock);
+}
+
+double InputLatencyStats::getPercentileMs(const HISTOGRAM& histogram, int percentile)
+{
+    uint32_t target = (uint32_t)(((uint64_t)histogram.count * percentile + 99) / 100);
+    uint32_t seen = 0;
+
+    target = SDL_max(target, 1U);
+    for (int i = 0; i < INPUT_LATENCY_BUCKETS - 1; i++) {
+        seen += histogram.buckets[i];
+        if (seen >= target) {
+            // Report the upper edge of the bucket, unless nothing got that slow
+            return SDL_min((uint64_t)(i + 1) * INPUT_LATENCY_BUCKET_US, histogram.maxUs) / 1000.0;
+        }
+    }
+
+    // It landed in the overflow bucket
+    return histogram.maxUs / 1000.0;
+}
+
+const char* InputLatencyStats::getDeviceClassName(int deviceClass)
+{
+    switch (deviceClass) {
+    case InputDeviceMouse:
+        return "Mouse";
+    case InputDeviceKeyboard:
+        return "Keyboard";
+    case InputDeviceGamepad:
+        return "Gamepad";
+    case InputDeviceTouch:
+        return "Touch";
+    case InputDevicePen:
+        return "Pen";
+    default:
+        return "Unknown";
+    }
+}
+
+void InputLatencyStats::appendWindowStats(char* output, int length)
+{
+    HISTOGRAM window[InputDeviceMax];
+    int startOffset = (int)strlen(output);
+    int offset = startOffset;
+    int ret;
+    bool first = true;
+
+    // Take a copy so the lock isn't held while formatting
+    SDL_AtomicLock(&m_Lock);
+    SDL_memcpy(window, m_Window, sizeof(window));
+    SDL_zero(m_Window);
+    SDL_AtomicUnlock(&m_Lock);
+
+    for (int i = 0; i < InputDeviceMax; i++) {
+        if (window[i].count == 0) {
+            continue;
+        }
+
+        ret = snprintf(&output[offset],
+                       length - offset,
+                       "%s%s %.1f/%.1f",
+                       first ? "Input latency p50/p99 ms: " : "  ",
+                       getDeviceClassName(i),
+                       getPercentileMs(window[i], 50),
+                       getPercentileMs(window[i], 99));
+        if (ret < 0 || ret >= length - offset) {
+            // Drop the input stats rather than showing a truncated line
+            output[startOffset] = 0;
+            return;
+        }
+
+        offset += ret;
+        first = false;
+    }
+
+    if (!first && offset + 1 < length) {
+        output[offset++] = '\n';
+        output[offset] = 0;
+    }
+}
+
+void InputLatencyStats::logGlobalStats()
+{
+    HISTOGRAM global[InputDeviceMax];
+
+    SDL_AtomicLock(&m_Lock);
+    SDL_memcpy(global, m_Global, sizeof(global));
+    SDL_AtomicUnlock(&m_Lock);
+
+    for (int i = 0; i < InputDeviceMax; i++) {
+        if (global[i].count == 0) {
+            continue;
+        }
+
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "%s input latency: %u events, p50 %.2f ms, p99 %.2f ms, max %.2f ms",
+                    getDeviceClassName(i),
+                    global[i].count,
+                    getPercentileMs(global[i], 50),
+                    getPercentileMs(global[i], 99),
+                    global[i].maxUs / 1000.0);
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "SDL_compat.h"
+
+// Each histogram bucket covers 100 us, up to 100 ms. Anything
+// slower than that is counted in the final overflow bucket.
+#define INPUT_LATENCY_BUCKET_US 100
+#define INPUT_LATENCY_BUCKETS 1001
+
+enum InputDeviceClass {
+    InputDeviceNone = -1,
+    InputDeviceMouse,
+    InputDeviceKeyboard,
+    InputDeviceGamepad,
+    InputDeviceTouch,
+    InputDevicePen,
+    InputDeviceMax
+};
+
+// Identifies the user input that caused an event to be sent to the host.
+// Events synthesized by us (timers, key raising on focus loss, etc.) have
+// no origin and aren't counted in the latency stats.
+struct InputEventOrigin {
+    InputEventOrigin();
+
+    // The SDL event timestamp only has millisecond resolution, so
+    // we translate it to our microsecond clock when handling the event.
+    InputEventOrigin(InputDeviceClass deviceClass, Uint32 sdlTimestamp);
+
+    InputDeviceClass deviceClass;
+    uint64_t inputTimeUs;
+};
+
+// Tracks the delay between SDL receiving an input event and us handing
+// it to moonlight-common-c for transmission, for each class of device.
+// Samples may be added from any thread.
+class InputLatencyStats
+{
+public:
+    InputLatencyStats();
+
+    void addSample(InputDeviceClass deviceClass, uint64_t latencyUs);
+
+    // Appends p50/p99 latencies for events since the last call,
+    // then starts a new measurement window.
+    void appendWindowStats(char* output, int length);
+
+    void logGlobalStats();
+
+private:
+    typedef struct _HISTOGRAM {
+        uint32_t count;
+        uint64_t maxUs;
+        uint32_t buckets[INPUT_LATENCY_BUCKETS];
+    } HISTOGRAM, *PHISTOGRAM;
+
+    static
+    double getPercentileMs(const HISTOGRAM& histogram, int percentile);
+
+    static
+    const char* getDeviceClassName(int deviceClass);
+
+    HISTOGRAM m_Window[InputDeviceMax];
+    HISTOGRAM m_Global[InputDeviceMax];
+    SDL_SpinLock m_Lock;
+};
@@ -62,10 +62,11 @@ void SdlInputHandler::handleMouseButtonEvent(SDL_MouseButtonEvent* event)
             button = BUTTON_RIGHT;
     }
 
-    LiSendMouseButtonEvent(event->state == SDL_PRESSED ?
-                               BUTTON_ACTION_PRESS :
-                               BUTTON_ACTION_RELEASE,
-                           button);
+    m_Dispatcher.sendMouseButtonEvent(event->state == SDL_PRESSED ?
+                                          BUTTON_ACTION_PRESS :
+                                          BUTTON_ACTION_RELEASE,
+                                      button,
+                                      InputEventOrigin(InputDeviceMouse, event->timestamp));
 }
 
 void SdlInputHandler::handleMouseMotionEvent(SDL_MouseMotionEvent* event)
@@ -79,6 +80,9 @@ void SdlInputHandler::handleMouseMotionEvent(SDL_MouseMotionEvent* event)
         return;
     }
 
+    // Latency is measured from the oldest event in the batch
+    InputEventOrigin origin(InputDeviceMouse, event->timestamp);
+
     // Batch all pending mouse motion events to save CPU time
     Sint32 x = event->x, y = event->y, xrel = event->xrel, yrel = event->yrel;
     SDL_Event nextEvent;
@@ -134,7 +138,7 @@ void SdlInputHandler::handleMouseMotionEvent(SDL_MouseMotionEvent* event)
             }
         }
         if (mouseInVideoRegion || m_MouseWasInVideoRegion || m_PendingMouseButtonsAllUpOnVideoRegionLeave) {
-            LiSendMousePositionEvent((short)x, (short)y, dst.w, dst.h);
+            m_Dispatcher.sendMousePositionEvent((short)x, (short)y, dst.w, dst.h, origin);
         }
 
         // Adjust the cursor visibility if applicable
@@ -150,7 +154,7 @@ void SdlInputHandler::handleMouseMotionEvent(SDL_MouseMotionEvent* event)
         m_MouseWasInVideoRegion = mouseInVideoRegion;
     }
     else {
-        LiSendMouseMoveEvent(xrel, yrel);
+        m_Dispatcher.sendMouseMoveEvent(xrel, yrel, origin);
     }
 }
 
@@ -174,6 +178,8 @@ void SdlInputHandler::handleMouseWheelEvent(SDL_MouseWheelEvent* event)
         }
     }
 
+    InputEventOrigin origin(InputDeviceMouse, event->timestamp);
+
 #if SDL_VERSION_ATLEAST(2, 0, 18)
     if (event->preciseY != 0.0f) {
         // Invert the scroll direction if needed
@@ -187,7 +193,7 @@ void SdlInputHandler::handleMouseWheelEvent(SDL_MouseWheelEvent* event)
         event->preciseY = SDL_clamp(event->preciseY, -1.0f, 1.0f);
 #endif
 
-        LiSendHighResScrollEvent((short)(event->preciseY * 120)); // WHEEL_DELTA
+        m_Dispatcher.sendHighResScrollEvent((short)(event->preciseY * 120), origin); // WHEEL_DELTA
     }
 
     if (event->preciseX != 0.0f) {
@@ -202,7 +208,7 @@ void SdlInputHandler::handleMouseWheelEvent(SDL_MouseWheelEvent* event)
         event->preciseX = SDL_clamp(event->preciseX, -1.0f, 1.0f);
 #endif
 
-        LiSendHighResHScrollEvent((short)(event->preciseX * 120)); // WHEEL_DELTA
+        m_Dispatcher.sendHighResHScrollEvent((short)(event->preciseX * 120), origin); // WHEEL_DELTA
     }
 #else
     if (event->y != 0) {
@@ -216,7 +222,7 @@ void SdlInputHandler::handleMouseWheelEvent(SDL_MouseWheelEvent* event)
         event->y = SDL_clamp(event->y, -1, 1);
 #endif
 
-        LiSendScrollEvent((signed char)event->y);
+        m_Dispatcher.sendScrollEvent((signed char)event->y, origin);
     }
 
     if (event->x != 0) {
@@ -230,7 +236,7 @@ void SdlInputHandler::handleMouseWheelEvent(SDL_MouseWheelEvent* event)
         event->x = SDL_clamp(event->x, -1, 1);
 #endif
 
-        LiSendHScrollEvent((signed char)event->x);
+        m_Dispatcher.sendHScrollEvent((signed char)event->x, origin);
     }
 #endif
 }
@@ -0,0 +1,209 @@
+#include "recorder.h"
+
+InputRecorder::InputRecorder()
+    : m_Lock(0),
+      m_Recording(false),
+      m_WriteFailed(false),
+      m_EventCount(0)
+{
+}
+
+InputRecorder::~InputRecorder()
+{
+    stop();
+}
+
+bool InputRecorder::start(const QString& fileName, const StreamingPreferences& prefs,
+                          int streamWidth, int streamHeight, SDL_Window* window)
+{
+    INPUT_RECORDING_HEADER header;
+    SDL_version linkedVersion;
+
+    SDL_assert(!m_Recording);
+
+    m_File.setFileName(fileName);
+    if (!m_File.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Failed to open input recording %s: %s",
+                     qPrintable(fileName),
+                     qPrintable(m_File.errorString()));
+        return false;
+    }
+
+    SDL_GetVersion(&linkedVersion);
+
+    SDL_zero(header);
+    header.magic = INPUT_RECORDING_MAGIC;
+    header.version = INPUT_RECORDING_VERSION;
+    header.eventSize = sizeof(SDL_Event);
+    header.sdlMajor = linkedVersion.major;
+    header.sdlMinor = linkedVersion.minor;
+    header.sdlPatch = linkedVersion.patch;
+    header.streamWidth = streamWidth;
+    header.streamHeight = streamHeight;
+    SDL_GetWindowSize(window, &header.windowWidth, &header.windowHeight);
+    header.captureSysKeysMode = prefs.captureSysKeysMode;
+
+    if (prefs.multiController) {
+        header.flags |= INPUT_RECORDING_FLAG_MULTI_CONTROLLER;
+    }
+    if (prefs.absoluteMouseMode) {
+        header.flags |= INPUT_RECORDING_FLAG_ABSOLUTE_MOUSE;
+    }
+    if (prefs.absoluteTouchMode) {
+        header.flags |= INPUT_RECORDING_FLAG_ABSOLUTE_TOUCH;
+    }
+    if (prefs.gamepadMouse) {
+        header.flags |= INPUT_RECORDING_FLAG_GAMEPAD_MOUSE;
+    }
+    if (prefs.swapMouseButtons) {
+        header.flags |= INPUT_RECORDING_FLAG_SWAP_MOUSE_BUTTONS;
+    }
+    if (prefs.reverseScrollDirection) {
+        header.flags |= INPUT_RECORDING_FLAG_REVERSE_SCROLL;
+    }
+    if (prefs.swapFaceButtons) {
+        header.flags |= INPUT_RECORDING_FLAG_SWAP_FACE_BUTTONS;
+    }
+
+    if (m_File.write((const char*)&header, sizeof(header)) != sizeof(header)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Failed to write input recording header: %s",
+                     qPrintable(m_File.errorString()));
+        m_File.close();
+        return false;
+    }
+
+    // Gamepads that were already attached were reported before our event
+    // watch was installed, so record an added event for each of them now.
+    for (int i = 0; i < SDL_NumJoysticks(); i++) {
+        if (!SDL_IsGameController(i)) {
+            continue;
+        }
+
+        SDL_Event event = {};
+        event.cdevice.type = SDL_CONTROLLERDEVICEADDED;
+        event.cdevice.timestamp = SDL_GetTicks();
+        event.cdevice.which = SDL_JoystickGetDeviceInstanceID(i);
+        if (m_File.write((const char*)&event, sizeof(event)) == sizeof(event)) {
+            m_EventCount++;
+        }
+    }
+
+    m_Recording = true;
+    SDL_AddEventWatch(InputRecorder::eventWatch, this);
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "Recording input events to: %s",
+                qPrintable(fileName));
+    return true;
+}
+
+void InputRecorder::stop()
+{
+    if (!m_Recording) {
+        return;
+    }
+
+    SDL_DelEventWatch(InputRecorder::eventWatch, this);
+
+    // Wait for any event watch callback still writing on another thread
+    SDL_AtomicLock(&m_Lock);
+    m_Recording = false;
+    SDL_AtomicUnlock(&m_Lock);
+
+    m_File.close();
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "Recorded %u input events",
+                m_EventCount);
+}
+
+bool InputRecorder::isInputEvent(const SDL_Event* event)
+{
+    switch (event->type) {
+    case SDL_KEYUP:
+    case SDL_KEYDOWN:
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+    case SDL_MOUSEMOTION:
+    case SDL_MOUSEWHEEL:
+    case SDL_CONTROLLERAXISMOTION:
+    case SDL_CONTROLLERBUTTONDOWN:
+    case SDL_CONTROLLERBUTTONUP:
+    case SDL_CONTROLLERDEVICEADDED:
+    case SDL_CONTROLLERDEVICEREMOVED:
+#if SDL_VERSION_ATLEAST(2, 0, 14)
+    case SDL_CONTROLLERSENSORUPDATE:
+    case SDL_CONTROLLERTOUCHPADDOWN:
+    case SDL_CONTROLLERTOUCHPADUP:
+    case SDL_CONTROLLERTOUCHPADMOTION:
+#endif
+#if SDL_VERSION_ATLEAST(2, 24, 0)
+    case SDL_JOYBATTERYUPDATED:
+#endif
+    case SDL_FINGERDOWN:
+    case SDL_FINGERMOTION:
+    case SDL_FINGERUP:
+        return true;
+    default:
+        return false;
+    }
+}
+
+int InputRecorder::eventWatch(void* userdata, SDL_Event* event)
+{
+    InputRecorder* me = reinterpret_cast<InputRecorder*>(userdata);
+    SDL_Event recordedEvent;
+    bool writeFailed = false;
+
+    if (event->type == SDL_WINDOWEVENT) {
+        // Absolute mouse and touch events are scaled by the window size
+        if (event->window.event != SDL_WINDOWEVENT_SIZE_CHANGED) {
+            return 1;
+        }
+    }
+    else if (!isInputEvent(event)) {
+        return 1;
+    }
+
+    recordedEvent = *event;
+
+    if (event->type == SDL_CONTROLLERDEVICEADDED) {
+        // Added events carry a device index, but every later event for the
+        // gamepad uses its instance ID. Record the instance ID instead so the
+        // replay can match them up.
+        recordedEvent.cdevice.which = SDL_JoystickGetDeviceInstanceID(event->cdevice.which);
+    }
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+    else if (event->type == SDL_FINGERDOWN ||
+             event->type == SDL_FINGERMOTION ||
+             event->type == SDL_FINGERUP) {
+        // Trackpad touches are ignored by the input handler
+        if (SDL_GetTouchDeviceType(event->tfinger.touchId) != SDL_TOUCH_DEVICE_DIRECT) {
+            return 1;
+        }
+    }
+#endif
+
+    // Events can be pushed from other threads too
+    SDL_AtomicLock(&me->m_Lock);
+    if (me->m_Recording && !me->m_WriteFailed) {
+        if (me->m_File.write((const char*)&recordedEvent, sizeof(recordedEvent)) == sizeof(recordedEvent)) {
+            me->m_EventCount++;
+        }
+        else {
+            // Don't keep trying to write on every event
+            me->m_WriteFailed = writeFailed = true;
+        }
+    }
+    SDL_AtomicUnlock(&me->m_Lock);
+
+    if (writeFailed) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Failed to write input recording: %s",
+                     qPrintable(me->m_File.errorString()));
+    }
+
+    return 1;
+}
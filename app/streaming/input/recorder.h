@@ -0,0 +1,69 @@
+#pragma once
+
+#include "settings/streamingpreferences.h"
+
+#include "SDL_compat.h"
+
+#include <QFile>
+
+// "MLIR" in little endian
+#define INPUT_RECORDING_MAGIC 0x52494C4D
+#define INPUT_RECORDING_VERSION 1
+
+#define INPUT_RECORDING_FLAG_MULTI_CONTROLLER   0x01
+#define INPUT_RECORDING_FLAG_ABSOLUTE_MOUSE     0x02
+#define INPUT_RECORDING_FLAG_ABSOLUTE_TOUCH     0x04
+#define INPUT_RECORDING_FLAG_GAMEPAD_MOUSE      0x08
+#define INPUT_RECORDING_FLAG_SWAP_MOUSE_BUTTONS 0x10
+#define INPUT_RECORDING_FLAG_REVERSE_SCROLL     0x20
+#define INPUT_RECORDING_FLAG_SWAP_FACE_BUTTONS  0x40
+
+// A recording is this header followed by raw SDL_Event structs. Events are
+// stored in native layout, so recordings can only be replayed by a build
+// using the same SDL version on the same platform.
+typedef struct _INPUT_RECORDING_HEADER {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t eventSize;
+    uint8_t sdlMajor;
+    uint8_t sdlMinor;
+    uint8_t sdlPatch;
+    uint8_t reserved;
+    int32_t streamWidth;
+    int32_t streamHeight;
+    int32_t windowWidth;
+    int32_t windowHeight;
+    uint32_t flags;
+    int32_t captureSysKeysMode;
+} INPUT_RECORDING_HEADER, *PINPUT_RECORDING_HEADER;
+
+// Records the SDL input events handled by the streaming session to a file,
+// so they can be replayed later by the replay-input command. We use an event
+// watch rather than recording in the main loop so that events the input
+// handler pulls out of the queue itself when batching are captured too.
+class InputRecorder
+{
+public:
+    InputRecorder();
+
+    ~InputRecorder();
+
+    bool start(const QString& fileName, const StreamingPreferences& prefs,
+               int streamWidth, int streamHeight, SDL_Window* window);
+
+    void stop();
+
+    // Returns true for the event types handled by SdlInputHandler
+    static
+    bool isInputEvent(const SDL_Event* event);
+
+private:
+    static
+    int SDLCALL eventWatch(void* userdata, SDL_Event* event);
+
+    QFile m_File;
+    SDL_SpinLock m_Lock;
+    bool m_Recording;
+    bool m_WriteFailed;
+    uint32_t m_EventCount;
+};
@@ -14,15 +14,19 @@
 // How far the finger can move before it cancels a drag or tap
 #define DEAD_ZONE_DELTA 0.01f
 
-Uint32 SdlInputHandler::releaseLeftButtonTimerCallback(Uint32, void*)
+Uint32 SdlInputHandler::releaseLeftButtonTimerCallback(Uint32, void* param)
 {
-    LiSendMouseButtonEvent(BUTTON_ACTION_RELEASE, BUTTON_LEFT);
+    auto me = reinterpret_cast<SdlInputHandler*>(param);
+
+    me->m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_RELEASE, BUTTON_LEFT);
     return 0;
 }
 
-Uint32 SdlInputHandler::releaseRightButtonTimerCallback(Uint32, void*)
+Uint32 SdlInputHandler::releaseRightButtonTimerCallback(Uint32, void* param)
 {
-    LiSendMouseButtonEvent(BUTTON_ACTION_RELEASE, BUTTON_RIGHT);
+    auto me = reinterpret_cast<SdlInputHandler*>(param);
+
+    me->m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_RELEASE, BUTTON_RIGHT);
     return 0;
 }
 
@@ -39,13 +43,14 @@ Uint32 SdlInputHandler::dragTimerCallback(Uint32, void *param)
         me->m_DragButton = BUTTON_LEFT;
     }
 
-    LiSendMouseButtonEvent(BUTTON_ACTION_PRESS, me->m_DragButton);
+    me->m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_PRESS, me->m_DragButton);
 
     return 0;
 }
 
 void SdlInputHandler::handleRelativeFingerEvent(SDL_TouchFingerEvent* event)
 {
+    InputEventOrigin origin(InputDeviceTouch, event->timestamp);
     int fingerIndex = -1;
 
     // Observations on Windows 10: x and y appear to be relative to 0,0 of the window client area.
@@ -100,7 +105,7 @@ void SdlInputHandler::handleRelativeFingerEvent(SDL_TouchFingerEvent* event)
         short deltaX = static_cast<short>(event->dx * m_StreamWidth);
         short deltaY = static_cast<short>(event->dy * m_StreamHeight);
         if (deltaX != 0 || deltaY != 0) {
-            LiSendMouseMoveEvent(deltaX, deltaY);
+            m_Dispatcher.sendMouseMoveEvent(deltaX, deltaY, origin);
         }
     }
 
@@ -133,7 +138,7 @@ void SdlInputHandler::handleRelativeFingerEvent(SDL_TouchFingerEvent* event)
 
         // Release any drag
         if (m_DragButton != 0) {
-            LiSendMouseButtonEvent(BUTTON_ACTION_RELEASE, m_DragButton);
+            m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_RELEASE, m_DragButton, origin);
             m_DragButton = 0;
         }
         // 2 finger tap
@@ -143,24 +148,24 @@ void SdlInputHandler::handleRelativeFingerEvent(SDL_TouchFingerEvent* event)
             m_TouchDownEvent[0].timestamp = 0;
 
             // Press down the right mouse button
-            LiSendMouseButtonEvent(BUTTON_ACTION_PRESS, BUTTON_RIGHT);
+            m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_PRESS, BUTTON_RIGHT, origin);
 
             // Queue a timer to release it in 100 ms
             SDL_RemoveTimer(m_RightButtonReleaseTimer);
             m_RightButtonReleaseTimer = SDL_AddTimer(TAP_BUTTON_RELEASE_DELAY,
                                                      releaseRightButtonTimerCallback,
-                                                     nullptr);
+                                                     this);
         }
         // 1 finger tap
         else if (event->timestamp - m_TouchDownEvent[0].timestamp < 250) {
             // Press down the left mouse button
-            LiSendMouseButtonEvent(BUTTON_ACTION_PRESS, BUTTON_LEFT);
+            m_Dispatcher.sendMouseButtonEvent(BUTTON_ACTION_PRESS, BUTTON_LEFT, origin);
 
             // Queue a timer to release it in 100 ms
             SDL_RemoveTimer(m_LeftButtonReleaseTimer);
             m_LeftButtonReleaseTimer = SDL_AddTimer(TAP_BUTTON_RELEASE_DELAY,
                                                     releaseLeftButtonTimerCallback,
-                                                    nullptr);
+                                                    this);
         }
     }
 
@@ -0,0 +1,136 @@
+#include "textpaster.h"
+#include "utils.h"
+
+// Bytes of text in each event sent to the host
+#define PASTE_CHUNK_SIZE 32
+
+// Delay between chunks
+#define PASTE_CHUNK_INTERVAL_MS 10
+
+TextPaster::TextPaster(InputDispatcher* dispatcher)
+    : m_Dispatcher(dispatcher),
+      m_Thread(nullptr),
+      m_Text(nullptr),
+      m_Length(0),
+      m_ChunkIntervalMs(PASTE_CHUNK_INTERVAL_MS)
+{
+    SDL_AtomicSet(&m_Active, 0);
+    SDL_AtomicSet(&m_Cancelled, 0);
+
+    // Some hosts need the text to arrive more slowly
+    if (Utils::getEnvironmentVariableOverride("PASTE_CHUNK_INTERVAL_MS", &m_ChunkIntervalMs)) {
+        m_ChunkIntervalMs = SDL_max(m_ChunkIntervalMs, 0);
+    }
+}
+
+TextPaster::~TextPaster()
+{
+    cancel();
+}
+
+size_t TextPaster::normalizeLineEndings(char* text, size_t length)
+{
+    size_t outPos = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        // Sending both CR and LF will lead to two newlines in the destination
+        // for each newline in the source, so drop the CR from each CRLF.
+        if (text[i] == '\r' && i + 1 < length && text[i + 1] == '\n') {
+            continue;
+        }
+
+        text[outPos++] = text[i];
+    }
+
+    return outPos;
+}
+
+bool TextPaster::start(char* text, size_t length)
+{
+    // Wait for the previous paste's thread if it has finished
+    cancel();
+
+    m_Text = text;
+    m_Length = length;
+    SDL_AtomicSet(&m_Cancelled, 0);
+    SDL_AtomicSet(&m_Active, 1);
+
+    m_Thread = SDL_CreateThread(TextPaster::pasteThread, "TextPaster", this);
+    if (m_Thread == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Failed to create paste thread: %s",
+                     SDL_GetError());
+        reset();
+        return false;
+    }
+
+    return true;
+}
+
+bool TextPaster::isActive()
+{
+    return SDL_AtomicGet(&m_Active) != 0;
+}
+
+void TextPaster::cancel()
+{
+    if (m_Thread == nullptr) {
+        return;
+    }
+
+    SDL_AtomicSet(&m_Cancelled, 1);
+    SDL_WaitThread(m_Thread, nullptr);
+    m_Thread = nullptr;
+
+    reset();
+}
+
+void TextPaster::reset()
+{
+    SDL_free(m_Text);
+    m_Text = nullptr;
+    m_Length = 0;
+    SDL_AtomicSet(&m_Active, 0);
+}
+
+int TextPaster::pasteThread(void* context)
+{
+    TextPaster* me = reinterpret_cast<TextPaster*>(context);
+    size_t pos = 0;
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                "Pasting %u bytes of text",
+                (unsigned int)me->m_Length);
+
+    while (pos < me->m_Length) {
+        if (SDL_AtomicGet(&me->m_Cancelled) != 0) {
+            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                        "Paste cancelled after %u of %u bytes",
+                        (unsigned int)pos,
+                        (unsigned int)me->m_Length);
+            break;
+        }
+
+        size_t end = SDL_min(pos + PASTE_CHUNK_SIZE, me->m_Length);
+
+        // Back up to the start of a UTF-8 sequence rather than splitting it
+        while (end < me->m_Length && end > pos && (me->m_Text[end] & 0xC0) == 0x80) {
+            end--;
+        }
+        if (end == pos) {
+            // Not valid UTF-8, so there's no sequence to preserve
+            end = SDL_min(pos + PASTE_CHUNK_SIZE, me->m_Length);
+        }
+
+        me->m_Dispatcher->sendUtf8TextEvent(me->m_Text + pos, (unsigned int)(end - pos));
+        pos = end;
+
+        if (pos < me->m_Length && me->m_ChunkIntervalMs > 0) {
+            SDL_Delay(me->m_ChunkIntervalMs);
+        }
+    }
+
+    // The text is freed by the owning thread when it joins us
+    SDL_AtomicSet(&me->m_Active, 0);
+    return 0;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "dispatcher.h"
+
+#include "SDL_compat.h"
+
+// Types text on the host from a background thread. The text is sent in
+// small chunks that never split a UTF-8 sequence, paced so a large paste
+// doesn't overrun the host's input queue, and can be cancelled at any
+// point between chunks.
+class TextPaster
+{
+public:
+    TextPaster(InputDispatcher* dispatcher);
+
+    // Cancels any paste in progress
+    ~TextPaster();
+
+    // Takes ownership of the text, which must be allocated with SDL_malloc()
+    bool start(char* text, size_t length);
+
+    bool isActive();
+
+    // Stops sending before the next chunk and waits for the sender to exit
+    void cancel();
+
+    // Converts CRLF line endings to LF in place and returns the new length
+    static
+    size_t normalizeLineEndings(char* text, size_t length);
+
+private:
+    static
+    int pasteThread(void* context);
+
+    void reset();
+
+    InputDispatcher* m_Dispatcher;
+    SDL_Thread* m_Thread;
+    SDL_atomic_t m_Active;
+    SDL_atomic_t m_Cancelled;
+    char* m_Text;
+    size_t m_Length;
+    int m_ChunkIntervalMs;
+};
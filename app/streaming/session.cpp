@@ -1,6 +1,7 @@
 #include "session.h"
 #include "settings/streamingpreferences.h"
 #include "streaming/streamutils.h"
+#include "streaming/startupprofiler.h"
 #include "backend/richpresencemanager.h"
 #include "backend/nvhttp.h"
 
@@ -48,7 +49,7 @@
 
 CONNECTION_LISTENER_CALLBACKS Session::k_ConnCallbacks = {
     Session::clStageStarting,
-    nullptr,
+    Session::clStageComplete,
     Session::clStageFailed,
     nullptr,
     Session::clConnectionTerminated,
@@ -67,14 +68,25 @@ QSemaphore Session::s_ActiveSessionSemaphore(1);
 
 void Session::clStageStarting(int stage)
 {
+    s_ActiveSession->m_ConnectionStagePhase = StartupProfiler::get()->beginPhase("%s", LiGetStageName(stage));
+
     // We know this is called on the same thread as LiStartConnection()
     // which happens to be the main thread, so it's cool to interact
     // with the GUI in these callbacks.
     emit s_ActiveSession->stageStarting(QString::fromLocal8Bit(LiGetStageName(stage)));
 }
 
+void Session::clStageComplete(int)
+{
+    StartupProfiler::get()->endPhase(s_ActiveSession->m_ConnectionStagePhase);
+    s_ActiveSession->m_ConnectionStagePhase = -1;
+}
+
 void Session::clStageFailed(int stage, int errorCode)
 {
+    StartupProfiler::get()->endPhase(s_ActiveSession->m_ConnectionStagePhase, false);
+    s_ActiveSession->m_ConnectionStagePhase = -1;
+
     // Perform the port test now, while we're on the async connection thread and not blocking the UI.
     unsigned int portFlags = LiGetPortFlagsFromStage(stage);
     s_ActiveSession->m_PortTestResults = LiTestClientConnectivity(CONN_TEST_SERVER, 443, portFlags);
@@ -276,7 +288,8 @@ void Session::clSetAdaptiveTriggers(uint16_t controllerNumber, uint8_t eventFlag
 
 bool Session::chooseDecoder(StreamingPreferences::VideoDecoderSelection vds,
                             SDL_Window* window, int videoFormat, int width, int height,
-                            int frameRate, bool enableVsync, bool enableFramePacing, bool testOnly, IVideoDecoder*& chosenDecoder)
+                            int frameRate, bool enableVsync, bool enableFramePacing, bool testOnly, IVideoDecoder*& chosenDecoder,
+                            bool prewarm)
 {
     DECODER_PARAMETERS params;
 
@@ -293,17 +306,23 @@ bool Session::chooseDecoder(StreamingPreferences::VideoDecoderSelection vds,
     params.enableVsync = enableVsync;
     params.enableFramePacing = enableFramePacing;
     params.testOnly = testOnly;
+    params.prewarm = prewarm;
     params.vds = vds;
 
     SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
                 "V-sync %s",
                 enableVsync ? "enabled" : "disabled");
 
+    int phase = StartupProfiler::get()->beginPhase("chooseDecoder (format 0x%x, %s)",
+                                                   videoFormat,
+                                                   testOnly ? "test" : (prewarm ? "pre-warm" : "stream"));
+
 #ifdef HAVE_SLVIDEO
     chosenDecoder = new SLVideoDecoder(testOnly);
     if (chosenDecoder->initialize(&params)) {
         SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
                     "SLVideo video decoder chosen");
+        StartupProfiler::get()->endPhase(phase);
         return true;
     }
     else {
@@ -319,6 +338,7 @@ bool Session::chooseDecoder(StreamingPreferences::VideoDecoderSelection vds,
     if (chosenDecoder->initialize(&params)) {
         SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
                     "FFmpeg-based video decoder chosen");
+        StartupProfiler::get()->endPhase(phase);
         return true;
     }
     else {
@@ -334,6 +354,7 @@ bool Session::chooseDecoder(StreamingPreferences::VideoDecoderSelection vds,
 #endif
 
     // If we reach this, we didn't initialize any decoders successfully
+    StartupProfiler::get()->endPhase(phase, false);
     return false;
 }
 
@@ -350,6 +371,19 @@ int Session::drSetup(int videoFormat, int width, int height, int frameRate, void
     SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Video stream is %dx%dx%d (format 0x%x)",
                 width, height, frameRate, videoFormat);
 
+    // If we pre-warmed a decoder for this stream while the connection was being
+    // established, adopt it now. It isn't started until exec(), since pull-based
+    // decoders must not touch the frame queue until LiStartConnection() succeeds.
+    SDL_LockMutex(s_ActiveSession->m_DecoderLock);
+    if (s_ActiveSession->m_PrewarmedDecoder != nullptr &&
+            s_ActiveSession->isPrewarmedDecoderUsable()) {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                    "Using pre-warmed video decoder");
+        s_ActiveSession->m_VideoDecoder = s_ActiveSession->m_PrewarmedDecoder;
+        s_ActiveSession->m_PrewarmedDecoder = nullptr;
+    }
+    SDL_UnlockMutex(s_ActiveSession->m_DecoderLock);
+
     return 0;
 }
 
@@ -552,6 +586,7 @@ Session::Session(NvComputer* computer, NvApp& app, StreamingPreferences *prefere
       m_App(app),
       m_Window(nullptr),
       m_VideoDecoder(nullptr),
+      m_PrewarmedDecoder(nullptr),
       m_DecoderLock(SDL_CreateMutex()),
       m_AudioMuted(false),
       m_QtWindow(nullptr),
@@ -559,14 +594,19 @@ Session::Session(NvComputer* computer, NvApp& app, StreamingPreferences *prefere
       m_InputHandler(nullptr),
       m_MouseEmulationRefCount(0),
       m_FlushingWindowEventsRef(0),
+      m_ConnectionStagePhase(-1),
       m_ShouldExit(false),
       m_AsyncConnectionSuccess(false),
       m_PortTestResults(0),
       m_OpusDecoder(nullptr),
       m_AudioRenderer(nullptr),
       m_AudioSampleCount(0),
-      m_DropAudioEndTime(0)
+      m_DropAudioEndTime(0),
+      m_AudioStatsLock(0)
 {
+    SDL_zero(m_ActiveWndAudioStats);
+    SDL_zero(m_LastWndAudioStats);
+    SDL_zero(m_GlobalAudioStats);
 }
 
 Session::~Session()
@@ -579,6 +619,8 @@ Session::~Session()
 
 bool Session::initialize(QQuickWindow* qtWindow)
 {
+    StartupProfiler::get()->start();
+
     m_QtWindow = qtWindow;
 
 #ifdef Q_OS_DARWIN
@@ -890,7 +932,9 @@ bool Session::initialize(QQuickWindow* qtWindow)
 
     // Check for validation errors/warnings and emit
     // signals for them, if appropriate
+    int phase = StartupProfiler::get()->beginPhase("validateLaunch");
     bool ret = validateLaunch(testWindow);
+    StartupProfiler::get()->endPhase(phase, ret);
 
     if (ret) {
         // Video format is now locked in
@@ -1217,6 +1261,9 @@ private:
 
         // Notify that the session is ready to be cleaned up
         emit m_Session->readyForDeletion();
+
+        // Now that we're not streaming, measure anything we're still unsure of
+        Session::startOpusDecoderSpeedTest();
     }
 
     void run() override
@@ -1358,6 +1405,68 @@ void Session::getWindowDimensions(int& x, int& y,
     x = y = SDL_WINDOWPOS_CENTERED_DISPLAY(displayIndex);
 }
 
+bool Session::shouldEnableVsync()
+{
+    // If the stream exceeds the display refresh rate (plus some slack),
+    // forcefully disable V-sync to allow the stream to render faster
+    // than the display.
+    int displayHz = StreamUtils::getDisplayRefreshRate(m_Window);
+    if (m_Preferences->enableVsync && displayHz + 5 < m_StreamConfig.fps) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                    "Disabling V-sync because refresh rate limit exceeded");
+        return false;
+    }
+
+    return m_Preferences->enableVsync;
+}
+
+bool Session::resetVideoRenderer(int& currentDisplayIndex)
+{
+    DECODER_PARAMETERS params = {};
+    bool ret;
+
+    SDL_LockMutex(m_DecoderLock);
+
+    // Discard any additional window events that could cause
+    // the renderer to be recreated again.
+    flushWindowEvents();
+
+    // Update the window display mode based on our current monitor
+    // NB: Avoid a useless modeset by only doing this if it changed.
+    if (currentDisplayIndex != SDL_GetWindowDisplayIndex(m_Window)) {
+        currentDisplayIndex = SDL_GetWindowDisplayIndex(m_Window);
+        updateOptimalWindowDisplayMode();
+    }
+
+    params.window = m_Window;
+    params.vds = m_Preferences->videoDecoderSelection;
+    params.videoFormat = m_ActiveVideoFormat;
+    params.width = m_ActiveVideoWidth;
+    params.height = m_ActiveVideoHeight;
+    params.frameRate = m_ActiveVideoFrameRate;
+    params.enableVsync = shouldEnableVsync();
+    params.enableFramePacing = params.enableVsync && m_Preferences->framePacing;
+    params.testOnly = false;
+
+    ret = m_VideoDecoder->resetRenderer(&params);
+    if (ret) {
+        // Now that the old renderer is dead, flush any events it may
+        // have queued to reset itself.
+        SDL_PumpEvents();
+        SDL_FlushEvent(SDL_RENDER_TARGETS_RESET);
+
+        // Set HDR mode on the new renderer. We may miss the callback
+        // if the HDR transition happens while we're recreating it.
+        m_VideoDecoder->setHdrMode(LiGetCurrentHostDisplayHdrMode());
+
+        // After a window resize, we need to reset the pointer lock region
+        m_InputHandler->updatePointerRegionLock();
+    }
+
+    SDL_UnlockMutex(m_DecoderLock);
+    return ret;
+}
+
 void Session::updateOptimalWindowDisplayMode()
 {
     SDL_DisplayMode desktopMode, bestMode, mode;
@@ -1499,6 +1608,24 @@ void Session::notifyMouseEmulationMode(bool enabled)
     m_OverlayManager.setMouseModeOverlayActive(m_MouseEmulationRefCount > 0);
 }
 
+// Called on the video decoder thread
+void Session::appendInputStats(char* output, int length)
+{
+    m_InputLatencyStats.appendWindowStats(output, length);
+}
+
+// Called on the thread pushing the event
+int Session::eventWakeWatch(void* userdata, SDL_Event* event)
+{
+    // Input events come from SDL_PollEvent() on the main thread itself,
+    // so we only need to wake it for events pushed by our other threads.
+    if (event->type == SDL_USEREVENT || event->type == SDL_QUIT) {
+        SDL_SemPost((SDL_sem*)userdata);
+    }
+
+    return 1;
+}
+
 class AsyncConnectionStartThread : public QThread
 {
 public:
@@ -1549,6 +1676,7 @@ bool Session::startConnectionAsync()
     }
 
     QString rtspSessionUrl;
+    int phase = StartupProfiler::get()->beginPhase("startApp");
 
     try {
         NvHTTP http(m_Computer);
@@ -1561,13 +1689,17 @@ bool Session::startConnectionAsync()
                       !m_Preferences->multiController,
                       rtspSessionUrl);
     } catch (const GfeHttpResponseException& e) {
+        StartupProfiler::get()->endPhase(phase, false);
         emit displayLaunchError(tr("Host returned error: %1").arg(e.toQString()));
         return false;
     } catch (const QtNetworkReplyException& e) {
+        StartupProfiler::get()->endPhase(phase, false);
         emit displayLaunchError(e.toQString());
         return false;
     }
 
+    StartupProfiler::get()->endPhase(phase);
+
     QByteArray hostnameStr = m_Computer->activeAddress.address().toUtf8();
     QByteArray siAppVersion = m_Computer->appVersion.toUtf8();
 
@@ -1708,13 +1840,73 @@ void Session::start()
 
     // Initialize the gamepad code with our preferences
     // NB: m_InputHandler must be initialize before starting the connection.
-    m_InputHandler = new SdlInputHandler(*m_Preferences, m_StreamConfig.width, m_StreamConfig.height);
+    m_InputHandler = new SdlInputHandler(*m_Preferences, m_StreamConfig.width, m_StreamConfig.height,
+                                         &m_InputLatencyStats);
 
     // Kick off the async connection thread then return to the caller to pump the event loop
     auto thread = new AsyncConnectionStartThread(this);
     QObject::connect(thread, &QThread::finished, this, &Session::exec);
     QObject::connect(thread, &QThread::finished, thread, &QThread::deleteLater);
     thread->start();
+
+    // Build the decoder while the app launches and the RTSP handshake runs,
+    // rather than after the connection is established.
+    QTimer::singleShot(0, this, &Session::prewarmDecoder);
+}
+
+// Called on the main thread while the connection is being established. This
+// blocks the UI for as long as decoder creation takes (including the test
+// decode), but renderers must be created on the thread that owns the window.
+void Session::prewarmDecoder()
+{
+    bool prewarm = true;
+
+    // Bail if the connection already failed or exec() beat us to it
+    if (m_InputHandler == nullptr || m_Window != nullptr) {
+        return;
+    }
+
+    Utils::getEnvironmentVariableOverride("PREWARM_DECODER", &prewarm);
+    if (!prewarm) {
+        return;
+    }
+
+    // Renderers are bound to the window, so we create the real one
+    // now and keep it hidden until exec() is ready to show it.
+    m_Window = createWindow(SDL_WINDOW_HIDDEN);
+    if (m_Window == nullptr) {
+        return;
+    }
+
+    // The video format is already locked in, so unless the host changes
+    // our stream parameters, we'll be able to use this decoder.
+    IVideoDecoder* decoder;
+    bool enableVsync = shouldEnableVsync();
+    if (!chooseDecoder(m_Preferences->videoDecoderSelection,
+                       m_Window, m_StreamConfig.supportedVideoFormats,
+                       m_StreamConfig.width, m_StreamConfig.height, m_StreamConfig.fps,
+                       enableVsync,
+                       enableVsync && m_Preferences->framePacing,
+                       false,
+                       decoder,
+                       true)) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                    "Failed to pre-warm video decoder");
+        return;
+    }
+
+    SDL_LockMutex(m_DecoderLock);
+    m_PrewarmedDecoder = decoder;
+    SDL_UnlockMutex(m_DecoderLock);
+}
+
+bool Session::isPrewarmedDecoderUsable()
+{
+    // The host may not give us the stream we asked for
+    return m_ActiveVideoFormat == m_StreamConfig.supportedVideoFormats &&
+           m_ActiveVideoWidth == m_StreamConfig.width &&
+           m_ActiveVideoHeight == m_StreamConfig.height &&
+           m_ActiveVideoFrameRate == m_StreamConfig.fps;
 }
 
 void Session::interrupt()
@@ -1729,26 +1921,30 @@ void Session::interrupt()
     SDL_PushEvent(&event);
 }
 
-void Session::exec()
+QJsonObject Session::getStartupProfileInfo()
 {
-    // If the connection failed, clean up and abort the connection.
-    if (!m_AsyncConnectionSuccess) {
-        delete m_InputHandler;
-        m_InputHandler = nullptr;
-        SDL_QuitSubSystem(SDL_INIT_VIDEO);
-        QThreadPool::globalInstance()->start(new DeferredSessionCleanupTask(this));
-        return;
-    }
-
-    // Pump the Qt event loop one last time before we create our SDL window
-    // This is sometimes necessary for the QML code to process any signals
-    // we've emitted from the async connection thread.
-    QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
-    QCoreApplication::sendPostedEvents();
+    QJsonObject info;
+
+    info["version"] = VERSION_STR;
+    info["hostGpu"] = m_Computer->gpuModel;
+    info["hostAppVersion"] = m_Computer->appVersion;
+    info["hostGfeVersion"] = m_Computer->gfeVersion;
+    info["width"] = m_StreamConfig.width;
+    info["height"] = m_StreamConfig.height;
+    info["fps"] = m_StreamConfig.fps;
+    info["videoFormat"] = m_StreamConfig.supportedVideoFormats;
+    info["connected"] = m_AsyncConnectionSuccess;
+
+    return info;
+}
 
+SDL_Window* Session::createWindow(Uint32 flags)
+{
     int x, y, width, height;
     getWindowDimensions(x, y, width, height);
 
+    int phase = StartupProfiler::get()->beginPhase((flags & SDL_WINDOW_HIDDEN) ? "createWindow (hidden)" : "createWindow");
+
 #ifdef STEAM_LINK
     // We need a little delay before creating the window or we will trigger some kind
     // of graphics driver bug on Steam Link that causes a jagged overlay to appear in
@@ -1766,7 +1962,7 @@ void Session::exec()
     SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 0);
 
     // We always want a resizable window with High DPI enabled
-    Uint32 defaultWindowFlags = SDL_WINDOW_ALLOW_HIGHDPI | SDL_WINDOW_RESIZABLE;
+    Uint32 defaultWindowFlags = SDL_WINDOW_ALLOW_HIGHDPI | SDL_WINDOW_RESIZABLE | flags;
 
     // If we're starting in windowed mode and the Moonlight GUI is maximized or
     // minimized, match that with the streaming window.
@@ -1798,28 +1994,70 @@ void Session::exec()
     std::string windowName = QString(m_Computer->name + " - Moonlight").toStdString();
 #endif
 
-    m_Window = SDL_CreateWindow(windowName.c_str(),
-                                x,
-                                y,
-                                width,
-                                height,
-                                defaultWindowFlags | StreamUtils::getPlatformWindowFlags());
-    if (!m_Window) {
+    SDL_Window* window = SDL_CreateWindow(windowName.c_str(),
+                                          x,
+                                          y,
+                                          width,
+                                          height,
+                                          defaultWindowFlags | StreamUtils::getPlatformWindowFlags());
+    if (!window) {
         SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
                     "SDL_CreateWindow() failed with platform flags: %s",
                     SDL_GetError());
 
-        m_Window = SDL_CreateWindow(windowName.c_str(),
-                                    x,
-                                    y,
-                                    width,
-                                    height,
-                                    defaultWindowFlags);
-        if (!m_Window) {
+        window = SDL_CreateWindow(windowName.c_str(),
+                                  x,
+                                  y,
+                                  width,
+                                  height,
+                                  defaultWindowFlags);
+        if (!window) {
             SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
                          "SDL_CreateWindow() failed: %s",
                          SDL_GetError());
+        }
+    }
 
+    StartupProfiler::get()->endPhase(phase, window != nullptr);
+    return window;
+}
+
+void Session::exec()
+{
+    // If the connection failed, clean up and abort the connection.
+    if (!m_AsyncConnectionSuccess) {
+        delete m_InputHandler;
+        m_InputHandler = nullptr;
+
+        // Destroy anything we created while pre-warming the decoder
+        SDL_LockMutex(m_DecoderLock);
+        delete m_PrewarmedDecoder;
+        m_PrewarmedDecoder = nullptr;
+        delete m_VideoDecoder;
+        m_VideoDecoder = nullptr;
+        SDL_UnlockMutex(m_DecoderLock);
+
+        if (m_Window != nullptr) {
+            SDL_DestroyWindow(m_Window);
+            m_Window = nullptr;
+        }
+
+        StartupProfiler::get()->finish(getStartupProfileInfo());
+
+        SDL_QuitSubSystem(SDL_INIT_VIDEO);
+        QThreadPool::globalInstance()->start(new DeferredSessionCleanupTask(this));
+        return;
+    }
+
+    // Pump the Qt event loop one last time before we create our SDL window
+    // This is sometimes necessary for the QML code to process any signals
+    // we've emitted from the async connection thread.
+    QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+    QCoreApplication::sendPostedEvents();
+
+    if (m_Window == nullptr) {
+        m_Window = createWindow(0);
+        if (!m_Window) {
             delete m_InputHandler;
             m_InputHandler = nullptr;
             SDL_QuitSubSystem(SDL_INIT_VIDEO);
@@ -1827,9 +2065,21 @@ void Session::exec()
             return;
         }
     }
+    else {
+        // The window was created hidden while pre-warming the decoder
+        SDL_ShowWindow(m_Window);
+    }
 
     m_InputHandler->setWindow(m_Window);
 
+    // Record input for later replay if requested
+    QString inputRecordFile = qgetenv("ML_INPUT_RECORD_FILE");
+    if (!inputRecordFile.isEmpty()) {
+        m_InputRecorder.start(inputRecordFile, *m_Preferences,
+                              m_StreamConfig.width, m_StreamConfig.height,
+                              m_Window);
+    }
+
     QSvgRenderer svgIconRenderer(QString(":/res/moonlight.svg"));
     QImage svgImage(ICON_SIZE, ICON_SIZE, QImage::Format_RGBA8888);
     svgImage.fill(0);
@@ -1862,6 +2112,48 @@ void Session::exec()
     bool needsFirstEnterCapture = false;
     bool needsPostDecoderCreationCapture = true;
 
+    SDL_LockMutex(m_DecoderLock);
+
+    // If the pre-warmed decoder wasn't ready in time for drSetup(), we can still use
+    // it, but we may have dropped the frames that arrived before now.
+    if (m_PrewarmedDecoder != nullptr) {
+        if (m_VideoDecoder == nullptr && isPrewarmedDecoderUsable()) {
+            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                        "Using pre-warmed video decoder after stream start");
+            m_VideoDecoder = m_PrewarmedDecoder;
+            LiRequestIdrFrame();
+        }
+        else {
+            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                        "Discarding pre-warmed video decoder");
+            delete m_PrewarmedDecoder;
+        }
+
+        m_PrewarmedDecoder = nullptr;
+    }
+
+    // Now that the connection is established, the pre-warmed decoder can start
+    // pulling frames. Anything received since drSetup() is waiting in the queue.
+    if (m_VideoDecoder != nullptr && !m_VideoDecoder->startPrewarmed()) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                    "Failed to start pre-warmed video decoder");
+        delete m_VideoDecoder;
+        m_VideoDecoder = nullptr;
+    }
+
+    if (m_VideoDecoder != nullptr) {
+        // Set HDR mode. We may have missed the callback
+        // before the pre-warmed decoder was adopted.
+        m_VideoDecoder->setHdrMode(LiGetCurrentHostDisplayHdrMode());
+
+        // The decoder is already initialized, so it can't recreate the
+        // window and lose our capture state like it can below.
+        m_InputHandler->setCaptureActive(true);
+        needsPostDecoderCreationCapture = false;
+    }
+
+    SDL_UnlockMutex(m_DecoderLock);
+
     // Stop text input. SDL enables it by default
     // when we initialize the video subsystem, but this
     // causes an IME popup when certain keys are held down
@@ -1907,6 +2199,23 @@ void Session::exec()
     // Switch to async logging mode when we enter the SDL loop
     StreamUtils::enterAsyncLoggingMode();
 
+#if !SDL_VERSION_ATLEAST(2, 0, 18) || defined(STEAM_LINK)
+#ifndef STEAM_LINK
+    constexpr Uint32 k_EventPollIntervalMs = 1;
+#else
+    // Waking every 1 ms to process input is too much for the low performance
+    // ARM core in the Steam Link, so we will wait 10 ms instead.
+    constexpr Uint32 k_EventPollIntervalMs = 10;
+#endif
+
+    // Events pushed by other threads (frames to render, rumble, quit) post this
+    // semaphore, so we can handle them immediately instead of at the next poll.
+    SDL_sem* eventWakeSem = SDL_CreateSemaphore(0);
+    if (eventWakeSem != nullptr) {
+        SDL_AddEventWatch(Session::eventWakeWatch, eventWakeSem);
+    }
+#endif
+
     // Hijack this thread to be the SDL main thread. We have to do this
     // because we want to suspend all Qt processing until the stream is over.
     SDL_Event event;
@@ -1925,18 +2234,19 @@ void Session::exec()
             continue;
         }
 #else
-        // We explicitly use SDL_PollEvent() and SDL_Delay() because
+        // We explicitly use SDL_PollEvent() rather than SDL_WaitEvent() because
         // SDL_WaitEvent() has an internal SDL_Delay(10) inside which
         // blocks this thread too long for high polling rate mice and high
-        // refresh rate displays.
+        // refresh rate displays. Window system events still have to be polled,
+        // but events from our other threads wake us up right away.
         if (!SDL_PollEvent(&event)) {
-#ifndef STEAM_LINK
-            SDL_Delay(1);
-#else
-            // Waking every 1 ms to process input is too much for the low performance
-            // ARM core in the Steam Link, so we will wait 10 ms instead.
-            SDL_Delay(10);
-#endif
+            if (eventWakeSem == nullptr || SDL_SemWaitTimeout(eventWakeSem, k_EventPollIntervalMs) < 0) {
+                SDL_Delay(k_EventPollIntervalMs);
+            }
+            else {
+                // We'll get all pending events on the next poll
+                while (SDL_SemTryWait(eventWakeSem) == 0) {}
+            }
             runRichPresenceCallbacksIfDue();
             continue;
         }
@@ -2070,10 +2380,9 @@ void Session::exec()
 
                     windowChangeInfo.displayIndex = newDisplayIndex;
 
-                    // If the refresh rates have changed, we will need to go through the full
-                    // decoder recreation path to ensure Pacer is switched to the new display
-                    // and that we apply any V-Sync disablement rules that may be needed for
-                    // this display.
+                    // If the refresh rates have changed, we will need to recreate the renderer
+                    // to ensure Pacer is switched to the new display and that we apply any
+                    // V-Sync disablement rules that may be needed for this display.
                     SDL_DisplayMode oldMode, newMode;
                     if (SDL_GetCurrentDisplayMode(currentDisplayIndex, &oldMode) < 0 ||
                             SDL_GetCurrentDisplayMode(newDisplayIndex, &newMode) < 0 ||
@@ -2102,10 +2411,41 @@ void Session::exec()
                         event.window.data1,
                         event.window.data2);
 
+            // The decoder and the device it decodes on are unaffected by window
+            // changes, so try to rebuild only the renderer. This way, we keep our
+            // reference frames and don't have to wait for an IDR frame.
+            if (m_VideoDecoder != nullptr && resetVideoRenderer(currentDisplayIndex)) {
+                if (needsPostDecoderCreationCapture) {
+                    m_InputHandler->setCaptureActive(true);
+                    needsPostDecoderCreationCapture = false;
+                }
+                break;
+            }
+
+            // Fall through
+        case SDL_RENDER_TARGETS_RESET:
+            if (event.type == SDL_RENDER_TARGETS_RESET) {
+                // SDL pushes this when an SDL_Renderer loses its render targets.
+                // If the renderer is separate from the decoder (the SdlRenderer
+                // frontend used with the generic hwaccel backend), we can recreate
+                // just the renderer. Otherwise, recreate the whole decoder.
+                if (m_VideoDecoder == nullptr || m_FlushingWindowEventsRef > 0) {
+                    break;
+                }
+
+                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                            "Recreating renderer by internal request: %d",
+                            event.type);
+
+                if (resetVideoRenderer(currentDisplayIndex)) {
+                    break;
+                }
+            }
+
             // Fall through
         case SDL_RENDER_DEVICE_RESET:
 
-            if (event.type != SDL_WINDOWEVENT) {
+            if (event.type == SDL_RENDER_DEVICE_RESET) {
                 SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
                             "Recreating renderer by internal request: %d",
                             event.type);
@@ -2136,16 +2476,7 @@ void Session::exec()
             SDL_FlushEvent(SDL_RENDER_DEVICE_RESET);
 
             {
-                // If the stream exceeds the display refresh rate (plus some slack),
-                // forcefully disable V-sync to allow the stream to render faster
-                // than the display.
-                int displayHz = StreamUtils::getDisplayRefreshRate(m_Window);
-                bool enableVsync = m_Preferences->enableVsync;
-                if (displayHz + 5 < m_StreamConfig.fps) {
-                    SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
-                                "Disabling V-sync because refresh rate limit exceeded");
-                    enableVsync = false;
-                }
+                bool enableVsync = shouldEnableVsync();
 
                 // Choose a new decoder (hopefully the same one, but possibly
                 // not if a GPU was removed or something).
@@ -2245,6 +2576,13 @@ void Session::exec()
     }
 
 DispatchDeferredCleanup:
+#if !SDL_VERSION_ATLEAST(2, 0, 18) || defined(STEAM_LINK)
+    if (eventWakeSem != nullptr) {
+        SDL_DelEventWatch(Session::eventWakeWatch, eventWakeSem);
+        SDL_DestroySemaphore(eventWakeSem);
+    }
+#endif
+
     // Switch back to synchronous logging mode
     StreamUtils::exitAsyncLoggingMode();
 
@@ -2260,12 +2598,19 @@ DispatchDeferredCleanup:
     // Raise any keys that are still down
     m_InputHandler->raiseAllKeys();
 
+    m_InputRecorder.stop();
+
     // Destroy the input handler now. This must be destroyed
     // before allowwing the UI to continue execution or it could
     // interfere with SDLGamepadKeyNavigation.
     delete m_InputHandler;
     m_InputHandler = nullptr;
 
+    // All input has been sent now
+    m_InputLatencyStats.logGlobalStats();
+
+    StartupProfiler::get()->finish(getStartupProfileInfo());
+
     // Destroy the decoder, since this must be done on the main thread
     // NB: This must happen before LiStopConnection() for pull-based
     // decoders.
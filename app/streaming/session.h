@@ -1,5 +1,6 @@
 #pragma once
 
+#include <QJsonObject>
 #include <QSemaphore>
 #include <QQuickWindow>
 
@@ -7,6 +8,7 @@
 #include <opus_multistream.h>
 #include "settings/streamingpreferences.h"
 #include "input/input.h"
+#include "input/recorder.h"
 #include "video/decoder.h"
 #include "audio/renderers/renderer.h"
 #include "video/overlaymanager.h"
@@ -111,6 +113,12 @@ public:
                         bool& isHardwareAccelerated, bool& isFullScreenOnly,
                         bool& isHdrSupported, QSize& maxResolution);
 
+    // Measures the Opus decoder in the background, so the result is ready
+    // before isOpusDecoderSlow() is called for a stream. This must only be
+    // called while we're not streaming.
+    static
+    void startOpusDecoderSpeedTest();
+
     static Session* get()
     {
         return s_ActiveSession;
@@ -128,6 +136,12 @@ SdlInputHandler* getInputHandler()
 
 void flushWindowEvents();
 
+    // Appends the most recent audio stats window to the overlay text
+    void appendAudioStats(char* output, int length);
+
+    // Appends input latency since the last overlay update to the overlay text
+    void appendInputStats(char* output, int length);
+
     void setShouldExit(bool quitHostApp = false);
 
     void syncClipboardToServer();
@@ -154,8 +168,16 @@ signals:
 private:
     void exec();
 
+    SDL_Window* createWindow(Uint32 flags);
+
+    QJsonObject getStartupProfileInfo();
+
     bool startConnectionAsync();
 
+    void prewarmDecoder();
+
+    bool isPrewarmedDecoderUsable();
+
     bool validateLaunch(SDL_Window* testWindow);
 
     void emitLaunchWarning(QString text);
@@ -170,6 +192,17 @@ private:
 
     int getAudioRendererCapabilities(int audioConfiguration);
 
+    static
+    bool isOpusDecoderSlow(int audioConfiguration);
+
+    void addAudioStats(AUDIO_STATS& src, AUDIO_STATS& dst);
+
+    void stringifyAudioStats(AUDIO_STATS& stats, char* output, int length);
+
+    void logAudioStats(AUDIO_STATS& stats, const char* title);
+
+    void flipAudioStatsWindow();
+
     void getWindowDimensions(int& x, int& y,
                              int& width, int& height);
 
@@ -177,8 +210,15 @@ private:
 
     void notifyMouseEmulationMode(bool enabled);
 
+    static
+    int SDLCALL eventWakeWatch(void* userdata, SDL_Event* event);
+
     void updateOptimalWindowDisplayMode();
 
+    bool shouldEnableVsync();
+
+    bool resetVideoRenderer(int& currentDisplayIndex);
+
     enum class DecoderAvailability {
         None,
         Software,
@@ -195,11 +235,15 @@ private:
                        SDL_Window* window, int videoFormat, int width, int height,
                        int frameRate, bool enableVsync, bool enableFramePacing,
                        bool testOnly,
-                       IVideoDecoder*& chosenDecoder);
+                       IVideoDecoder*& chosenDecoder,
+                       bool prewarm = false);
 
     static
     void clStageStarting(int stage);
 
+    static
+    void clStageComplete(int stage);
+
     static
     void clStageFailed(int stage, int errorCode);
 
@@ -260,6 +304,7 @@ private:
     NvApp m_App;
     SDL_Window* m_Window;
     IVideoDecoder* m_VideoDecoder;
+    IVideoDecoder* m_PrewarmedDecoder;
     SDL_mutex* m_DecoderLock;
     bool m_AudioDisabled;
     bool m_AudioMuted;
@@ -267,8 +312,11 @@ private:
     QQuickWindow* m_QtWindow;
     bool m_UnexpectedTermination;
     SdlInputHandler* m_InputHandler;
+    InputLatencyStats m_InputLatencyStats;
+    InputRecorder m_InputRecorder;
     int m_MouseEmulationRefCount;
     int m_FlushingWindowEventsRef;
+    int m_ConnectionStagePhase;
     QStringList m_LaunchWarnings;
     bool m_ShouldExit;
 
@@ -286,6 +334,10 @@ private:
     OPUS_MULTISTREAM_CONFIGURATION m_OriginalAudioConfig;
     int m_AudioSampleCount;
     Uint32 m_DropAudioEndTime;
+    AUDIO_STATS m_ActiveWndAudioStats;
+    AUDIO_STATS m_LastWndAudioStats;
+    AUDIO_STATS m_GlobalAudioStats;
+    SDL_SpinLock m_AudioStatsLock;
 
     Overlay::OverlayManager m_OverlayManager;
 
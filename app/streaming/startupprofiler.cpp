@@ -0,0 +1,207 @@
+#include "startupprofiler.h"
+
+#include <Limelight.h>
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QVector>
+
+#include <algorithm>
+
+StartupProfiler StartupProfiler::s_Profiler;
+
+StartupProfiler*
+StartupProfiler::get()
+{
+    return &s_Profiler;
+}
+
+StartupProfiler::StartupProfiler()
+    : m_Lock(0),
+      m_Active(false),
+      m_StartUs(0),
+      m_PhaseCount(0)
+{
+    SDL_AtomicSet(&m_PendingMilestones, 0);
+    SDL_zero(m_Phases);
+    SDL_zero(m_MilestoneUs);
+}
+
+void StartupProfiler::start()
+{
+    SDL_AtomicLock(&m_Lock);
+    m_Active = true;
+    m_StartUs = LiGetMicroseconds();
+    m_PhaseCount = 0;
+    SDL_zero(m_MilestoneUs);
+    SDL_AtomicSet(&m_PendingMilestones, (1 << StartupMilestoneMax) - 1);
+    SDL_AtomicUnlock(&m_Lock);
+}
+
+int StartupProfiler::beginPhase(const char* format, ...)
+{
+    char name[STARTUP_PROFILER_MAX_NAME];
+    va_list va;
+    int phase;
+
+    va_start(va, format);
+    SDL_vsnprintf(name, sizeof(name), format, va);
+    va_end(va);
+
+    SDL_AtomicLock(&m_Lock);
+    if (!m_Active || m_PhaseCount == STARTUP_PROFILER_MAX_PHASES) {
+        SDL_AtomicUnlock(&m_Lock);
+        return -1;
+    }
+
+    phase = m_PhaseCount++;
+    SDL_strlcpy(m_Phases[phase].name, name, sizeof(m_Phases[phase].name));
+    m_Phases[phase].startUs = LiGetMicroseconds();
+    m_Phases[phase].endUs = 0;
+    m_Phases[phase].ended = false;
+    m_Phases[phase].success = false;
+    SDL_AtomicUnlock(&m_Lock);
+
+    return phase;
+}
+
+void StartupProfiler::endPhase(int phase, bool success)
+{
+    if (phase < 0) {
+        return;
+    }
+
+    SDL_AtomicLock(&m_Lock);
+
+    // The phase may have been discarded by a new timeline
+    if (m_Active && phase < m_PhaseCount && !m_Phases[phase].ended) {
+        m_Phases[phase].endUs = LiGetMicroseconds();
+        m_Phases[phase].ended = true;
+        m_Phases[phase].success = success;
+    }
+
+    SDL_AtomicUnlock(&m_Lock);
+}
+
+void StartupProfiler::markMilestone(StartupMilestone milestone)
+{
+    // Avoid taking the lock on every frame after we've seen the first one
+    if (!(SDL_AtomicGet(&m_PendingMilestones) & (1 << milestone))) {
+        return;
+    }
+
+    SDL_AtomicLock(&m_Lock);
+    if (SDL_AtomicGet(&m_PendingMilestones) & (1 << milestone)) {
+        m_MilestoneUs[milestone] = LiGetMicroseconds();
+        SDL_AtomicSet(&m_PendingMilestones, SDL_AtomicGet(&m_PendingMilestones) & ~(1 << milestone));
+    }
+    SDL_AtomicUnlock(&m_Lock);
+}
+
+const char* StartupProfiler::getMilestoneName(int milestone)
+{
+    switch (milestone) {
+    case StartupMilestoneFirstDecodeUnit:
+        return "First decode unit";
+    case StartupMilestoneFirstDecodedFrame:
+        return "First decoded frame";
+    case StartupMilestoneFirstPresentedFrame:
+        return "First presented frame";
+    default:
+        return "Unknown";
+    }
+}
+
+void StartupProfiler::finish(const QJsonObject& sessionInfo)
+{
+    SDL_AtomicLock(&m_Lock);
+    if (!m_Active) {
+        SDL_AtomicUnlock(&m_Lock);
+        return;
+    }
+
+    // Take a snapshot so we don't log while holding the lock
+    m_Active = false;
+    SDL_AtomicSet(&m_PendingMilestones, 0);
+    QVector<PHASE> phases(m_Phases, m_Phases + m_PhaseCount);
+    for (int i = 0; i < StartupMilestoneMax; i++) {
+        if (m_MilestoneUs[i] != 0) {
+            PHASE milestone = {};
+            SDL_strlcpy(milestone.name, getMilestoneName(i), sizeof(milestone.name));
+            milestone.startUs = milestone.endUs = m_MilestoneUs[i];
+            milestone.ended = milestone.success = true;
+            phases.append(milestone);
+        }
+    }
+    uint64_t startUs = m_StartUs;
+    SDL_AtomicUnlock(&m_Lock);
+
+    // Phases are recorded from several threads, so they may be out of order
+    std::stable_sort(phases.begin(), phases.end(),
+                     [](const PHASE& a, const PHASE& b) {
+                         return a.startUs < b.startUs;
+                     });
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Startup timeline:");
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "%12s %12s  %-7s %s",
+                "Start (ms)", "Time (ms)", "Result", "Phase");
+    for (const PHASE& phase : phases) {
+        char duration[32];
+
+        if (!phase.ended) {
+            SDL_strlcpy(duration, "-", sizeof(duration));
+        }
+        else if (phase.endUs == phase.startUs) {
+            // Milestones have no duration
+            duration[0] = 0;
+        }
+        else {
+            SDL_snprintf(duration, sizeof(duration), "%.1f", (phase.endUs - phase.startUs) / 1000.0);
+        }
+
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "%12.1f %12s  %-7s %s",
+                    (phase.startUs - startUs) / 1000.0,
+                    duration,
+                    !phase.ended ? "Pending" : (phase.success ? "OK" : "Failed"),
+                    phase.name);
+    }
+
+    QString fileName = qgetenv("ML_STARTUP_PROFILE_FILE");
+    if (!fileName.isEmpty()) {
+        QJsonObject timeline = sessionInfo;
+        QJsonArray phaseArray;
+
+        for (const PHASE& phase : phases) {
+            QJsonObject phaseObject;
+
+            phaseObject["name"] = phase.name;
+            phaseObject["startMs"] = (phase.startUs - startUs) / 1000.0;
+            if (phase.ended) {
+                phaseObject["durationMs"] = (phase.endUs - phase.startUs) / 1000.0;
+                phaseObject["success"] = phase.success;
+            }
+
+            phaseArray.append(phaseObject);
+        }
+
+        timeline["phases"] = phaseArray;
+        writeJson(fileName, timeline);
+    }
+}
+
+void StartupProfiler::writeJson(const QString& fileName, const QJsonObject& timeline)
+{
+    // Each session is appended as one line, so timelines from many
+    // builds and hosts can be collected in the same file.
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                    "Failed to open startup profile file: %s",
+                    qPrintable(file.errorString()));
+        return;
+    }
+
+    file.write(QJsonDocument(timeline).toJson(QJsonDocument::Compact));
+    file.write("\n");
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "SDL_compat.h"
+
+#include <QJsonObject>
+
+#define STARTUP_PROFILER_MAX_PHASES 128
+#define STARTUP_PROFILER_MAX_NAME 64
+
+enum StartupMilestone {
+    StartupMilestoneFirstDecodeUnit,
+    StartupMilestoneFirstDecodedFrame,
+    StartupMilestoneFirstPresentedFrame,
+    StartupMilestoneMax
+};
+
+// Records a timeline of everything that happens between the user launching
+// a stream and the first frame reaching the screen, so regressions in
+// time-to-first-frame can be tracked down to the phase responsible.
+//
+// Phases and milestones may be recorded from any thread. Milestones
+// are checked on every frame, so they're cheap once they've been hit.
+class StartupProfiler
+{
+public:
+    static
+    StartupProfiler*
+    get();
+
+    // Starts a new timeline, discarding the previous one
+    void start();
+
+    // Returns a handle for endPhase(), or -1 if we aren't profiling
+    int beginPhase(const char* format, ...);
+
+    void endPhase(int phase, bool success = true);
+
+    // Records only the first occurrence of each milestone
+    void markMilestone(StartupMilestone milestone);
+
+    // Logs the timeline and stops profiling. If ML_STARTUP_PROFILE_FILE
+    // is set, it's also appended to that file as a line of JSON along
+    // with the provided information about the session.
+    void finish(const QJsonObject& sessionInfo);
+
+private:
+    StartupProfiler();
+
+    typedef struct _PHASE {
+        char name[STARTUP_PROFILER_MAX_NAME];
+        uint64_t startUs;
+        uint64_t endUs;
+        bool ended;
+        bool success;
+    } PHASE, *PPHASE;
+
+    static
+    const char* getMilestoneName(int milestone);
+
+    void writeJson(const QString& fileName, const QJsonObject& timeline);
+
+    SDL_SpinLock m_Lock;
+    SDL_atomic_t m_PendingMilestones;
+    bool m_Active;
+    uint64_t m_StartUs;
+    int m_PhaseCount;
+    PHASE m_Phases[STARTUP_PROFILER_MAX_PHASES];
+    uint64_t m_MilestoneUs[StartupMilestoneMax];
+
+    static StartupProfiler s_Profiler;
+};
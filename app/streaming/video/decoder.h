@@ -44,6 +44,10 @@ typedef struct _DECODER_PARAMETERS {
     bool enableVsync;
     bool enableFramePacing;
     bool testOnly;
+
+    // The decoder is being created before the connection is established,
+    // so it must not use the stream until startPrewarmed() is called.
+    bool prewarm;
 } DECODER_PARAMETERS, *PDECODER_PARAMETERS;
 
 #define WINDOW_STATE_CHANGE_SIZE 0x01
@@ -76,4 +80,13 @@ public:
     virtual void renderFrameOnMainThread() = 0;
     virtual void setHdrMode(bool enabled) = 0;
     virtual bool notifyWindowChanged(PWINDOW_STATE_CHANGE_INFO info) = 0;
+
+    // Rebuilds only what presents decoded frames to the window, keeping the decoder
+    // and its reference frames. Returns false if this isn't possible, in which
+    // case the decoder may be unable to render and must be destroyed.
+    virtual bool resetRenderer(PDECODER_PARAMETERS params) = 0;
+
+    // Starts decoding with a decoder initialized with DECODER_PARAMETERS::prewarm.
+    // This must not be called until LiStartConnection() has succeeded.
+    virtual bool startPrewarmed() = 0;
 };
@@ -1,5 +1,6 @@
 #include "pacer.h"
 #include "streaming/streamutils.h"
+#include "streaming/startupprofiler.h"
 
 #include <SDL_syswm.h>
 
@@ -30,7 +31,7 @@ Pacer::Pacer(IFFmpegRenderer* renderer, PVIDEO_STATS videoStats) :
     m_DisplayFps(0),
     m_VideoStats(videoStats)
 {
-
+    SDL_AtomicSet(&m_FrameReadyEventPending, 0);
 }
 
 Pacer::~Pacer()
@@ -78,8 +79,24 @@ void Pacer::renderOnMainThread()
         return;
     }
 
+    // Frames queued after this point will push a new frame ready event
+    SDL_AtomicSet(&m_FrameReadyEventPending, 0);
+
     m_FrameQueueLock.lock();
 
+    // If several frames arrived since the last render, only the newest
+    // one is worth rendering. The main thread would just fall further
+    // behind by rendering each of them in turn.
+    while (m_RenderQueue.count() > 1) {
+        AVFrame* frame = m_RenderQueue.dequeue();
+
+        // Drop the lock while we call av_frame_free()
+        m_FrameQueueLock.unlock();
+        m_VideoStats->pacerDroppedFrames++;
+        av_frame_free(&frame);
+        m_FrameQueueLock.lock();
+    }
+
     if (!m_RenderQueue.isEmpty()) {
         AVFrame* frame = m_RenderQueue.dequeue();
         m_FrameQueueLock.unlock();
@@ -176,13 +193,18 @@ void Pacer::enqueueFrameForRenderingAndUnlock(AVFrame *frame)
     if (m_RenderThread != nullptr) {
         m_RenderQueueNotEmpty.wakeOne();
     }
-    else {
+    else if (SDL_AtomicCAS(&m_FrameReadyEventPending, 0, 1)) {
         SDL_Event event;
 
-        // For main thread rendering, we'll push an event to trigger a callback
+        // For main thread rendering, we'll push an event to trigger a callback.
+        // Only one is kept pending at a time, since each one renders the newest
+        // frame in the queue.
         event.type = SDL_USEREVENT;
         event.user.code = SDL_CODE_FRAME_READY;
-        SDL_PushEvent(&event);
+        if (SDL_PushEvent(&event) <= 0) {
+            // Let the next frame try again
+            SDL_AtomicSet(&m_FrameReadyEventPending, 0);
+        }
     }
 }
 
@@ -314,6 +336,8 @@ void Pacer::renderFrame(AVFrame* frame)
     m_VsyncRenderer->renderFrame(frame);
     uint64_t afterRender = LiGetMicroseconds();
 
+    StartupProfiler::get()->markMilestone(StartupMilestoneFirstPresentedFrame);
+
     m_VideoStats->totalRenderTimeUs += (afterRender - beforeRender);
     m_VideoStats->renderedFrames++;
 
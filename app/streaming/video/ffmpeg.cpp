@@ -2,6 +2,7 @@
 #include "ffmpeg.h"
 #include "utils.h"
 #include "streaming/session.h"
+#include "streaming/startupprofiler.h"
 
 #include <QtGlobal>
 #include <QString>
@@ -59,6 +60,65 @@ bool FFmpegVideoDecoder::notifyWindowChanged(PWINDOW_STATE_CHANGE_INFO info)
     return m_FrontendRenderer->notifyWindowChanged(info);
 }
 
+bool FFmpegVideoDecoder::resetRenderer(PDECODER_PARAMETERS params)
+{
+    // When the backend renders directly, it owns both the hardware device
+    // and the swapchain, so there's nothing we can rebuild separately.
+    if (m_FrontendRenderer == m_BackendRenderer || m_CurrentTestMode == TestMode::TestFrameOnly) {
+        return false;
+    }
+
+    // The decoder thread submits frames to Pacer, so it must be stopped first.
+    // The codec context and the backend renderer's device stay alive, so the
+    // reference frames survive and we won't need an IDR frame to recover.
+    bool decoderThreadStarted = m_DecoderThread != nullptr;
+    stopDecoderThread();
+
+    delete m_Pacer;
+    m_Pacer = nullptr;
+
+    Session::get()->getOverlayManager().setOverlayRenderer(nullptr);
+
+    delete m_FrontendRenderer;
+    m_FrontendRenderer = nullptr;
+
+    if (createFrontendRenderer(params, m_UseAlternateFrontend) && m_FrontendRenderer != m_BackendRenderer) {
+        m_Pacer = new Pacer(m_FrontendRenderer, &m_ActiveWndVideoStats);
+        if (m_Pacer->initialize(params->window, params->frameRate,
+                                params->enableFramePacing || (params->enableVsync && (m_FrontendRenderer->getRendererAttributes() & RENDERER_ATTRIBUTE_FORCE_PACING)))) {
+            Session::get()->getOverlayManager().setOverlayRenderer(m_FrontendRenderer);
+            m_FrontendRenderer->prepareToRender();
+
+            if (!decoderThreadStarted || startDecoderThread()) {
+                SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+                            "Recreated '%s' renderer without resetting '%s' decoder",
+                            m_FrontendRenderer->getRendererName(),
+                            m_BackendRenderer->getRendererName());
+                return true;
+            }
+        }
+    }
+
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "Failed to recreate renderer. Resetting decoder.");
+
+    // Tear down whatever we managed to build. We can't render anymore,
+    // so the caller must destroy this decoder before using it again.
+    stopDecoderThread();
+
+    delete m_Pacer;
+    m_Pacer = nullptr;
+
+    Session::get()->getOverlayManager().setOverlayRenderer(nullptr);
+
+    if (m_FrontendRenderer != m_BackendRenderer) {
+        delete m_FrontendRenderer;
+    }
+    m_FrontendRenderer = nullptr;
+
+    return false;
+}
+
 int FFmpegVideoDecoder::getDecoderCapabilities()
 {
     int capabilities;
@@ -199,6 +259,7 @@ FFmpegVideoDecoder::FFmpegVideoDecoder(bool testOnly)
       m_HwDecodeCfg(nullptr),
       m_BackendRenderer(nullptr),
       m_FrontendRenderer(nullptr),
+      m_UseAlternateFrontend(false),
       m_ConsecutiveFailedDecodes(0),
       m_Pacer(nullptr),
       m_BwTracker(10, 250),
@@ -237,10 +298,28 @@ IFFmpegRenderer* FFmpegVideoDecoder::getBackendRenderer()
     return m_BackendRenderer;
 }
 
-void FFmpegVideoDecoder::reset()
+bool FFmpegVideoDecoder::startPrewarmed()
+{
+    SDL_assert(m_CurrentTestMode != TestMode::TestFrameOnly);
+    return m_DecoderThread != nullptr || startDecoderThread();
+}
+
+bool FFmpegVideoDecoder::startDecoderThread()
+{
+    SDL_assert(m_DecoderThread == nullptr);
+
+    m_DecoderThread = SDL_CreateThread(FFmpegVideoDecoder::decoderThreadProcThunk, "FFDecoder", (void*)this);
+    if (m_DecoderThread == nullptr) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "Failed to create decoder thread: %s", SDL_GetError());
+        return false;
+    }
+
+    return true;
+}
+
+void FFmpegVideoDecoder::stopDecoderThread()
 {
-    // Terminate the decoder thread before doing anything else.
-    // It might be touching things we're about to free.
     if (m_DecoderThread != nullptr) {
         SDL_AtomicSet(&m_DecoderThreadShouldQuit, 1);
         LiWakeWaitForVideoFrame();
@@ -248,6 +327,13 @@ void FFmpegVideoDecoder::reset()
         SDL_AtomicSet(&m_DecoderThreadShouldQuit, 0);
         m_DecoderThread = nullptr;
     }
+}
+
+void FFmpegVideoDecoder::reset()
+{
+    // Terminate the decoder thread before doing anything else.
+    // It might be touching things we're about to free.
+    stopDecoderThread();
 
     m_FramesIn = m_FramesOut = 0;
     m_FrameInfoQueue.clear();
@@ -395,6 +481,7 @@ bool FFmpegVideoDecoder::completeInitialization(const AVCodec* decoder, enum AVP
         return false;
     }
 
+    m_UseAlternateFrontend = useAlternateFrontend;
     m_RequiredPixelFormat = requiredFormat;
     m_OriginalVideoWidth = params->width;
     m_OriginalVideoHeight = params->height;
@@ -645,11 +732,9 @@ bool FFmpegVideoDecoder::completeInitialization(const AVCodec* decoder, enum AVP
         m_FrontendRenderer->prepareToRender();
 
         // Only create the decoder thread when instantiating the decoder for real. It will use APIs from
-        // moonlight-common-c that can only be legally called with an established connection.
-        m_DecoderThread = SDL_CreateThread(FFmpegVideoDecoder::decoderThreadProcThunk, "FFDecoder", (void*)this);
-        if (m_DecoderThread == nullptr) {
-            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
-                         "Failed to create decoder thread: %s", SDL_GetError());
+        // moonlight-common-c that can only be legally called with an established connection, so
+        // pre-warmed decoders wait for startPrewarmed() to create it.
+        if (!params->prewarm && !startDecoderThread()) {
             return false;
         }
 
@@ -1649,6 +1734,8 @@ void FFmpegVideoDecoder::decoderThreadProc()
             do {
                 err = avcodec_receive_frame(m_VideoDecoderCtx, frame);
                 if (err == 0) {
+                    StartupProfiler::get()->markMilestone(StartupMilestoneFirstDecodedFrame);
+
                     SDL_assert(m_FrameInfoQueue.size() == m_FramesIn - m_FramesOut);
                     m_FramesOut++;
 
@@ -1798,6 +1885,8 @@ int FFmpegVideoDecoder::submitDecodeUnit(PDECODE_UNIT du)
 
     SDL_assert(m_CurrentTestMode != TestMode::TestFrameOnly);
 
+    StartupProfiler::get()->markMilestone(StartupMilestoneFirstDecodeUnit);
+
     // If this is the first frame, reject anything that's not an IDR frame
     if (m_FramesIn == 0 && du->frameType != FRAME_TYPE_IDR) {
         return DR_NEED_IDR;
@@ -1827,6 +1916,12 @@ int FFmpegVideoDecoder::submitDecodeUnit(PDECODE_UNIT du)
             stringifyVideoStats(lastTwoWndStats,
                                 Session::get()->getOverlayManager().getOverlayText(Overlay::OverlayDebug),
                                 Session::get()->getOverlayManager().getOverlayMaxTextLength());
+
+            // Display the audio stats below the video stats
+            Session::get()->appendAudioStats(Session::get()->getOverlayManager().getOverlayText(Overlay::OverlayDebug),
+                                             Session::get()->getOverlayManager().getOverlayMaxTextLength());
+            Session::get()->appendInputStats(Session::get()->getOverlayManager().getOverlayText(Overlay::OverlayDebug),
+                                             Session::get()->getOverlayManager().getOverlayMaxTextLength());
             Session::get()->getOverlayManager().setOverlayTextUpdated(Overlay::OverlayDebug);
         }
 
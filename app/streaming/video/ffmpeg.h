@@ -29,6 +29,8 @@ public:
     virtual void renderFrameOnMainThread() override;
     virtual void setHdrMode(bool enabled) override;
     virtual bool notifyWindowChanged(PWINDOW_STATE_CHANGE_INFO info) override;
+    virtual bool resetRenderer(PDECODER_PARAMETERS params) override;
+    virtual bool startPrewarmed() override;
 
     virtual IFFmpegRenderer* getBackendRenderer();
 
@@ -94,6 +96,10 @@ private:
 
     void reset();
 
+    bool startDecoderThread();
+
+    void stopDecoderThread();
+
     void writeBuffer(PLENTRY entry, int& offset);
 
     static
@@ -111,6 +117,7 @@ private:
     const AVCodecHWConfig* m_HwDecodeCfg;
     IFFmpegRenderer* m_BackendRenderer;
     IFFmpegRenderer* m_FrontendRenderer;
+    bool m_UseAlternateFrontend;
     int m_ConsecutiveFailedDecodes;
     Pacer* m_Pacer;
     BandwidthTracker m_BwTracker;
@@ -1,5 +1,6 @@
 #include "slvid.h"
 #include "streaming/session.h"
+#include "streaming/startupprofiler.h"
 
 SLVideoDecoder::SLVideoDecoder(bool)
     : m_VideoContext(nullptr),
@@ -126,6 +127,8 @@ SLVideoDecoder::submitDecodeUnit(PDECODE_UNIT du)
 {
     int err;
 
+    StartupProfiler::get()->markMilestone(StartupMilestoneFirstDecodeUnit);
+
     err = SLVideo_BeginFrame(m_VideoStream, du->fullLength);
     if (err < 0) {
         SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
@@ -166,6 +169,9 @@ SLVideoDecoder::submitDecodeUnit(PDECODE_UNIT du)
         return DR_NEED_IDR;
     }
 
+    // SLVideo decodes and displays the frame itself, so this is as close as we can get
+    StartupProfiler::get()->markMilestone(StartupMilestoneFirstPresentedFrame);
+
     return DR_OK;
 }
 
@@ -34,6 +34,16 @@ public:
         return false;
     }
 
+    // SLVideo renders directly from the decoder
+    virtual bool resetRenderer(PDECODER_PARAMETERS) override {
+        return false;
+    }
+
+    // Decode units are pushed to us, so there's nothing to start
+    virtual bool startPrewarmed() override {
+        return true;
+    }
+
 private:
     static void slLogCallback(void* context, ESLVideoLog logLevel, const char* message);
 